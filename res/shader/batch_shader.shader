@@ -0,0 +1,40 @@
+#shader vertex
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in float aDrawID; // BatchRenderer: the command's base instance, see BatchRenderer.h
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out vec3 Color;
+
+uniform samplerBuffer u_DrawData; // Five texels per draw: the model matrix columns, then the color
+uniform int u_DrawIdOffset;       // Draw id when there are no base instances, 0 otherwise
+#include "include/frame_data.glsl"
+
+void main() {
+    int record = (int(aDrawID) + u_DrawIdOffset) * 5;
+    mat4 model = mat4(texelFetch(u_DrawData, record), texelFetch(u_DrawData, record + 1),
+                      texelFetch(u_DrawData, record + 2), texelFetch(u_DrawData, record + 3));
+    Color = texelFetch(u_DrawData, record + 4).rgb;
+
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    // Transforms are rotation, translation and uniform scale, like the INSTANCING variant of model_shader
+    Normal = mat3(model) * aNormal;
+    gl_Position = u_Projection * u_View * vec4(FragPos, 1.0);
+}
+
+#shader fragment
+#version 330 core
+in vec3 FragPos;
+in vec3 Normal;
+flat in vec3 Color;
+
+out vec4 FragColor;
+
+#include "include/lighting.glsl"
+
+void main() {
+    FragColor = vec4(Lambert(FragPos, normalize(Normal)) * Color, 1.0);
+}
@@ -0,0 +1,7 @@
+// Per frame, RenderQueue::SetFrame (FrameUniforms in UniformBuffer.h)
+layout (std140) uniform FrameData {
+    mat4 u_View;
+    mat4 u_Projection;
+    vec4 u_LightPosition;
+    vec4 u_LightColor;
+};
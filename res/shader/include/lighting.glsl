@@ -0,0 +1,10 @@
+#include "frame_data.glsl"
+
+// Ambient and diffuse light from u_LightPosition, normal has to be normalized
+vec3 Lambert(vec3 position, vec3 normal) {
+    vec3 lightDir = normalize(u_LightPosition.xyz - position);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = diff * u_LightColor.xyz;
+    vec3 ambient = vec3(0.25) * u_LightColor.xyz;
+    return ambient + diffuse;
+}
@@ -0,0 +1,7 @@
+// Per draw, RenderQueue::Command::Object (ObjectUniforms in UniformBuffer.h)
+layout (std140) uniform ObjectData {
+    mat4 u_Model;
+    // Packed meshes store positions on a grid over their bounds (see PackedVertex), float meshes pass the identity
+    vec4 u_PositionScale;
+    vec4 u_PositionOffset;
+};
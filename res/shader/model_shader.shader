@@ -1,42 +1,64 @@
+// INSTANCING: per instance transforms in aInstanceModel (InstanceBuffer), applied after u_Model
+// FLAT_SHADING: one normal per triangle from the screen space derivatives, skips the vertex normals
+#keyword INSTANCING FLAT_SHADING
+
 #shader vertex
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+#ifdef INSTANCING
+layout (location = 3) in mat4 aInstanceModel; // Per instance, takes locations 3 to 6
+#endif
 
 out vec3 FragPos;
+#ifndef FLAT_SHADING
 out vec3 Normal;
+#endif
 
-uniform mat4 u_Model;
-uniform mat4 u_View;
-uniform mat4 u_Projection;
+#include "include/frame_data.glsl"
+#include "include/object_data.glsl"
 
 void main() {
-    FragPos = vec3(u_Model * vec4(aPos, 1.0));
+    vec3 position = aPos * u_PositionScale.xyz + u_PositionOffset.xyz;
+#ifdef INSTANCING
+    mat4 model = aInstanceModel * u_Model;
+    FragPos = vec3(model * vec4(position, 1.0));
+#ifndef FLAT_SHADING
+    // Instance transforms are rotation, translation and uniform scale, so the upper 3x3 keeps normals
+    // perpendicular and saves an inverse per vertex. The fragment shader normalizes them.
+    Normal = mat3(model) * aNormal;
+#endif
+    gl_Position = u_Projection * u_View * vec4(FragPos, 1.0);
+#else
+    FragPos = vec3(u_Model * vec4(position, 1.0));
+#ifndef FLAT_SHADING
     Normal = mat3(transpose(inverse(u_Model))) * aNormal;  // Transform normal correctly
-    gl_Position = u_Projection * u_View * u_Model * vec4(aPos, 1.0);
+#endif
+    gl_Position = u_Projection * u_View * u_Model * vec4(position, 1.0);
+#endif
 }
 
 #shader fragment
 #version 330 core
 in vec3 FragPos;
+#ifndef FLAT_SHADING
 in vec3 Normal;
+#endif
 
 out vec4 FragColor;
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
+#include "include/lighting.glsl"
 uniform vec3 objectColor;
 
 void main() {
+#ifdef FLAT_SHADING
+    vec3 norm = normalize(cross(dFdx(FragPos), dFdy(FragPos)));
+#else
     vec3 norm = normalize(Normal);  // Use face normal
-    vec3 lightDir = normalize(lightPos - FragPos);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor * 1.0;
-    vec3 ambient = vec3(0.25) * lightColor;
-
-    vec3 finalColor = (ambient + diffuse) * objectColor; 
+#endif
+    vec3 finalColor = Lambert(FragPos, norm) * objectColor;
     //finalColor = pow(finalColor, vec3(1.0 / 2.2)); // Apply gamma correction
 
     FragColor = vec4(finalColor, 1.0);
-}
\ No newline at end of file
+}
@@ -7,7 +7,7 @@
 #include <string>
 #include <tuple>
 #include <map>
-#include <Windows.h>
+#include <cstring>
 
 #include "Renderer.h"
 #include "VertexBuffer.h"
@@ -17,6 +17,10 @@
 #include "Shader.h"
 #include "Texture.h"
 #include "MouseInput.h"
+#include "HeadlessRunner.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "AssetWatcher.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -31,6 +35,11 @@
 #include "tests/TestTriangle.h"
 #include "tests/TestShaderToy.h"
 #include "tests/TestModelLoading.h"
+#include "tests/TestOBJLoaderBenchmark.h"
+#include "tests/TestInstancing.h"
+#include "tests/TestBatchRenderer.h"
+#include "tests/TestVertexStreaming.h"
+#include "tests/TestMeshletCulling.h"
 
 
 void ShowDockSpaces()
@@ -72,6 +81,8 @@ void ShowDockSpaces()
         // Dock windows in correct areas
         ImGui::DockBuilderDockWindow("Test", dock_right);
         ImGui::DockBuilderDockWindow("Scene", dock_main);
+        ImGui::DockBuilderDockWindow("Profiler", dock_bottom);
+        ImGui::DockBuilderDockWindow("Hot Reload", dock_bottom);
 
         // Optional: Hide tab bar if only one window in the dock
         ImGui::DockBuilderGetNode(dock_main)->LocalFlags |= ImGuiDockNodeFlags_AutoHideTabBar;
@@ -106,7 +117,7 @@ bool UpdateUIScaling(float scale)
     style.TabRounding = 0.0f;
 
     style.ScaleAllSizes(scale);
-    CopyMemory(style.Colors, styleold.Colors, sizeof(style.Colors)); // Restore colors (needs Windows.h)
+    std::memcpy(style.Colors, styleold.Colors, sizeof(style.Colors)); // Restore colors
 
     io.Fonts->Clear();
 
@@ -163,8 +174,34 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
 
 
 
-int main(void)
+void RegisterTests(test::TestMenu& testMenu)
 {
+    testMenu.RegisterTest<test::TestClearColor>("Clear Color");
+    testMenu.RegisterTest<test::TestTexture2D>("2D Texture");
+    testMenu.RegisterTest<test::TestTriangle>("Triangle");
+    testMenu.RegisterTest<test::TestShaderToy>("ShaderToy");
+    testMenu.RegisterTest<test::TestModelLoading>("Test Model Loading");
+    testMenu.RegisterTest<test::TestOBJLoaderBenchmark>("OBJ Loader Benchmark");
+    testMenu.RegisterTest<test::TestInstancing>("Instancing Stress");
+    testMenu.RegisterTest<test::TestBatchRenderer>("Batch Renderer");
+    testMenu.RegisterTest("Vertex Streaming (persistent)", []() -> test::Test* { return new test::TestVertexStreaming(test::TestVertexStreaming::Method::PersistentRing); });
+    testMenu.RegisterTest("Vertex Streaming (orphaning)", []() -> test::Test* { return new test::TestVertexStreaming(test::TestVertexStreaming::Method::Orphaning); });
+    testMenu.RegisterTest("Vertex Streaming (glBufferData)", []() -> test::Test* { return new test::TestVertexStreaming(test::TestVertexStreaming::Method::BufferData); });
+    testMenu.RegisterTest<test::TestMeshletCulling>("Meshlet Culling");
+}
+
+
+int main(int argc, char** argv)
+{
+    // Offscreen run of a single test, no window (see HeadlessRunner::PrintUsage)
+    if (HeadlessRunner::IsRequested(argc, argv))
+    {
+        HeadlessOptions options;
+        if (!HeadlessRunner::ParseArguments(argc, argv, options))
+            return 1;
+        return HeadlessRunner::Run(options, RegisterTests);
+    }
+
     GLFWwindow* window;
 
     /* Initialize the library */
@@ -177,6 +214,10 @@ int main(void)
     glfwWindowHint(GLFW_SAMPLES, 4); //Request 4x antialiasing  
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  
 
+    const bool synchronousGLErrors = GLDebug::IsSynchronousRequested(argc, argv);
+    if (synchronousGLErrors)
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE); // Debug contexts are guaranteed to report everything
+
     /* Create a windowed mode window and its OpenGL context */
 
     int width = 1400;
@@ -196,12 +237,14 @@ int main(void)
     if (glewInit() != GLEW_OK)
         std::cout << "Failed to initialize GLEW!" << std::endl;
 
+    GLDebug::Init(synchronousGLErrors);
+
     // Printing the OpenGL version we have
     std::cout << glGetString(GL_VERSION) << std::endl;
 
     { //OpenGL comedy
    
-        GLCallV(glEnable(GL_BLEND));
+        GLState::SetCapability(GL_BLEND, true);
         GLCallV(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
         Framebuffer framebuffer(1400, 800);  // Create an instance
@@ -223,11 +266,7 @@ int main(void)
         glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
         glfwSetWindowContentScaleCallback(window, DpiScaleCallback);
 
-        testMenu->RegisterTest<test::TestClearColor>("Clear Color");
-        testMenu->RegisterTest<test::TestTexture2D>("2D Texture");
-        testMenu->RegisterTest<test::TestTriangle>("Triangle");
-        testMenu->RegisterTest<test::TestShaderToy>("ShaderToy");
-        testMenu->RegisterTest<test::TestModelLoading>("Test Model Loading");
+        RegisterTests(*testMenu);
 
         const char* glsl_version = "#version 330";
         ImGui_ImplGlfw_InitForOpenGL(window, true);
@@ -245,12 +284,18 @@ int main(void)
 
         MouseInput mouse;
 
+        AssetWatcher::Start("res");
+
         while (!glfwWindowShouldClose(window))
         {
             float currentTime = glfwGetTime();
             float deltaTime = currentTime -  lastFrameTime;
             lastFrameTime = currentTime;
 
+            GLState::BeginFrame();  // ImGui's backend binds behind the cache's back
+            Profiler::BeginFrame();
+            AssetWatcher::Dispatch();  // Before the test queues anything that uses the assets
+
             framebuffer.Bind();  // Render to framebuffe
 
             GLCallV(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
@@ -265,9 +310,16 @@ int main(void)
 
             if (currentTest)
             {
-                currentTest->OnUpdate(deltaTime);
-                currentTest->OnRender();
+                {
+                    PROFILE_SCOPE("Test::OnUpdate");
+                    currentTest->OnUpdate(deltaTime);
+                }
+                {
+                    PROFILE_SCOPE("Test::OnRender");
+                    currentTest->OnRender();
+                }
 
+                PROFILE_SCOPE("Test::OnImGuiRender");
                 ImGui::Begin("Test");
                 if (currentTest != testMenu && ImGui::Button("<-"))
                 {
@@ -327,21 +379,36 @@ int main(void)
             ImGui::End();
             ImGui::PopStyleVar();
 
-            ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            Profiler::OnImGuiRender();
+            AssetWatcher::OnImGuiRender();
+
+            {
+                // Draws all windows, including the Scene image that composites the framebuffer
+                PROFILE_SCOPE("ImGui render");
+                ImGui::Render();
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
 
             // Handle multiple viewports
             ImGuiIO& io = ImGui::GetIO();
             if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+                // The zone opens and closes on the main context, query objects aren't shared with the platform windows
+                PROFILE_SCOPE("Platform windows");
                 GLFWwindow* backup_current_context = glfwGetCurrentContext();
                 ImGui::UpdatePlatformWindows();
                 ImGui::RenderPlatformWindowsDefault();
                 glfwMakeContextCurrent(backup_current_context);
             }
 
-            glfwSwapBuffers(window);
+            {
+                PROFILE_SCOPE("Swap buffers");
+                glfwSwapBuffers(window);
+            }
             renderer.Clear(); // Fixes issue with docking and color lingering on edges of glfw_window
 
+            Profiler::EndFrame();
+            GLDebug::EndFrame();
+
             glfwPollEvents();
 
             frameCount++;
@@ -351,6 +418,9 @@ int main(void)
             delete testMenu;
         delete currentTest;
 
+        AssetWatcher::Stop();
+        Profiler::Shutdown();
+
     } // OpenGL comedy
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,354 @@
+#include "AssetWatcher.h"
+#include "Shader.h"
+#include "ShaderVariants.h"
+#include "Texture.h"
+#include "Model.h"
+#include "Profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    constexpr size_t kMaxReloads = 8;
+
+    struct PendingChange {
+        Clock::time_point firstWrite;
+        Clock::time_point lastWrite;
+    };
+
+    struct Entry {
+        uint64_t id;
+        std::function<bool(const std::string& path)> dependsOn;
+        std::function<bool()> reload;
+    };
+
+    struct WatcherState {
+        std::string directory;
+        std::thread thread;
+        std::atomic<bool> running{ false };
+        std::atomic<const char*> backend{ "" };
+
+        // Written by the watcher thread, drained by Dispatch()
+        std::mutex mutex;
+        std::unordered_map<std::string, PendingChange> pending;
+
+        // Main thread only
+        std::vector<Entry> entries;
+        uint64_t nextId = 1;
+        std::vector<AssetWatcher::Reload> reloads;
+
+        ~WatcherState() {
+            running = false;
+            if (thread.joinable())
+                thread.join();
+        }
+    };
+
+    WatcherState& State() {
+        static WatcherState state;
+        return state;
+    }
+
+    // The form paths are compared in, "res/shader/../shader/a.shader" and "res\shader\a.shader" are "res/shader/a.shader"
+    std::string Normalize(const std::string& path) {
+        return fs::path(path).lexically_normal().generic_string();
+    }
+
+    void Notify(WatcherState& state, const std::string& path) {
+        const Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto [it, inserted] = state.pending.try_emplace(Normalize(path), PendingChange{ now, now });
+        if (!inserted)
+            it->second.lastWrite = now;
+    }
+
+#ifdef __linux__
+    // Returns false when inotify can't be used, the caller polls instead
+    bool WatchInotify(WatcherState& state) {
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        std::unordered_map<int, std::string> directories;
+        auto addDirectory = [&](const std::string& directory) {
+            const int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd >= 0)
+                directories[wd] = directory;
+        };
+        addDirectory(state.directory);
+        std::error_code error;
+        for (const auto& entry : fs::recursive_directory_iterator(state.directory, error)) {
+            if (entry.is_directory())
+                addDirectory(entry.path().generic_string());
+        }
+        if (directories.empty()) {
+            close(fd);
+            return false;
+        }
+        state.backend = "inotify";
+
+        alignas(inotify_event) char buffer[4096];
+        while (state.running) {
+            pollfd request{ fd, POLLIN, 0 };
+            if (poll(&request, 1, 100) <= 0)
+                continue;  // Timeout, checks running again
+
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* next = buffer; next < buffer + length; ) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+                    next += sizeof(inotify_event) + event->len;
+
+                    auto it = directories.find(event->wd);
+                    if (it == directories.end() || event->len == 0)
+                        continue;
+                    const std::string path = it->second + "/" + event->name;
+                    if (event->mask & IN_ISDIR)
+                        addDirectory(path);  // New directories are watched too
+                    else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                        Notify(state, path);  // Written in place, or saved to a temporary and renamed over it
+                }
+            }
+        }
+        close(fd);
+        return true;
+    }
+#endif
+
+    std::unordered_map<std::string, fs::file_time_type> SnapshotWriteTimes(const std::string& directory) {
+        std::unordered_map<std::string, fs::file_time_type> times;
+        std::error_code error;
+        for (const auto& entry : fs::recursive_directory_iterator(directory, error)) {
+            if (entry.is_regular_file(error))
+                times[entry.path().generic_string()] = entry.last_write_time(error);
+        }
+        return times;
+    }
+
+    void WatchPolling(WatcherState& state) {
+        state.backend = "polling";
+        auto times = SnapshotWriteTimes(state.directory);
+        while (state.running) {
+            for (int waited = 0; waited < AssetWatcher::kPollMs && state.running; waited += 50)
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            auto current = SnapshotWriteTimes(state.directory);
+            for (const auto& [path, time] : current) {
+                auto it = times.find(path);
+                if (it == times.end() || it->second != time)
+                    Notify(state, path);
+            }
+            times.swap(current);
+        }
+    }
+
+    void WatchThread(WatcherState& state) {
+#ifdef __linux__
+        if (WatchInotify(state))
+            return;
+        std::cerr << "inotify is not available, polling " << state.directory << " for changes" << std::endl;
+#endif
+        WatchPolling(state);
+    }
+
+}
+
+AssetWatcher::Subscription& AssetWatcher::Subscription::operator=(Subscription&& other) noexcept
+{
+    if (this != &other) {
+        if (m_Id)
+            AssetWatcher::Unsubscribe(m_Id);
+        m_Id = other.m_Id;
+        other.m_Id = 0;
+    }
+    return *this;
+}
+
+AssetWatcher::Subscription::~Subscription()
+{
+    if (m_Id)
+        AssetWatcher::Unsubscribe(m_Id);
+}
+
+bool AssetWatcher::Start(const std::string& directory)
+{
+    WatcherState& state = State();
+    if (state.running)
+        return true;
+
+    std::error_code error;
+    if (!fs::is_directory(directory, error)) {
+        std::cerr << "Can't watch " << directory << " for changes, it is not a directory" << std::endl;
+        return false;
+    }
+    if (state.thread.joinable())
+        state.thread.join();
+
+    state.directory = Normalize(directory);
+    state.running = true;
+    state.thread = std::thread(WatchThread, std::ref(state));
+    return true;
+}
+
+void AssetWatcher::Stop()
+{
+    WatcherState& state = State();
+    state.running = false;
+    if (state.thread.joinable())
+        state.thread.join();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.pending.clear();
+}
+
+bool AssetWatcher::IsRunning()
+{
+    return State().running;
+}
+
+AssetWatcher::Subscription AssetWatcher::Subscribe(const std::string& path, std::function<bool()> reload)
+{
+    WatcherState& state = State();
+    const std::string watched = Normalize(path);
+    const uint64_t id = state.nextId++;
+    state.entries.push_back({ id, [watched](const std::string& changed) { return changed == watched; }, std::move(reload) });
+    return Subscription(id);
+}
+
+AssetWatcher::Subscription AssetWatcher::Watch(Shader& shader)
+{
+    WatcherState& state = State();
+    const uint64_t id = state.nextId++;
+    // The includes are looked up when a file changes, a reload may have added some
+    auto dependsOn = [&shader](const std::string& changed) {
+        const std::vector<std::string>& files = shader.GetSourceFiles();
+        return std::any_of(files.begin(), files.end(), [&](const std::string& file) { return Normalize(file) == changed; });
+    };
+    state.entries.push_back({ id, dependsOn, [&shader] { return shader.Reload(); } });
+    return Subscription(id);
+}
+
+AssetWatcher::Subscription AssetWatcher::Watch(ShaderVariants& shaders)
+{
+    WatcherState& state = State();
+    const uint64_t id = state.nextId++;
+    auto dependsOn = [&shaders](const std::string& changed) {
+        const std::vector<std::string>& files = shaders.GetSource().files;
+        return std::any_of(files.begin(), files.end(), [&](const std::string& file) { return Normalize(file) == changed; });
+    };
+    state.entries.push_back({ id, dependsOn, [&shaders] { return shaders.Reload(); } });
+    return Subscription(id);
+}
+
+AssetWatcher::Subscription AssetWatcher::Watch(Texture& texture)
+{
+    return Subscribe(texture.GetFilePath(), [&texture] { return texture.Reload(); });
+}
+
+AssetWatcher::Subscription AssetWatcher::Watch(Model& model)
+{
+    // The mesh cache is keyed by the file's write time, so this parses the new file
+    return Subscribe(model.GetPath(), [&model] { return model.Reload(); });
+}
+
+void AssetWatcher::Unsubscribe(uint64_t id)
+{
+    std::vector<Entry>& entries = State().entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [id](const Entry& entry) { return entry.id == id; }), entries.end());
+}
+
+void AssetWatcher::Dispatch()
+{
+    WatcherState& state = State();
+    if (!state.running)
+        return;
+
+    std::vector<std::pair<std::string, Clock::time_point>> settled;
+    {
+        const Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (auto it = state.pending.begin(); it != state.pending.end(); ) {
+            if (now - it->second.lastWrite >= std::chrono::milliseconds(kDebounceMs)) {
+                settled.emplace_back(it->first, it->second.firstWrite);
+                it = state.pending.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    if (settled.empty())
+        return;
+
+    PROFILE_SCOPE("AssetWatcher::Dispatch");
+    // An asset reloads once, even when a shader and one of its includes were saved together
+    std::vector<uint64_t> reloaded;
+    for (const auto& [path, firstWrite] : settled) {
+        for (size_t i = 0; i < state.entries.size(); i++) {
+            const Entry& entry = state.entries[i];
+            if (std::find(reloaded.begin(), reloaded.end(), entry.id) != reloaded.end() || !entry.dependsOn(path))
+                continue;
+            reloaded.push_back(entry.id);
+
+            const std::function<bool()> reload = entry.reload;  // The callback may subscribe, which moves entries
+            const Clock::time_point start = Clock::now();
+            const bool succeeded = reload();
+            const Clock::time_point end = Clock::now();
+
+            Reload result;
+            result.path = path;
+            result.succeeded = succeeded;
+            result.latencyMs = std::chrono::duration<double, std::milli>(end - firstWrite).count();
+            result.rebuildMs = std::chrono::duration<double, std::milli>(end - start).count();
+            if (succeeded)
+                std::cout << "Reloaded " << path << " in " << result.rebuildMs << " ms, " << result.latencyMs << " ms after the change" << std::endl;
+            else
+                std::cout << "Failed to reload " << path << ", keeping the previous version" << std::endl;
+
+            if (state.reloads.size() == kMaxReloads)
+                state.reloads.erase(state.reloads.begin());
+            state.reloads.push_back(result);
+        }
+    }
+}
+
+const std::vector<AssetWatcher::Reload>& AssetWatcher::GetReloads()
+{
+    return State().reloads;
+}
+
+void AssetWatcher::OnImGuiRender()
+{
+    WatcherState& state = State();
+    ImGui::Begin("Hot Reload");
+    if (state.running)
+        ImGui::Text("Watching %s (%s), %zu assets subscribed", state.directory.c_str(), state.backend.load(), state.entries.size());
+    else
+        ImGui::TextDisabled("Not watching for changes");
+
+    for (auto it = state.reloads.rbegin(); it != state.reloads.rend(); ++it) {
+        if (it->succeeded)
+            ImGui::Text("%s  %.1f ms after the change (rebuild %.1f ms)", it->path.c_str(), it->latencyMs, it->rebuildMs);
+        else
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s  failed, kept the previous version", it->path.c_str());
+    }
+    ImGui::End();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Shader;
+class ShaderVariants;
+class Texture;
+class Model;
+
+// Hot reload: a background thread watches a directory tree (res/) for written files, and Dispatch()
+// rebuilds the Shaders, Textures and Models subscribed to them on the main thread, between frames.
+// Changes are debounced, editors often write a file more than once per save. Uses inotify on Linux,
+// elsewhere (or when inotify fails) it compares write times every kPollMs.
+class AssetWatcher {
+public:
+    static constexpr int kDebounceMs = 100;    // Quiet time after the last write to a file before it reloads
+    static constexpr int kPollMs = 250;
+
+    // Unsubscribes when destroyed. Declare it after the asset it reloads, so it is destroyed first.
+    class Subscription {
+    public:
+        Subscription() : m_Id(0) {}
+        Subscription(Subscription&& other) noexcept : m_Id(other.m_Id) { other.m_Id = 0; }
+        Subscription& operator=(Subscription&& other) noexcept;
+        ~Subscription();
+
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+    private:
+        friend class AssetWatcher;
+        explicit Subscription(uint64_t id) : m_Id(id) {}
+        uint64_t m_Id;
+    };
+
+    // Watches directory and everything below it. Returns false when it doesn't exist.
+    static bool Start(const std::string& directory = "res");
+    static void Stop();
+    static bool IsRunning();
+
+    // reload runs in Dispatch() after path changed, and returns whether it succeeded
+    static Subscription Subscribe(const std::string& path, std::function<bool()> reload);
+    // Reloads the asset in place. Shaders also reload when one of their #include files changes.
+    static Subscription Watch(Shader& shader);
+    static Subscription Watch(ShaderVariants& shaders);
+    static Subscription Watch(Texture& texture);
+    static Subscription Watch(Model& model);
+
+    // Reloads everything subscribed to the changes that settled. Call at a frame boundary, on the
+    // thread with the GL context, before anything is queued for the frame.
+    static void Dispatch();
+
+    struct Reload {
+        std::string path;
+        bool succeeded;
+        double latencyMs;   // From the first write the watcher saw to the rebuilt asset
+        double rebuildMs;   // Of that, the time spent loading and compiling
+    };
+    // The last few reloads, the latest last
+    static const std::vector<Reload>& GetReloads();
+
+    static void OnImGuiRender();
+
+private:
+    static void Unsubscribe(uint64_t id);
+};
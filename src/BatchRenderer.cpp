@@ -0,0 +1,261 @@
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "Model.h"
+#include "Profiler.h"
+#include "VertexBufferLayout.h"
+
+#include <algorithm>
+
+// Draw ids are float attributes, exact far beyond this, and the texture buffer of a chunk stays small
+static constexpr unsigned int kMaxDrawsPerChunk = 1u << 16;
+static constexpr unsigned int kTexelsPerDraw = sizeof(glm::mat4) / sizeof(glm::vec4) + 1;
+static const Shader::UniformId kDrawDataUniform = Shader::GetUniformId("u_DrawData");
+static const Shader::UniformId kDrawIdOffsetUniform = Shader::GetUniformId("u_DrawIdOffset");  // Set per draw on the fallback path
+
+BatchRenderer::BatchRenderer(unsigned int arenaVertices, unsigned int arenaIndices)
+    : m_ArenaVertices(arenaVertices), m_ArenaIndices(arenaIndices), m_DrawIdCount(0),
+    m_DrawDataBuffer(0), m_DrawDataTexture(0), m_IndirectBuffer(0), m_MaxDrawsPerChunk(kMaxDrawsPerChunk),
+    m_IndirectSupported((GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance))
+{
+    m_Path = m_IndirectSupported ? Path::MultiDrawIndirect : Path::DrawBaseVertex;
+
+    GLint maxTexels = 0;
+    GLCallV(glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels));
+    m_MaxDrawsPerChunk = std::max(1u, std::min(kMaxDrawsPerChunk, static_cast<unsigned int>(maxTexels) / kTexelsPerDraw));
+
+    GLCallV(glGenBuffers(1, &m_DrawDataBuffer));
+    GLCallV(glBindBuffer(GL_TEXTURE_BUFFER, m_DrawDataBuffer));
+    GLCallV(glBufferData(GL_TEXTURE_BUFFER, m_MaxDrawsPerChunk * sizeof(DrawData), nullptr, GL_STREAM_DRAW));
+    GLCallV(glGenTextures(1, &m_DrawDataTexture));
+    GLState::BindTexture(kDrawDataTextureUnit, GL_TEXTURE_BUFFER, m_DrawDataTexture);
+    GLCallV(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_DrawDataBuffer));
+
+    if (m_IndirectSupported) {
+        GLCallV(glGenBuffers(1, &m_IndirectBuffer));
+    }
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    GLCallV(glDeleteTextures(1, &m_DrawDataTexture));
+    GLState::OnTextureDeleted(m_DrawDataTexture);
+    GLCallV(glDeleteBuffers(1, &m_DrawDataBuffer));
+    if (m_IndirectBuffer) {
+        GLCallV(glDeleteBuffers(1, &m_IndirectBuffer));
+    }
+}
+
+BatchRenderer::Arena& BatchRenderer::CreateArena(unsigned int vertexCapacity, unsigned int indexCapacity)
+{
+    Arena& arena = m_Arenas.emplace_back();
+    arena.vertexCapacity = vertexCapacity;
+    arena.indexCapacity = indexCapacity;
+    arena.vao = std::make_unique<VertexArray>();
+    arena.vertices = std::make_unique<VertexBuffer>(nullptr, vertexCapacity * static_cast<unsigned int>(sizeof(Vertex)));
+
+    VertexBufferLayout layout;
+    layout.Push<float>(3); // Position
+    layout.Push<float>(3); // Normal
+    layout.Push<float>(2); // TexCoords
+    arena.vao->AddBuffer(*arena.vertices, layout);
+
+    // Created with the VAO bound so the element binding lands in it
+    arena.indices = std::make_unique<IndexBuffer>(nullptr, indexCapacity);
+
+    if (m_DrawIds) {
+        VertexBufferLayout drawIdLayout(1);
+        drawIdLayout.Push<float>(1);
+        arena.vao->AddBuffer(*m_DrawIds, drawIdLayout, kDrawIdAttribute);
+    }
+    return arena;
+}
+
+void BatchRenderer::EnsureDrawIds(unsigned int count)
+{
+    if (count <= m_DrawIdCount)
+        return;
+
+    std::vector<float> ids(count);
+    for (unsigned int i = 0; i < count; i++)
+        ids[i] = static_cast<float>(i);
+    m_DrawIds = std::make_unique<VertexBuffer>(ids.data(), count * static_cast<unsigned int>(sizeof(float)));
+    m_DrawIdCount = count;
+
+    // Every arena's attribute still points at the old buffer
+    VertexBufferLayout drawIdLayout(1);
+    drawIdLayout.Push<float>(1);
+    for (Arena& arena : m_Arenas)
+        arena.vao->AddBuffer(*m_DrawIds, drawIdLayout, kDrawIdAttribute);
+}
+
+BatchRenderer::MeshHandle BatchRenderer::AddMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+    if (vertexCount == 0 || indexCount == 0) {
+        std::cerr << "BatchRenderer: skipping empty mesh" << std::endl;
+        return MeshHandle();
+    }
+
+    Arena* target = nullptr;
+    for (Arena& arena : m_Arenas) {
+        if (arena.vertexCapacity - arena.vertexCount >= vertexCount && arena.indexCapacity - arena.indexCount >= indexCount) {
+            target = &arena;
+            break;
+        }
+    }
+    if (!target) {
+        target = &CreateArena(std::max(m_ArenaVertices, static_cast<unsigned int>(vertexCount)),
+            std::max(m_ArenaIndices, static_cast<unsigned int>(indexCount)));
+    }
+
+    // Indices stay relative to the mesh, the draw's base vertex moves them to the mesh's vertices
+    target->vao->Bind();
+    target->vertices->SetSubData(target->vertexCount * static_cast<unsigned int>(sizeof(Vertex)), vertices,
+        static_cast<unsigned int>(vertexCount * sizeof(Vertex)));
+    target->indices->SetSubData(target->indexCount, indices, static_cast<unsigned int>(indexCount));
+
+    MeshRange range;
+    range.arena = static_cast<uint32_t>(target - m_Arenas.data());
+    range.firstIndex = target->indexCount;
+    range.indexCount = static_cast<uint32_t>(indexCount);
+    range.baseVertex = static_cast<int32_t>(target->vertexCount);
+    range.bounds = Bounds::FromVertices(vertices, vertexCount);
+
+    target->vertexCount += static_cast<unsigned int>(vertexCount);
+    target->indexCount += static_cast<unsigned int>(indexCount);
+
+    m_Meshes.push_back(range);
+    return MeshHandle{ static_cast<uint32_t>(m_Meshes.size() - 1) };
+}
+
+std::vector<BatchRenderer::MeshHandle> BatchRenderer::AddModel(const std::string& path)
+{
+    std::vector<MeshHandle> handles;
+    Model::LoadGeometry(path, [this, &handles](const MeshGeometry& geometry) {
+        MeshHandle handle = AddMesh(geometry.vertices, geometry.vertexCount, geometry.indices, geometry.indexCount);
+        if (handle.index < m_Meshes.size())
+            handles.push_back(handle);
+    });
+    return handles;
+}
+
+void BatchRenderer::Submit(MeshHandle mesh, const glm::mat4& transform, const glm::vec4& color)
+{
+    if (mesh.index >= m_Meshes.size())
+        return;
+    m_Draws.push_back({ mesh.index, static_cast<uint32_t>(m_DrawData.size()) });
+    m_DrawData.push_back({ transform, color });
+}
+
+void BatchRenderer::Submit(const std::vector<MeshHandle>& model, const glm::mat4& transform, const glm::vec4& color)
+{
+    if (model.empty())
+        return;
+
+    // The meshes of a model share one record
+    const uint32_t data = static_cast<uint32_t>(m_DrawData.size());
+    m_DrawData.push_back({ transform, color });
+    for (MeshHandle mesh : model) {
+        if (mesh.index < m_Meshes.size())
+            m_Draws.push_back({ mesh.index, data });
+    }
+}
+
+void BatchRenderer::SetPath(Path path)
+{
+    m_Path = (path == Path::MultiDrawIndirect && !m_IndirectSupported) ? Path::DrawBaseVertex : path;
+}
+
+void BatchRenderer::Flush(Shader& shader)
+{
+    PROFILE_SCOPE("BatchRenderer::Flush");
+
+    m_Stats = Stats();
+    if (m_Draws.empty())
+        return;
+
+    // Group the draws by arena (counting sort, keeps submission order within an arena) and give every
+    // draw its own record, in the same order, so a draw's position is its id
+    std::vector<size_t> offsets(m_Arenas.size() + 1, 0);
+    for (const Draw& draw : m_Draws)
+        offsets[m_Meshes[draw.mesh].arena + 1]++;
+    for (size_t i = 1; i < offsets.size(); i++)
+        offsets[i] += offsets[i - 1];
+
+    m_SortedDraws.resize(m_Draws.size());
+    m_SortedData.resize(m_Draws.size());
+    for (const Draw& draw : m_Draws) {
+        const size_t slot = offsets[m_Meshes[draw.mesh].arena]++;
+        m_SortedDraws[slot] = draw;
+        m_SortedData[slot] = m_DrawData[draw.data];
+    }
+
+    EnsureDrawIds(std::min(static_cast<unsigned int>(m_SortedDraws.size()), m_MaxDrawsPerChunk));
+
+    shader.Bind();
+    shader.SetUniform1i(kDrawDataUniform, kDrawDataTextureUnit);
+    shader.SetUniform1i(kDrawIdOffsetUniform, 0);
+    GLState::BindTexture(kDrawDataTextureUnit, GL_TEXTURE_BUFFER, m_DrawDataTexture);
+
+    for (size_t begin = 0; begin < m_SortedDraws.size(); begin += m_MaxDrawsPerChunk)
+        DrawChunk(shader, begin, std::min(m_SortedDraws.size(), begin + m_MaxDrawsPerChunk));
+
+    m_Stats.draws = m_Draws.size();
+    m_Draws.clear();
+    m_DrawData.clear();
+}
+
+void BatchRenderer::DrawChunk(Shader& shader, size_t begin, size_t end)
+{
+    const size_t count = end - begin;
+
+    // Orphan the previous chunk's records, the GPU may still be reading them
+    GLCallV(glBindBuffer(GL_TEXTURE_BUFFER, m_DrawDataBuffer));
+    GLCallV(glBufferData(GL_TEXTURE_BUFFER, m_MaxDrawsPerChunk * sizeof(DrawData), nullptr, GL_STREAM_DRAW));
+    GLCallV(glBufferSubData(GL_TEXTURE_BUFFER, 0, count * sizeof(DrawData), m_SortedData.data() + begin));
+
+    const bool indirect = m_Path == Path::MultiDrawIndirect;
+    if (indirect) {
+        m_Commands.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const MeshRange& range = m_Meshes[m_SortedDraws[begin + i].mesh];
+            m_Commands[i] = { range.indexCount, 1, range.firstIndex, range.baseVertex, static_cast<uint32_t>(i) };
+        }
+        GLCallV(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer));
+        GLCallV(glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DrawElementsIndirectCommand), m_Commands.data(), GL_STREAM_DRAW));
+    }
+
+    // The arenas hold 32 bit triangle lists, a restart index left on by a strip mesh could cut them
+    GLState::SetCapability(GL_PRIMITIVE_RESTART, false);
+
+    // Draws of one arena are contiguous
+    size_t run = 0;
+    while (run < count) {
+        const uint32_t arenaIndex = m_Meshes[m_SortedDraws[begin + run].mesh].arena;
+        size_t runEnd = run + 1;
+        while (runEnd < count && m_Meshes[m_SortedDraws[begin + runEnd].mesh].arena == arenaIndex)
+            runEnd++;
+
+        Arena& arena = m_Arenas[arenaIndex];
+        arena.vao->Bind();
+        arena.indices->Bind();
+
+        if (indirect) {
+            const void* offset = (const void*)(uintptr_t)(run * sizeof(DrawElementsIndirectCommand));
+            GLCallV(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, static_cast<GLsizei>(runEnd - run), 0));
+            m_Stats.glDrawCalls++;
+        }
+        else {
+            // Without base instances the attribute always reads id 0, the uniform supplies the rest
+            for (size_t i = run; i < runEnd; i++) {
+                const MeshRange& range = m_Meshes[m_SortedDraws[begin + i].mesh];
+                shader.SetUniform1i(kDrawIdOffsetUniform, static_cast<int>(i));
+                GLCallV(glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+                    (const void*)(uintptr_t)(range.firstIndex * sizeof(unsigned int)), range.baseVertex));
+                m_Stats.glDrawCalls++;
+            }
+            shader.SetUniform1i(kDrawIdOffsetUniform, 0);
+        }
+        run = runEnd;
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "Vertex.h"
+#include "Bounds.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+
+// Draws many meshes with a handful of GL calls. Mesh geometry is suballocated out of a few large
+// arenas, each one VAO with one vertex and one index buffer, and the draws Submit()ted during a frame
+// become one multi-draw per arena in Flush().
+//
+// Per-draw data (model matrix and color) goes into a texture buffer that batch_shader.shader indexes
+// by draw id. The id is an instanced attribute reading a buffer of 0, 1, 2, ..., so a command's base
+// instance selects its record. With GL 4.3 or ARB_multi_draw_indirect the commands are written to an
+// indirect buffer and each arena is a single glMultiDrawElementsIndirect.
+// GL 3.3 has no base instance and no gl_DrawID, so the draws of a glMultiDrawElementsBaseVertex can't
+// be told apart. The fallback issues one glDrawElementsBaseVertex per draw with the id in a uniform,
+// which still skips every VAO, buffer and program switch between meshes.
+class BatchRenderer {
+public:
+    enum class Path {
+        MultiDrawIndirect,
+        DrawBaseVertex,
+    };
+
+    // Identifies a mesh added to the arenas
+    struct MeshHandle {
+        uint32_t index = 0xFFFFFFFFu;
+    };
+
+    struct Stats {
+        uint64_t draws = 0;        // Submitted meshes
+        uint64_t glDrawCalls = 0;  // Draw calls it took to render them
+    };
+
+    static constexpr unsigned int kDefaultArenaVertices = 1u << 20;  // 32 MB of Vertex
+    static constexpr unsigned int kDefaultArenaIndices = 3u << 20;   // 12 MB of indices
+    static constexpr unsigned int kDrawIdAttribute = 3;              // After the Vertex attributes
+    static constexpr unsigned int kDrawDataTextureUnit = 0;
+
+    BatchRenderer(unsigned int arenaVertices = kDefaultArenaVertices, unsigned int arenaIndices = kDefaultArenaIndices);
+    ~BatchRenderer();
+
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+    // Copies the geometry into an arena with room for it, a mesh larger than the arena size gets an
+    // arena of its own
+    MeshHandle AddMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+    // Loads path through Model::LoadGeometry, one handle per mesh. Empty if loading failed.
+    std::vector<MeshHandle> AddModel(const std::string& path);
+
+    // Object space bounds of a mesh
+    const Bounds& GetMeshBounds(MeshHandle mesh) const { return m_Meshes[mesh.index].bounds; }
+
+    // Queues a draw for the next Flush()
+    void Submit(MeshHandle mesh, const glm::mat4& transform, const glm::vec4& color);
+    void Submit(const std::vector<MeshHandle>& model, const glm::mat4& transform, const glm::vec4& color);
+
+    // Draws everything submitted since the last Flush() with shader (see batch_shader.shader)
+    void Flush(Shader& shader);
+
+    bool IsMultiDrawIndirectSupported() const { return m_IndirectSupported; }
+    // MultiDrawIndirect falls back to DrawBaseVertex where it isn't supported
+    void SetPath(Path path);
+    Path GetPath() const { return m_Path; }
+
+    size_t GetArenaCount() const { return m_Arenas.size(); }
+    size_t GetMeshCount() const { return m_Meshes.size(); }
+    const Stats& GetStats() const { return m_Stats; }  // Of the last Flush()
+
+private:
+    struct Arena {
+        std::unique_ptr<VertexArray> vao;
+        std::unique_ptr<VertexBuffer> vertices;
+        std::unique_ptr<IndexBuffer> indices;
+        unsigned int vertexCapacity = 0;
+        unsigned int vertexCount = 0;
+        unsigned int indexCapacity = 0;
+        unsigned int indexCount = 0;
+    };
+
+    struct MeshRange {
+        uint32_t arena;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t baseVertex;
+        Bounds bounds;
+    };
+
+    // Texture buffer record, five RGBA32F texels
+    struct DrawData {
+        glm::mat4 transform;
+        glm::vec4 color;
+    };
+
+    struct Draw {
+        uint32_t mesh;
+        uint32_t data;  // Into m_DrawData
+    };
+
+    // Layout GL defines for glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t baseInstance;
+    };
+
+    Arena& CreateArena(unsigned int vertexCapacity, unsigned int indexCapacity);
+    void EnsureDrawIds(unsigned int count);
+    void DrawChunk(Shader& shader, size_t begin, size_t end);
+
+    std::vector<Arena> m_Arenas;
+    std::vector<MeshRange> m_Meshes;
+    unsigned int m_ArenaVertices;
+    unsigned int m_ArenaIndices;
+
+    std::vector<Draw> m_Draws;
+    std::vector<DrawData> m_DrawData;
+    std::vector<Draw> m_SortedDraws;  // m_Draws grouped by arena
+    std::vector<DrawData> m_SortedData;
+    std::vector<DrawElementsIndirectCommand> m_Commands;
+
+    std::unique_ptr<VertexBuffer> m_DrawIds;  // 0, 1, 2, ... as floats
+    unsigned int m_DrawIdCount;
+    unsigned int m_DrawDataBuffer;
+    unsigned int m_DrawDataTexture;
+    unsigned int m_IndirectBuffer;
+    unsigned int m_MaxDrawsPerChunk;
+
+    bool m_IndirectSupported;
+    Path m_Path;
+    Stats m_Stats;
+};
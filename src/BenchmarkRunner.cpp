@@ -0,0 +1,233 @@
+#include "BenchmarkRunner.h"
+#include "HeadlessRunner.h"
+#include "Renderer.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Nearest rank percentile of sorted samples
+    double Percentile(const std::vector<double>& sorted, double percent) {
+        if (sorted.empty())
+            return 0.0;
+        size_t rank = static_cast<size_t>(percent / 100.0 * sorted.size() + 0.999999);
+        rank = std::clamp<size_t>(rank, 1, sorted.size());
+        return sorted[rank - 1];
+    }
+
+    std::string JsonEscape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20)
+                escaped += c;
+        }
+        return escaped;
+    }
+
+    const char* GLString(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "unknown";
+    }
+
+}
+
+FrameTimeStats FrameTimeStats::FromSamples(std::vector<double> samples) {
+    FrameTimeStats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+
+    stats.mean = sum / samples.size();
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.p50 = Percentile(samples, 50.0);
+    stats.p95 = Percentile(samples, 95.0);
+    stats.p99 = Percentile(samples, 99.0);
+    return stats;
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& options)
+    : m_Options(options), m_Queries{}, m_HasTimerQueries(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+{
+    if (m_HasTimerQueries) {
+        GLCallV(glGenQueries(kQueryCount, m_Queries));
+    }
+    else {
+        std::cout << "[Benchmark] Timer queries not supported, GPU times are not recorded" << std::endl;
+    }
+}
+
+BenchmarkRunner::~BenchmarkRunner() {
+    if (m_HasTimerQueries)
+        glDeleteQueries(kQueryCount, m_Queries);
+}
+
+const BenchmarkResult& BenchmarkRunner::Run(const std::string& name, const test::TestMenu& testMenu, Framebuffer& framebuffer) {
+    BenchmarkResult result;
+    result.test = name;
+    result.hasGpuTimes = m_HasTimerQueries;
+
+    auto setupStart = Clock::now();
+    test::Test* test = testMenu.CreateTest(name);
+    if (!test) {
+        std::cerr << "[Benchmark] No test named \"" << name << "\"" << std::endl;
+        m_Results.push_back(result);
+        return m_Results.back();
+    }
+    test->OnWindowResize(framebuffer.GetWidth(), framebuffer.GetHeight());
+    GLCallV(glFinish());
+    result.setupMs = ElapsedMs(setupStart, Clock::now());
+
+    const float deltaTime = 1.0f / 60.0f; // Fixed step, so every run animates the same frames
+    for (int frame = 0; frame < m_Options.warmupFrames; frame++)
+        HeadlessRunner::RenderFrame(*test, framebuffer, deltaTime);
+    GLCallV(glFinish());
+
+    std::vector<double> cpuTimes, gpuTimes;
+    cpuTimes.reserve(m_Options.measuredFrames);
+    gpuTimes.reserve(m_Options.measuredFrames);
+
+    // Query i holds frame i % kQueryCount; its result is collected kQueryCount frames later, just before the query is reused
+    auto collectGpuTime = [&](int frame) {
+        GLuint64 elapsed = 0;
+        GLCallV(glGetQueryObjectui64v(m_Queries[frame % kQueryCount], GL_QUERY_RESULT, &elapsed));
+        gpuTimes.push_back(elapsed / 1.0e6);
+    };
+
+    GLState::ResetCounters();
+    auto measureStart = Clock::now();
+    for (int frame = 0; frame < m_Options.measuredFrames; frame++) {
+        if (m_HasTimerQueries && frame >= kQueryCount)
+            collectGpuTime(frame - kQueryCount);
+
+        auto frameStart = Clock::now();
+        if (m_HasTimerQueries) {
+            GLCallV(glBeginQuery(GL_TIME_ELAPSED, m_Queries[frame % kQueryCount]));
+        }
+
+        HeadlessRunner::RenderFrame(*test, framebuffer, deltaTime);
+
+        if (m_HasTimerQueries) {
+            GLCallV(glEndQuery(GL_TIME_ELAPSED));
+        }
+        cpuTimes.push_back(ElapsedMs(frameStart, Clock::now()));
+    }
+    GLCallV(glFinish());
+    result.wallMs = ElapsedMs(measureStart, Clock::now());
+
+    const GLState::Counters& counters = GLState::GetCounters();
+    result.stateChangesIssued = static_cast<double>(counters.TotalIssued()) / std::max(1, m_Options.measuredFrames);
+    result.stateChangesElided = static_cast<double>(counters.TotalElided()) / std::max(1, m_Options.measuredFrames);
+
+    if (m_HasTimerQueries) {
+        for (int frame = std::max(0, m_Options.measuredFrames - kQueryCount); frame < m_Options.measuredFrames; frame++)
+            collectGpuTime(frame);
+    }
+
+    delete test;
+
+    result.frames = m_Options.measuredFrames;
+    result.cpu = FrameTimeStats::FromSamples(cpuTimes);
+    result.gpu = FrameTimeStats::FromSamples(gpuTimes);
+    m_Results.push_back(result);
+    return m_Results.back();
+}
+
+void BenchmarkRunner::PrintSummary(std::ostream& stream) const {
+    stream << std::fixed << std::setprecision(3);
+    for (const BenchmarkResult& result : m_Results) {
+        stream << "[Benchmark] " << result.test << ": " << result.frames << " frames, setup " << result.setupMs << " ms, cpu p50/p95/p99 "
+            << result.cpu.p50 << "/" << result.cpu.p95 << "/" << result.cpu.p99 << " ms";
+        if (result.hasGpuTimes)
+            stream << ", gpu p50/p95/p99 " << result.gpu.p50 << "/" << result.gpu.p95 << "/" << result.gpu.p99 << " ms";
+        stream << ", state changes issued/elided " << result.stateChangesIssued << "/" << result.stateChangesElided << " per frame";
+        stream << std::endl;
+    }
+    stream << std::defaultfloat;
+}
+
+bool BenchmarkRunner::WriteJSON(const std::string& path, int width, int height) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write benchmark results: " << path << std::endl;
+        return false;
+    }
+
+    auto writeStats = [&file](const char* name, const FrameTimeStats& stats) {
+        file << "      \"" << name << "\": { \"mean\": " << stats.mean << ", \"min\": " << stats.min << ", \"max\": " << stats.max
+            << ", \"p50\": " << stats.p50 << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99 << " }";
+    };
+
+    file << std::fixed << std::setprecision(4);
+    file << "{\n";
+    file << "  \"renderer\": \"" << JsonEscape(GLString(GL_RENDERER)) << "\",\n";
+    file << "  \"version\": \"" << JsonEscape(GLString(GL_VERSION)) << "\",\n";
+    file << "  \"timestamp\": " << static_cast<long long>(std::time(nullptr)) << ",\n";
+    file << "  \"width\": " << width << ",\n";
+    file << "  \"height\": " << height << ",\n";
+    file << "  \"warmupFrames\": " << m_Options.warmupFrames << ",\n";
+    file << "  \"measuredFrames\": " << m_Options.measuredFrames << ",\n";
+    file << "  \"tests\": [\n";
+    for (size_t i = 0; i < m_Results.size(); i++) {
+        const BenchmarkResult& result = m_Results[i];
+        file << "    {\n";
+        file << "      \"name\": \"" << JsonEscape(result.test) << "\",\n";
+        file << "      \"frames\": " << result.frames << ",\n";
+        file << "      \"setupMs\": " << result.setupMs << ",\n";
+        file << "      \"wallMs\": " << result.wallMs << ",\n";
+        file << "      \"stateChangesPerFrame\": { \"issued\": " << result.stateChangesIssued << ", \"elided\": " << result.stateChangesElided << " },\n";
+        writeStats("cpuMs", result.cpu);
+        if (result.hasGpuTimes) {
+            file << ",\n";
+            writeStats("gpuMs", result.gpu);
+        }
+        file << "\n    }" << (i + 1 < m_Results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+    return true;
+}
+
+bool BenchmarkRunner::WriteCSV(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write benchmark results: " << path << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(4);
+    file << "test,frames,setup_ms,wall_ms,cpu_mean_ms,cpu_min_ms,cpu_max_ms,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,"
+            "gpu_mean_ms,gpu_min_ms,gpu_max_ms,gpu_p50_ms,gpu_p95_ms,gpu_p99_ms,state_issued_per_frame,state_elided_per_frame\n";
+    for (const BenchmarkResult& result : m_Results) {
+        file << '"' << result.test << "\"," << result.frames << ',' << result.setupMs << ',' << result.wallMs << ','
+            << result.cpu.mean << ',' << result.cpu.min << ',' << result.cpu.max << ','
+            << result.cpu.p50 << ',' << result.cpu.p95 << ',' << result.cpu.p99;
+        if (result.hasGpuTimes) {
+            file << ',' << result.gpu.mean << ',' << result.gpu.min << ',' << result.gpu.max << ','
+                << result.gpu.p50 << ',' << result.gpu.p95 << ',' << result.gpu.p99;
+        }
+        else {
+            file << ",,,,,,";
+        }
+        file << ',' << result.stateChangesIssued << ',' << result.stateChangesElided << '\n';
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "tests/Test.h"
+
+struct BenchmarkOptions {
+    int warmupFrames = 30;
+    int measuredFrames = 300;
+    std::vector<std::string> tests;  // Registered test names to run, empty runs all of them
+    std::string jsonPath = "benchmark.json";
+    std::string csvPath;             // Empty skips the CSV file
+};
+
+// Distribution of per frame times in milliseconds
+struct FrameTimeStats {
+    double mean = 0.0, min = 0.0, max = 0.0;
+    double p50 = 0.0, p95 = 0.0, p99 = 0.0;
+
+    static FrameTimeStats FromSamples(std::vector<double> samples);
+};
+
+struct BenchmarkResult {
+    std::string test;
+    double setupMs = 0.0;            // Test construction (resource loading)
+    double wallMs = 0.0;             // Measured frames end to end, including the final glFinish
+    int frames = 0;
+    FrameTimeStats cpu;              // CPU time to update, render and submit a frame
+    FrameTimeStats gpu;              // GL_TIME_ELAPSED of the frame's commands
+    bool hasGpuTimes = false;
+    double stateChangesIssued = 0.0; // GLState calls that reached GL, per measured frame
+    double stateChangesElided = 0.0; // GLState calls skipped as redundant, per measured frame
+};
+
+// Runs registered tests one after another into an offscreen Framebuffer, with nothing capping the
+// frame rate, and records CPU and GPU frame times. Driven by HeadlessRunner (--benchmark).
+class BenchmarkRunner {
+public:
+    BenchmarkRunner(const BenchmarkOptions& options);
+    ~BenchmarkRunner();
+
+    // Constructs the named test, renders the warmup and measured frames and keeps the result
+    const BenchmarkResult& Run(const std::string& name, const test::TestMenu& testMenu, Framebuffer& framebuffer);
+
+    void PrintSummary(std::ostream& stream) const;
+    bool WriteJSON(const std::string& path, int width, int height) const;
+    bool WriteCSV(const std::string& path) const;
+
+    const std::vector<BenchmarkResult>& GetResults() const { return m_Results; }
+
+private:
+    // Timer queries are read a few frames late so waiting on results never stalls the pipeline
+    static constexpr int kQueryCount = 4;
+
+    BenchmarkOptions m_Options;
+    std::vector<BenchmarkResult> m_Results;
+    unsigned int m_Queries[kQueryCount];
+    bool m_HasTimerQueries;
+};
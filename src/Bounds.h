@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "glm/glm.hpp"
+#include "Vertex.h"
+
+// Axis aligned box plus a bounding sphere around the same geometry. Culling tests both and keeps the
+// tighter answer: the box fits long thin meshes, the sphere survives rotation without growing.
+struct Bounds {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+    glm::vec3 center = glm::vec3(0.0f);     // Sphere center, the box center
+    float radius = 0.0f;
+    bool valid = false;                     // False for empty geometry
+
+    glm::vec3 GetExtent() const { return (max - min) * 0.5f; }
+
+    static Bounds FromVertices(const Vertex* vertices, size_t count) {
+        Bounds bounds;
+        if (count == 0)
+            return bounds;
+
+        bounds.min = bounds.max = vertices[0].Position;
+        for (size_t i = 1; i < count; i++) {
+            bounds.min = glm::min(bounds.min, vertices[i].Position);
+            bounds.max = glm::max(bounds.max, vertices[i].Position);
+        }
+        // Centering the sphere on the box is within a few percent of the optimal sphere for typical
+        // meshes and needs only one more pass
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            const glm::vec3 offset = vertices[i].Position - bounds.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        bounds.radius = std::sqrt(radiusSquared);
+        bounds.valid = true;
+        return bounds;
+    }
+
+    // Smallest box around both, the sphere encloses both spheres
+    static Bounds Merge(const Bounds& a, const Bounds& b) {
+        if (!a.valid)
+            return b;
+        if (!b.valid)
+            return a;
+
+        Bounds bounds;
+        bounds.min = glm::min(a.min, b.min);
+        bounds.max = glm::max(a.max, b.max);
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+        bounds.radius = std::max(glm::length(a.center - bounds.center) + a.radius, glm::length(b.center - bounds.center) + b.radius);
+        bounds.valid = true;
+        return bounds;
+    }
+
+    // World space bounds under an affine transform. The box is the box around the transformed box
+    // (Arvo), the sphere radius grows with the largest axis scale.
+    Bounds Transformed(const glm::mat4& transform) const {
+        if (!valid)
+            return *this;
+
+        Bounds bounds;
+        const glm::vec3 boxCenter = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1.0f));
+        const glm::vec3 extent = GetExtent();
+        glm::vec3 worldExtent(0.0f);
+        for (int column = 0; column < 3; column++) {
+            const glm::vec3 axis = glm::vec3(transform[column]);
+            worldExtent += glm::abs(axis) * extent[column];
+        }
+        bounds.min = boxCenter - worldExtent;
+        bounds.max = boxCenter + worldExtent;
+
+        const float scale = std::sqrt(std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+            std::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])), glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])))));
+        bounds.center = glm::vec3(transform * glm::vec4(center, 1.0f));
+        bounds.radius = radius * scale;
+        bounds.valid = true;
+        return bounds;
+    }
+};
@@ -0,0 +1,117 @@
+#include "DynamicVertexBuffer.h"
+
+#include "Renderer.h"
+
+#include <cstring>
+
+static constexpr GLuint64 kFenceTimeoutNs = 1000000000ull;
+
+DynamicVertexBuffer::DynamicVertexBuffer(unsigned int vertexCapacity, unsigned int vertexStride, Mode mode)
+    : m_VertexCapacity(vertexCapacity), m_VertexStride(vertexStride), m_SegmentSize(vertexCapacity * vertexStride),
+    m_Mode(mode), m_Mapped(nullptr), m_Segment(0), m_VertexCount(0), m_Writing(false), m_Fences{}, m_FenceWaits(0)
+{
+    if (m_Mode == Mode::PersistentRing && !IsPersistentSupported()) {
+        std::cout << "DynamicVertexBuffer: buffer storage unavailable, orphaning instead" << std::endl;
+        m_Mode = Mode::Orphaning;
+    }
+
+    Bind();
+    if (m_Mode == Mode::PersistentRing) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = static_cast<GLsizeiptr>(m_SegmentSize) * kSegmentCount;
+        GLCallV(glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags));
+        m_Mapped = static_cast<unsigned char*>(GLCall(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags)));
+        if (!m_Mapped)
+            std::cerr << "DynamicVertexBuffer: failed to map " << size << " bytes" << std::endl;
+        // Start on the last segment so the first BeginWrite lands on segment 0
+        m_Segment = kSegmentCount - 1;
+    }
+    else {
+        GLCallV(glBufferData(GL_ARRAY_BUFFER, m_SegmentSize, nullptr, GL_STREAM_DRAW));
+    }
+}
+
+DynamicVertexBuffer::~DynamicVertexBuffer()
+{
+    for (GLsync& fence : m_Fences) {
+        if (fence) {
+            GLCallV(glDeleteSync(fence));
+        }
+    }
+    if (m_Mapped) {
+        Bind();
+        GLCallV(glUnmapBuffer(GL_ARRAY_BUFFER));
+    }
+}
+
+void* DynamicVertexBuffer::BeginWrite()
+{
+    ASSERT(!m_Writing);
+    m_Writing = true;
+
+    if (m_Mode == Mode::Orphaning) {
+        Bind();
+        GLCallV(glBufferData(GL_ARRAY_BUFFER, m_SegmentSize, nullptr, GL_STREAM_DRAW));
+        m_Mapped = static_cast<unsigned char*>(GLCall(glMapBufferRange(GL_ARRAY_BUFFER, 0, m_SegmentSize,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)));
+        return m_Mapped;
+    }
+
+    // The draws reading the current segment were all issued before this call
+    GLsync& previous = m_Fences[m_Segment];
+    if (previous) {
+        GLCallV(glDeleteSync(previous));
+    }
+    previous = GLCall(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    m_Segment = (m_Segment + 1) % kSegmentCount;
+    if (GLsync fence = m_Fences[m_Segment]) {
+        GLenum status = GLCall(glClientWaitSync(fence, 0, 0));
+        if (status == GL_TIMEOUT_EXPIRED) {
+            m_FenceWaits++;
+            // The flush makes sure the fence gets submitted and can signal at all
+            do {
+                status = GLCall(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs));
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        GLCallV(glDeleteSync(fence));
+        m_Fences[m_Segment] = nullptr;
+    }
+    return m_Mapped ? m_Mapped + static_cast<size_t>(m_Segment) * m_SegmentSize : nullptr;
+}
+
+void DynamicVertexBuffer::EndWrite(unsigned int vertexCount)
+{
+    ASSERT(m_Writing && vertexCount <= m_VertexCapacity);
+    m_Writing = false;
+    m_VertexCount = vertexCount;
+
+    // Coherent persistent memory is visible to the GPU without any call
+    if (m_Mode == Mode::Orphaning) {
+        Bind();
+        GLCallV(glUnmapBuffer(GL_ARRAY_BUFFER));
+        m_Mapped = nullptr;
+    }
+}
+
+void DynamicVertexBuffer::Write(const void* vertices, unsigned int vertexCount)
+{
+    void* destination = BeginWrite();
+    if (destination)
+        std::memcpy(destination, vertices, static_cast<size_t>(vertexCount) * m_VertexStride);
+    EndWrite(destination ? vertexCount : 0);
+}
+
+bool DynamicVertexBuffer::IsPersistentSupported()
+{
+    return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+const char* DynamicVertexBuffer::GetModeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::PersistentRing: return "Persistent ring";
+    case Mode::Orphaning:      return "Orphaning";
+    default:                   return "Unknown";
+    }
+}
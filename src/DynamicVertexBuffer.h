@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <GL/glew.h>
+
+#include "VertexBuffer.h"
+
+// Vertex buffer for data rewritten every frame. Plugs into VertexArray::AddBuffer like any
+// VertexBuffer, the data of the current frame starts at GetBaseVertex().
+//
+// PersistentRing (GL 4.4 / ARB_buffer_storage) maps three segments once, persistent and coherent, and
+// writes each frame into the next one. A fence after the frame's draws guards each segment, so the CPU
+// only waits when it laps a segment the GPU hasn't finished reading.
+// Orphaning re-specifies a single segment every frame and writes it through glMapBufferRange, the
+// driver hands out fresh memory while the GPU keeps the old copy.
+class DynamicVertexBuffer : public VertexBuffer
+{
+public:
+	enum class Mode
+	{
+		PersistentRing,
+		Orphaning,
+	};
+
+	static constexpr unsigned int kSegmentCount = 3;
+
+	// PersistentRing falls back to Orphaning where buffer storage isn't supported
+	DynamicVertexBuffer(unsigned int vertexCapacity, unsigned int vertexStride, Mode mode = Mode::PersistentRing);
+	~DynamicVertexBuffer();
+
+	// Storage is fixed, write through BeginWrite/EndWrite
+	void SetData(const void* data, unsigned int size) = delete;
+	void SetSubData(unsigned int offset, const void* data, unsigned int size) = delete;
+
+	// Moves on to the next segment and returns where to write up to GetCapacity() vertices. Fences
+	// the segment it leaves, so call once per frame after the previous frame's draws were issued.
+	void* BeginWrite();
+	// Finishes the writes started by BeginWrite, vertexCount vertices were written
+	void EndWrite(unsigned int vertexCount);
+	// Copies vertexCount vertices in one go
+	void Write(const void* vertices, unsigned int vertexCount);
+
+	// First vertex of the data last written, pass it as the base vertex of the draws
+	int GetBaseVertex() const { return static_cast<int>(m_Segment * m_VertexCapacity); }
+	unsigned int GetVertexCount() const { return m_VertexCount; }
+	unsigned int GetCapacity() const { return m_VertexCapacity; }
+	Mode GetMode() const { return m_Mode; }
+
+	// Times BeginWrite found the GPU still reading its segment and had to block
+	uint64_t GetFenceWaits() const { return m_FenceWaits; }
+
+	static bool IsPersistentSupported();
+	static const char* GetModeName(Mode mode);
+
+private:
+	unsigned int m_VertexCapacity;
+	unsigned int m_VertexStride;
+	unsigned int m_SegmentSize;
+	Mode m_Mode;
+
+	unsigned char* m_Mapped;			// Whole ring when persistent, the current segment while orphaning
+	unsigned int m_Segment;
+	unsigned int m_VertexCount;
+	bool m_Writing;
+
+	GLsync m_Fences[kSegmentCount];
+	uint64_t m_FenceWaits;
+};
@@ -1,4 +1,5 @@
 #include "Framebuffer.h"
+#include "GLState.h"
 #include <iostream>
 
 Framebuffer::Framebuffer(int width, int height)
@@ -11,6 +12,7 @@ Framebuffer::~Framebuffer()
 {
     glDeleteFramebuffers(1, &fbo);
     glDeleteTextures(1, &textureID);
+    GLState::OnTextureDeleted(textureID);
     glDeleteRenderbuffers(1, &rbo);
 }
 
@@ -21,7 +23,7 @@ void Framebuffer::CreateFramebuffer()
 
     // Create texture to store color buffer
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLState::BindTexture(0, GL_TEXTURE_2D, textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -59,7 +61,18 @@ void Framebuffer::Resize(int newWidth, int newHeight)
     height = newHeight;
 
     glDeleteTextures(1, &textureID);
+    GLState::OnTextureDeleted(textureID);
     glDeleteRenderbuffers(1, &rbo);
 
     CreateFramebuffer();
+}
+
+void Framebuffer::ReadPixels(std::vector<unsigned char>& pixels) const
+{
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
\ No newline at end of file
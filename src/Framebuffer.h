@@ -1,5 +1,6 @@
 #pragma once
 #include <GL/glew.h>
+#include <vector>
 
 class Framebuffer {
 public:
@@ -11,6 +12,12 @@ public:
     GLuint GetTextureID() const { return textureID; }
     void Resize(int newWidth, int newHeight);
 
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    // Reads the color attachment back as tightly packed RGBA8, bottom row first (OpenGL order)
+    void ReadPixels(std::vector<unsigned char>& pixels) const;
+
 private:
     GLuint fbo;
     GLuint textureID;
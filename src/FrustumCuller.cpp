@@ -0,0 +1,437 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define FRUSTUM_CULLER_AVX2
+#include <immintrin.h>
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+    // glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&viewProjection](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    Frustum frustum;
+    frustum.planes[0] = row(3) + row(0);  // Left
+    frustum.planes[1] = row(3) - row(0);  // Right
+    frustum.planes[2] = row(3) + row(1);  // Bottom
+    frustum.planes[3] = row(3) - row(1);  // Top
+    frustum.planes[4] = row(3) + row(2);  // Near
+    frustum.planes[5] = row(3) - row(2);  // Far
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Frustum::Intersects(const Bounds& bounds) const
+{
+    if (!bounds.valid)
+        return false;
+
+    const glm::vec3 extent = bounds.GetExtent();
+    for (const glm::vec4& plane : planes) {
+        const float distance = plane.x * bounds.center.x + plane.y * bounds.center.y + plane.z * bounds.center.z + plane.w;
+        const float boxRadius = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+        if (distance + std::min(boxRadius, bounds.radius) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void CullingSet::Clear()
+{
+    m_Pending.clear();
+    m_Nodes.clear();
+    m_CenterX.clear(); m_CenterY.clear(); m_CenterZ.clear();
+    m_ExtentX.clear(); m_ExtentY.clear(); m_ExtentZ.clear();
+    m_Radius.clear();
+    m_Ids.clear();
+}
+
+void CullingSet::Reserve(size_t count)
+{
+    m_Pending.reserve(count);
+}
+
+void CullingSet::Add(uint32_t id, const Bounds& worldBounds)
+{
+    if (!worldBounds.valid)
+        return;
+    // Transformed bounds share their center, Bounds::FromVertices centers the sphere on the box too
+    m_Pending.push_back({ id, (worldBounds.min + worldBounds.max) * 0.5f, worldBounds.GetExtent(), worldBounds.radius });
+}
+
+void CullingSet::Build()
+{
+    m_Nodes.clear();
+    if (!m_Pending.empty()) {
+        m_Nodes.reserve(2 * (m_Pending.size() / kLeafSize + 1));
+        BuildNode(0, static_cast<uint32_t>(m_Pending.size()));
+    }
+
+    const size_t count = m_Pending.size();
+    m_CenterX.resize(count); m_CenterY.resize(count); m_CenterZ.resize(count);
+    m_ExtentX.resize(count); m_ExtentY.resize(count); m_ExtentZ.resize(count);
+    m_Radius.resize(count);
+    m_Ids.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const Pending& instance = m_Pending[i];
+        m_CenterX[i] = instance.center.x;
+        m_CenterY[i] = instance.center.y;
+        m_CenterZ[i] = instance.center.z;
+        m_ExtentX[i] = instance.extent.x;
+        m_ExtentY[i] = instance.extent.y;
+        m_ExtentZ[i] = instance.extent.z;
+        m_Radius[i] = instance.radius;
+        m_Ids[i] = instance.id;
+    }
+    m_Pending.clear();
+}
+
+uint32_t CullingSet::BuildNode(uint32_t first, uint32_t count)
+{
+    const uint32_t index = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.push_back(Node());
+
+    glm::vec3 boxMin = m_Pending[first].center - m_Pending[first].extent;
+    glm::vec3 boxMax = m_Pending[first].center + m_Pending[first].extent;
+    glm::vec3 centerMin = m_Pending[first].center;
+    glm::vec3 centerMax = centerMin;
+    for (uint32_t i = first + 1; i < first + count; i++) {
+        const Pending& instance = m_Pending[i];
+        boxMin = glm::min(boxMin, instance.center - instance.extent);
+        boxMax = glm::max(boxMax, instance.center + instance.extent);
+        centerMin = glm::min(centerMin, instance.center);
+        centerMax = glm::max(centerMax, instance.center);
+    }
+
+    Node node;
+    node.center = (boxMin + boxMax) * 0.5f;
+    node.extent = (boxMax - boxMin) * 0.5f;
+    node.first = first;
+    node.count = count;
+    node.left = 0;
+    node.right = 0;
+
+    if (count > kLeafSize) {
+        // Median split along the axis the centers spread the most
+        const glm::vec3 spread = centerMax - centerMin;
+        const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+        const uint32_t half = count / 2;
+        std::nth_element(m_Pending.begin() + first, m_Pending.begin() + first + half, m_Pending.begin() + first + count,
+            [axis](const Pending& a, const Pending& b) { return a.center[axis] < b.center[axis]; });
+
+        node.left = BuildNode(first, half);
+        node.right = BuildNode(first + half, count - half);
+    }
+    m_Nodes[index] = node;
+    return index;
+}
+
+namespace {
+    enum class Containment { Outside, Intersecting, Inside };
+
+    struct PlaneSet {
+        float nx[6], ny[6], nz[6], w[6];
+        float absX[6], absY[6], absZ[6];
+
+        PlaneSet(const Frustum& frustum) {
+            for (int p = 0; p < 6; p++) {
+                nx[p] = frustum.planes[p].x;
+                ny[p] = frustum.planes[p].y;
+                nz[p] = frustum.planes[p].z;
+                w[p] = frustum.planes[p].w;
+                absX[p] = std::abs(nx[p]);
+                absY[p] = std::abs(ny[p]);
+                absZ[p] = std::abs(nz[p]);
+            }
+        }
+    };
+
+    Containment Classify(const PlaneSet& planes, const glm::vec3& center, const glm::vec3& extent)
+    {
+        Containment result = Containment::Inside;
+        for (int p = 0; p < 6; p++) {
+            const float distance = planes.nx[p] * center.x + planes.ny[p] * center.y + planes.nz[p] * center.z + planes.w[p];
+            const float radius = planes.absX[p] * extent.x + planes.absY[p] * extent.y + planes.absZ[p] * extent.z;
+            if (distance + radius < 0.0f)
+                return Containment::Outside;
+            if (distance - radius < 0.0f)
+                result = Containment::Intersecting;
+        }
+        return result;
+    }
+
+    struct Arrays {
+        const float* cx; const float* cy; const float* cz;
+        const float* ex; const float* ey; const float* ez;
+        const float* radius;
+        const uint32_t* ids;
+    };
+
+    // All loops evaluate the same expressions in the same order, so they agree bit for bit
+    void CullScalar(const PlaneSet& planes, const Arrays& a, size_t first, size_t end, std::vector<uint32_t>& visible)
+    {
+        for (size_t i = first; i < end; i++) {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++) {
+                const float distance = planes.nx[p] * a.cx[i] + planes.ny[p] * a.cy[i] + planes.nz[p] * a.cz[i] + planes.w[p];
+                const float boxRadius = planes.absX[p] * a.ex[i] + planes.absY[p] * a.ey[i] + planes.absZ[p] * a.ez[i];
+                inside = distance + std::min(boxRadius, a.radius[i]) >= 0.0f;
+            }
+            if (inside)
+                visible.push_back(a.ids[i]);
+        }
+    }
+
+#ifdef FRUSTUM_CULLER_SSE
+    size_t CullSSE(const PlaneSet& planes, const Arrays& a, size_t first, size_t end, std::vector<uint32_t>& visible)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        size_t i = first;
+        for (; i + 4 <= end; i += 4) {
+            const __m128 cx = _mm_loadu_ps(a.cx + i), cy = _mm_loadu_ps(a.cy + i), cz = _mm_loadu_ps(a.cz + i);
+            const __m128 ex = _mm_loadu_ps(a.ex + i), ey = _mm_loadu_ps(a.ey + i), ez = _mm_loadu_ps(a.ez + i);
+            const __m128 radius = _mm_loadu_ps(a.radius + i);
+
+            __m128 outside = zero;
+            for (int p = 0; p < 6; p++) {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nx[p]), cx), _mm_mul_ps(_mm_set1_ps(planes.ny[p]), cy));
+                distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.nz[p]), cz)), _mm_set1_ps(planes.w[p]));
+                __m128 boxRadius = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.absX[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.absY[p]), ey));
+                boxRadius = _mm_add_ps(boxRadius, _mm_mul_ps(_mm_set1_ps(planes.absZ[p]), ez));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, _mm_min_ps(boxRadius, radius)), zero));
+            }
+
+            const int mask = ~_mm_movemask_ps(outside) & 0xF;
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane))
+                    visible.push_back(a.ids[i + lane]);
+            }
+        }
+        return i;
+    }
+#endif
+
+#ifdef FRUSTUM_CULLER_AVX2
+    size_t CullAVX2(const PlaneSet& planes, const Arrays& a, size_t first, size_t end, std::vector<uint32_t>& visible)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = first;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 cx = _mm256_loadu_ps(a.cx + i), cy = _mm256_loadu_ps(a.cy + i), cz = _mm256_loadu_ps(a.cz + i);
+            const __m256 ex = _mm256_loadu_ps(a.ex + i), ey = _mm256_loadu_ps(a.ey + i), ez = _mm256_loadu_ps(a.ez + i);
+            const __m256 radius = _mm256_loadu_ps(a.radius + i);
+
+            __m256 outside = zero;
+            for (int p = 0; p < 6; p++) {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.nx[p]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.ny[p]), cy));
+                distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes.nz[p]), cz)), _mm256_set1_ps(planes.w[p]));
+                __m256 boxRadius = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.absX[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.absY[p]), ey));
+                boxRadius = _mm256_add_ps(boxRadius, _mm256_mul_ps(_mm256_set1_ps(planes.absZ[p]), ez));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, _mm256_min_ps(boxRadius, radius)), zero, _CMP_LT_OQ));
+            }
+
+            const int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane))
+                    visible.push_back(a.ids[i + lane]);
+            }
+        }
+        return i;
+    }
+#endif
+
+    // Tests the instances [first, end) with the backend, the scalar loop takes the remainder
+    void CullRange(FrustumCuller::Backend backend, const PlaneSet& planes, const Arrays& arrays, size_t first, size_t end, std::vector<uint32_t>& visible)
+    {
+        size_t next = first;
+        switch (backend) {
+#ifdef FRUSTUM_CULLER_AVX2
+        case FrustumCuller::Backend::AVX2:
+            next = CullAVX2(planes, arrays, first, end, visible);
+            break;
+#endif
+#ifdef FRUSTUM_CULLER_SSE
+        case FrustumCuller::Backend::SSE:
+            next = CullSSE(planes, arrays, first, end, visible);
+            break;
+#endif
+        default:
+            break;
+        }
+        CullScalar(planes, arrays, next, end, visible);
+    }
+}
+
+bool FrustumCuller::IsBackendAvailable(Backend backend)
+{
+    switch (backend) {
+    case Backend::Scalar:
+        return true;
+    case Backend::SSE:
+#ifdef FRUSTUM_CULLER_SSE
+        return true;
+#else
+        return false;
+#endif
+    case Backend::AVX2:
+#ifdef FRUSTUM_CULLER_AVX2
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+FrustumCuller::Backend FrustumCuller::GetBestBackend()
+{
+    if (IsBackendAvailable(Backend::AVX2))
+        return Backend::AVX2;
+    if (IsBackendAvailable(Backend::SSE))
+        return Backend::SSE;
+    return Backend::Scalar;
+}
+
+const char* FrustumCuller::GetBackendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::Scalar: return "Scalar";
+    case Backend::SSE:    return "SSE";
+    case Backend::AVX2:   return "AVX2";
+    default:              return "Unknown";
+    }
+}
+
+FrustumCuller::Stats FrustumCuller::Cull(const CullingSet& set, const Frustum& frustum, std::vector<uint32_t>& visible,
+    Backend backend, bool useHierarchy)
+{
+    Stats stats;
+    if (set.m_Ids.empty())
+        return stats;
+    if (!IsBackendAvailable(backend))
+        backend = Backend::Scalar;
+
+    const PlaneSet planes(frustum);
+    const Arrays arrays = { set.m_CenterX.data(), set.m_CenterY.data(), set.m_CenterZ.data(),
+        set.m_ExtentX.data(), set.m_ExtentY.data(), set.m_ExtentZ.data(), set.m_Radius.data(), set.m_Ids.data() };
+    const size_t visibleBefore = visible.size();
+
+    if (!useHierarchy || set.m_Nodes.empty()) {
+        CullRange(backend, planes, arrays, 0, set.m_Ids.size(), visible);
+        stats.tested = set.m_Ids.size();
+    }
+    else {
+        uint32_t stack[64];
+        int depth = 0;
+        stack[depth++] = 0;
+        while (depth > 0) {
+            const CullingSet::Node& node = set.m_Nodes[stack[--depth]];
+            stats.nodesVisited++;
+
+            const Containment containment = Classify(planes, node.center, node.extent);
+            if (containment == Containment::Outside)
+                continue;
+            if (containment == Containment::Inside) {
+                visible.insert(visible.end(), set.m_Ids.begin() + node.first, set.m_Ids.begin() + node.first + node.count);
+            }
+            else if (node.left == 0) {
+                CullRange(backend, planes, arrays, node.first, node.first + node.count, visible);
+                stats.tested += node.count;
+            }
+            else {
+                // Median splits keep the depth at log2(count / kLeafSize), far below the stack size
+                stack[depth++] = node.right;
+                stack[depth++] = node.left;
+            }
+        }
+    }
+
+    stats.visible = visible.size() - visibleBefore;
+    stats.culled = set.m_Ids.size() - stats.visible;
+    return stats;
+}
+
+int FrustumCuller::RunBenchmark(size_t instanceCount, int iterations, std::ostream& stream)
+{
+    // Random boxes around a camera at the origin looking down -Z, roughly a sixth of them visible
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.25f, 3.0f);
+
+    CullingSet set;
+    set.Reserve(instanceCount);
+    for (size_t i = 0; i < instanceCount; i++) {
+        Bounds bounds;
+        bounds.center = glm::vec3(position(random), position(random), position(random));
+        const glm::vec3 extent(size(random), size(random), size(random));
+        bounds.min = bounds.center - extent;
+        bounds.max = bounds.center + extent;
+        bounds.radius = glm::length(extent);
+        bounds.valid = true;
+        set.Add(static_cast<uint32_t>(i), bounds);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    set.Build();
+    const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = Frustum::FromMatrix(projection * view);
+
+    std::vector<uint32_t> reference;
+    Cull(set, frustum, reference, Backend::Scalar, false);
+    std::sort(reference.begin(), reference.end());
+
+    stream << "Frustum culling " << instanceCount << " instances, " << iterations << " iterations, "
+           << reference.size() << " visible, hierarchy of " << set.GetNodeCount() << " nodes built in "
+           << std::fixed << std::setprecision(3) << buildMs << " ms" << std::endl;
+
+    bool allMatch = true;
+    std::vector<uint32_t> visible;
+    visible.reserve(instanceCount);
+    for (Backend backend : { Backend::Scalar, Backend::SSE, Backend::AVX2 }) {
+        if (!IsBackendAvailable(backend)) {
+            stream << "  " << std::left << std::setw(7) << GetBackendName(backend) << "not compiled in" << std::endl;
+            continue;
+        }
+        for (bool useHierarchy : { false, true }) {
+            double bestMs = 1e30;
+            Stats stats;
+            for (int iteration = 0; iteration < std::max(iterations, 1); iteration++) {
+                visible.clear();
+                start = std::chrono::steady_clock::now();
+                stats = Cull(set, frustum, visible, backend, useHierarchy);
+                bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            std::sort(visible.begin(), visible.end());
+            const bool match = visible == reference;
+            allMatch = allMatch && match;
+
+            stream << "  " << std::left << std::setw(7) << GetBackendName(backend) << std::setw(10) << (useHierarchy ? "hierarchy" : "flat")
+                   << std::right << std::setw(9) << bestMs << " ms " << std::setw(7) << bestMs * 1e6 / instanceCount << " ns/instance, "
+                   << stats.tested << " tested, " << stats.nodesVisited << " nodes" << (match ? "" : "  MISMATCH") << std::endl;
+        }
+    }
+
+    if (!allMatch)
+        stream << "Culling results differ from the scalar reference" << std::endl;
+    return allMatch ? 0 : 1;
+}
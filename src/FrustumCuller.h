@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "Bounds.h"
+
+// View frustum as six planes, normals pointing inwards and normalized so plane distances are in
+// world units
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // Planes of the clip volume of viewProjection (Gribb/Hartmann), e.g. m_Proj * m_View
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+    // Scalar test of world space bounds, for the odd mesh. Conservative: may keep bounds that are
+    // just outside a corner of the frustum.
+    bool Intersects(const Bounds& bounds) const;
+};
+
+// World space bounds of many instances in structure of arrays layout, so the culling loops load
+// eight centers or extents at once. Build() sorts the instances into a bounding volume hierarchy
+// whose leaves are contiguous ranges of the arrays; whole branches are then accepted or rejected
+// with one test.
+class CullingSet {
+public:
+    static constexpr uint32_t kLeafSize = 64;
+
+    void Clear();
+    void Reserve(size_t count);
+    // id is what Cull reports for a visible instance
+    void Add(uint32_t id, const Bounds& worldBounds);
+    // Builds the hierarchy and the arrays, call after the last Add and before culling
+    void Build();
+
+    size_t GetCount() const { return m_Ids.size(); }
+    size_t GetNodeCount() const { return m_Nodes.size(); }
+
+private:
+    friend class FrustumCuller;
+
+    struct Pending {
+        uint32_t id;
+        glm::vec3 center;
+        glm::vec3 extent;
+        float radius;
+    };
+
+    struct Node {
+        glm::vec3 center;
+        glm::vec3 extent;
+        uint32_t first;     // First instance of the subtree, the subtree's instances are contiguous
+        uint32_t count;
+        uint32_t left;      // Children, both 0 for a leaf (the root is never a child)
+        uint32_t right;
+    };
+
+    uint32_t BuildNode(uint32_t first, uint32_t count);
+
+    std::vector<Pending> m_Pending;
+    std::vector<Node> m_Nodes;
+
+    // Instance arrays in hierarchy order. The sphere center is the box center, the radius is the
+    // sphere's and the extents are the box's half sizes.
+    std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+    std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+    std::vector<float> m_Radius;
+    std::vector<uint32_t> m_Ids;
+};
+
+// Frustum culling of a CullingSet. An instance is culled when its box or its sphere lies entirely
+// behind one of the planes. The SSE and AVX2 loops test four or eight instances per iteration and
+// are compiled in when the build targets those instruction sets (AVX2 with OPENGLTEST_AVX2, see
+// CMakeLists.txt); the scalar loop always exists and produces the same results.
+class FrustumCuller {
+public:
+    enum class Backend {
+        Scalar,
+        SSE,
+        AVX2,
+    };
+
+    struct Stats {
+        size_t tested = 0;          // Instances tested one by one
+        size_t visible = 0;
+        size_t culled = 0;
+        size_t nodesVisited = 0;
+    };
+
+    static bool IsBackendAvailable(Backend backend);
+    static Backend GetBestBackend();
+    static const char* GetBackendName(Backend backend);
+
+    // Appends the ids of the instances intersecting the frustum to visible. Without the hierarchy
+    // every instance is tested.
+    static Stats Cull(const CullingSet& set, const Frustum& frustum, std::vector<uint32_t>& visible,
+        Backend backend = GetBestBackend(), bool useHierarchy = true);
+
+    // Times every available backend with and without the hierarchy on random instances and checks
+    // them against the scalar loop. CPU only, needs no GL context. Returns the process exit code.
+    static int RunBenchmark(size_t instanceCount, int iterations, std::ostream& stream);
+};
@@ -0,0 +1,144 @@
+#include "GLDebug.h"
+#include "Renderer.h"
+#include "Hex.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    constexpr int kMaxReportsPerMessage = 5;  // Errors raised every frame would flood the console
+
+    enum class DebugOutput { None, KHR, ARB };
+
+    struct DebugState {
+        DebugOutput output = DebugOutput::None;
+        bool synchronous = false;
+
+        // Asynchronous debug output can call Report() from driver threads, concurrently
+        std::mutex mutex;
+        size_t errorCount = 0;
+        GLDebugError firstError;
+        std::unordered_map<unsigned int, int> reportCounts;
+    };
+
+    DebugState& State() {
+        static DebugState state;
+        return state;
+    }
+
+    void Report(unsigned int code, const char* message, bool isError) {
+        DebugState& state = State();
+        const GLCallSite site = GLDebug::GetLastCall();
+        std::unique_lock<std::mutex> lock(state.mutex);
+
+        if (isError) {
+            if (state.errorCount == 0)
+                state.firstError = GLDebugError{ code, message, site };
+            state.errorCount++;
+        }
+
+        int& reported = state.reportCounts[code];
+        if (reported > kMaxReportsPerMessage)
+            return;
+        if (++reported > kMaxReportsPerMessage) {
+            std::cout << "[OpenGL] (" << hex(code, 4) << ") reported " << kMaxReportsPerMessage << " times, ignoring further reports" << std::endl;
+            return;
+        }
+
+        std::cout << (isError ? "[OpenGL Error!] (" : "[OpenGL Warning] (") << hex(code, 4) << ") " << message;
+        if (site.call)
+            std::cout << (state.synchronous ? ", in " : ", near ") << site.call << ", " << site.file << ":" << site.line;
+        std::cout << std::endl;
+        lock.unlock();
+
+#ifdef _DEBUG
+        // Only a synchronous message is still inside the failing call
+        ASSERT(!(isError && state.synchronous))
+#endif
+    }
+
+    bool IsDebugContext() {
+        GLint flags = 0;
+        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+        return (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+    }
+
+    void GLAPIENTRY OnDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+        (void)source; (void)length; (void)userParam;
+
+        const bool isError = type == GL_DEBUG_TYPE_ERROR;
+        if (!isError && (severity == GL_DEBUG_SEVERITY_NOTIFICATION || severity == GL_DEBUG_SEVERITY_LOW))
+            return;
+        Report(id, message, isError);
+    }
+}
+
+void GLDebug::Init(bool synchronous)
+{
+#ifdef GL_ERRORS_CALLBACK
+    DebugState& state = State();
+    state.synchronous = synchronous;
+
+    if (GLEW_VERSION_4_3 || GLEW_KHR_debug) {
+        glEnable(GL_DEBUG_OUTPUT);
+        if (synchronous)
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        else
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(OnDebugMessage, nullptr);
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+        state.output = DebugOutput::KHR;
+    }
+    else if (GLEW_ARB_debug_output && IsDebugContext()) {
+        // ARB_debug_output has no GL_DEBUG_OUTPUT switch and stays silent outside debug contexts
+        if (synchronous)
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+        glDebugMessageCallbackARB(OnDebugMessage, nullptr);
+        state.output = DebugOutput::ARB;
+    }
+    else {
+        state.output = DebugOutput::None;
+        std::cout << "GL debug output unavailable, checking glGetError once per frame" << std::endl;
+        return;
+    }
+    std::cout << "GL errors reported through the debug callback (" << (synchronous ? "synchronous" : "asynchronous") << ")" << std::endl;
+#else
+    (void)synchronous;
+#endif
+}
+
+bool GLDebug::IsSynchronousRequested(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--gl-sync") == 0)
+            return true;
+    }
+    const char* environment = std::getenv("GL_DEBUG_SYNC");
+    return environment && *environment && std::strcmp(environment, "0") != 0;
+}
+
+void GLDebug::EndFrame()
+{
+#ifdef GL_ERRORS_CALLBACK
+    if (State().output != DebugOutput::None)
+        return;
+    while (GLenum error = glGetError())
+        Report(error, "glGetError at the end of the frame", true);
+#endif
+}
+
+size_t GLDebug::GetErrorCount()
+{
+    DebugState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.errorCount;
+}
+
+GLDebugError GLDebug::GetFirstError()
+{
+    DebugState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.firstError;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+// Where a GLCall/GLCallV was made from
+struct GLCallSite {
+    const char* call = nullptr;
+    const char* file = nullptr;
+    int line = 0;
+};
+
+// An error reported by the driver, with the last GLCall made before it was reported
+struct GLDebugError {
+    unsigned int code = 0;      // GL error enum when polled, the debug message id otherwise
+    std::string message;
+    GLCallSite site;
+};
+
+// Error checking for GL_ERRORS_CALLBACK builds (see Renderer.h). Instead of polling glGetError around
+// every call, GLCall/GLCallV only record their call site and the driver reports errors through the
+// KHR_debug (or ARB_debug_output) callback. Asynchronous output can arrive a few calls late, so the
+// reported site is the last call made before the message; synchronous output makes it exact at the cost
+// of serializing the driver, and is only turned on when asked for.
+// Asynchronous callbacks may run on driver threads, even several at once. The error state is locked,
+// but the call site is recorded without a lock, so it is best-effort there: it can be torn between
+// two calls made around the time the message arrives.
+// Without either extension errors are polled once per frame in EndFrame().
+class GLDebug {
+public:
+    // Installs the callback if this build uses GL_ERRORS_CALLBACK, a no-op in the other modes
+    static void Init(bool synchronous);
+
+    // True if the command line contains --gl-sync or GL_DEBUG_SYNC is set in the environment
+    static bool IsSynchronousRequested(int argc, char** argv);
+
+    // Relaxed stores, as cheap as plain ones on the platforms we build for
+    static inline void MarkCall(const char* call, const char* file, int line) {
+        s_LastCall.store(call, std::memory_order_relaxed);
+        s_LastFile.store(file, std::memory_order_relaxed);
+        s_LastLine.store(line, std::memory_order_relaxed);
+    }
+
+    static inline GLCallSite GetLastCall() {
+        GLCallSite site;
+        site.call = s_LastCall.load(std::memory_order_relaxed);
+        site.file = s_LastFile.load(std::memory_order_relaxed);
+        site.line = s_LastLine.load(std::memory_order_relaxed);
+        return site;
+    }
+
+    // Polls glGetError once when there's no debug output
+    static void EndFrame();
+
+    static size_t GetErrorCount();
+    // The first error since Init, only meaningful if GetErrorCount() > 0
+    static GLDebugError GetFirstError();
+
+private:
+    static inline std::atomic<const char*> s_LastCall{ nullptr };
+    static inline std::atomic<const char*> s_LastFile{ nullptr };
+    static inline std::atomic<int> s_LastLine{ 0 };
+};
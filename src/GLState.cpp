@@ -0,0 +1,308 @@
+#include "GLState.h"
+#include "Renderer.h"
+
+#include <unordered_map>
+
+namespace {
+    constexpr unsigned int kUnknown = 0xFFFFFFFFu;
+
+    constexpr unsigned int kTextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER };
+    constexpr int kTextureTargetCount = sizeof(kTextureTargets) / sizeof(kTextureTargets[0]);
+
+    constexpr unsigned int kCapabilities[] = { GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_PRIMITIVE_RESTART };
+    constexpr int kCapabilityCount = sizeof(kCapabilities) / sizeof(kCapabilities[0]);
+
+    struct UniformBufferBinding {
+        unsigned int buffer;
+        size_t offset, size;
+    };
+
+    enum class CapabilityState : unsigned char { Unknown, Disabled, Enabled };
+
+    struct CachedState {
+        unsigned int program = kUnknown;
+        unsigned int vertexArray = kUnknown;
+        unsigned int activeUnit = kUnknown;
+        unsigned int textures[GLState::kMaxTextureUnits][kTextureTargetCount];
+        UniformBufferBinding uniformBuffers[GLState::kMaxUniformBufferBindings];
+        CapabilityState capabilities[kCapabilityCount];
+        unsigned int restartIndex = kUnknown;
+        bool restartIndexKnown = false;     // kUnknown is a valid restart index
+
+        // Vertex array -> element buffer last bound into it
+        std::unordered_map<unsigned int, unsigned int> elementBuffers;
+
+        GLState::Counters counters;
+        GLState::Counters frameCounters;
+        GLState::Counters lastFrameCounters;
+
+        CachedState() { Invalidate(); }
+
+        void Invalidate() {
+            program = kUnknown;
+            vertexArray = kUnknown;
+            activeUnit = kUnknown;
+            for (auto& unit : textures)
+                for (unsigned int& texture : unit)
+                    texture = kUnknown;
+            for (UniformBufferBinding& binding : uniformBuffers)
+                binding = UniformBufferBinding{ kUnknown, 0, 0 };
+            for (CapabilityState& capability : capabilities)
+                capability = CapabilityState::Unknown;
+            restartIndexKnown = false;
+        }
+    };
+
+    CachedState& State() {
+        static CachedState state;
+        return state;
+    }
+
+    void Count(CachedState& state, GLState::Kind kind, bool issued) {
+        const int index = static_cast<int>(kind);
+        if (issued) {
+            state.counters.issued[index]++;
+            state.frameCounters.issued[index]++;
+        }
+        else {
+            state.counters.elided[index]++;
+            state.frameCounters.elided[index]++;
+        }
+    }
+
+    int TextureTargetIndex(unsigned int target) {
+        for (int i = 0; i < kTextureTargetCount; i++)
+            if (kTextureTargets[i] == target)
+                return i;
+        return -1;
+    }
+
+    int CapabilityIndex(unsigned int capability) {
+        for (int i = 0; i < kCapabilityCount; i++)
+            if (kCapabilities[i] == capability)
+                return i;
+        return -1;
+    }
+}
+
+uint64_t GLState::Counters::TotalIssued() const
+{
+    uint64_t total = 0;
+    for (uint64_t count : issued)
+        total += count;
+    return total;
+}
+
+uint64_t GLState::Counters::TotalElided() const
+{
+    uint64_t total = 0;
+    for (uint64_t count : elided)
+        total += count;
+    return total;
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+    CachedState& state = State();
+    const bool issue = state.program != program;
+    if (issue) {
+        GLCallV(glUseProgram(program));
+        state.program = program;
+    }
+    Count(state, Kind::Program, issue);
+}
+
+void GLState::BindVertexArray(unsigned int vertexArray)
+{
+    CachedState& state = State();
+    const bool issue = state.vertexArray != vertexArray;
+    if (issue) {
+        GLCallV(glBindVertexArray(vertexArray));
+        state.vertexArray = vertexArray;
+    }
+    Count(state, Kind::VertexArray, issue);
+}
+
+void GLState::BindElementBuffer(unsigned int buffer)
+{
+    CachedState& state = State();
+
+    // Without a known vertex array there's no way to tell which one the binding lands in, so none
+    // of the remembered element buffers can be trusted any more
+    if (state.vertexArray == kUnknown) {
+        GLCallV(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer));
+        state.elementBuffers.clear();
+        Count(state, Kind::ElementBuffer, true);
+        return;
+    }
+
+    auto it = state.elementBuffers.find(state.vertexArray);
+    const bool issue = it == state.elementBuffers.end() || it->second != buffer;
+    if (issue) {
+        GLCallV(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer));
+        state.elementBuffers[state.vertexArray] = buffer;
+    }
+    Count(state, Kind::ElementBuffer, issue);
+}
+
+void GLState::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    CachedState& state = State();
+    const int targetIndex = unit < kMaxTextureUnits ? TextureTargetIndex(target) : -1;
+
+    if (targetIndex >= 0 && state.textures[unit][targetIndex] == texture) {
+        Count(state, Kind::ActiveTexture, false);
+        Count(state, Kind::Texture, false);
+        return;
+    }
+
+    const bool switchUnit = state.activeUnit != unit;
+    if (switchUnit) {
+        GLCallV(glActiveTexture(GL_TEXTURE0 + unit));
+        state.activeUnit = unit;
+    }
+    Count(state, Kind::ActiveTexture, switchUnit);
+
+    GLCallV(glBindTexture(target, texture));
+    if (targetIndex >= 0)
+        state.textures[unit][targetIndex] = texture;
+    Count(state, Kind::Texture, true);
+}
+
+void GLState::BindUniformBuffer(unsigned int binding, unsigned int buffer, size_t offset, size_t size)
+{
+    CachedState& state = State();
+    if (binding < kMaxUniformBufferBindings) {
+        UniformBufferBinding& bound = state.uniformBuffers[binding];
+        if (bound.buffer == buffer && bound.offset == offset && bound.size == size) {
+            Count(state, Kind::UniformBuffer, false);
+            return;
+        }
+        bound = UniformBufferBinding{ buffer, offset, size };
+    }
+
+    if (size == 0) {
+        GLCallV(glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer));
+    }
+    else {
+        GLCallV(glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size)));
+    }
+    Count(state, Kind::UniformBuffer, true);
+}
+
+void GLState::SetCapability(unsigned int capability, bool enabled)
+{
+    CachedState& state = State();
+    const int index = CapabilityIndex(capability);
+    const CapabilityState wanted = enabled ? CapabilityState::Enabled : CapabilityState::Disabled;
+
+    const bool issue = index < 0 || state.capabilities[index] != wanted;
+    if (issue) {
+        if (enabled) {
+            GLCallV(glEnable(capability));
+        }
+        else {
+            GLCallV(glDisable(capability));
+        }
+        if (index >= 0)
+            state.capabilities[index] = wanted;
+    }
+    Count(state, Kind::Capability, issue);
+}
+
+void GLState::SetPrimitiveRestartIndex(unsigned int index)
+{
+    CachedState& state = State();
+    const bool issue = !state.restartIndexKnown || state.restartIndex != index;
+    if (issue) {
+        GLCallV(glPrimitiveRestartIndex(index));
+        state.restartIndex = index;
+        state.restartIndexKnown = true;
+    }
+    Count(state, Kind::Capability, issue);
+}
+
+void GLState::OnProgramDeleted(unsigned int program)
+{
+    // A deleted program stays in use until another one is bound, but its name may come back
+    CachedState& state = State();
+    if (state.program == program)
+        state.program = kUnknown;
+}
+
+void GLState::OnVertexArrayDeleted(unsigned int vertexArray)
+{
+    CachedState& state = State();
+    if (state.vertexArray == vertexArray)
+        state.vertexArray = 0;  // Deleting the bound vertex array reverts the binding to zero
+    state.elementBuffers.erase(vertexArray);
+}
+
+void GLState::OnBufferDeleted(unsigned int buffer)
+{
+    // Other vertex arrays keep the old buffer alive under this name, a new buffer reusing the name
+    // must not look bound to them
+    CachedState& state = State();
+    for (auto it = state.elementBuffers.begin(); it != state.elementBuffers.end();) {
+        if (it->second == buffer)
+            it = state.elementBuffers.erase(it);
+        else
+            ++it;
+    }
+    // Deleting a buffer unbinds it from the uniform block binding points
+    for (UniformBufferBinding& binding : state.uniformBuffers)
+        if (binding.buffer == buffer)
+            binding = UniformBufferBinding{ 0, 0, 0 };
+}
+
+void GLState::OnTextureDeleted(unsigned int texture)
+{
+    // Deleting a texture unbinds it from every unit
+    CachedState& state = State();
+    for (auto& unit : state.textures)
+        for (unsigned int& bound : unit)
+            if (bound == texture)
+                bound = 0;
+}
+
+void GLState::Invalidate()
+{
+    State().Invalidate();
+}
+
+void GLState::BeginFrame()
+{
+    CachedState& state = State();
+    state.Invalidate();
+    state.lastFrameCounters = state.frameCounters;
+    state.frameCounters = Counters();
+}
+
+const GLState::Counters& GLState::GetCounters()
+{
+    return State().counters;
+}
+
+const GLState::Counters& GLState::GetFrameCounters()
+{
+    return State().lastFrameCounters;
+}
+
+void GLState::ResetCounters()
+{
+    State().counters = Counters();
+}
+
+const char* GLState::GetKindName(Kind kind)
+{
+    switch (kind) {
+    case Kind::Program:       return "Program";
+    case Kind::VertexArray:   return "Vertex array";
+    case Kind::ElementBuffer: return "Element buffer";
+    case Kind::ActiveTexture: return "Active texture";
+    case Kind::Texture:       return "Texture";
+    case Kind::UniformBuffer: return "Uniform buffer";
+    case Kind::Capability:    return "Capability";
+    default:                  return "Unknown";
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Shadow copy of the GL state the renderer touches: current program, vertex array, element buffer,
+// active texture unit, texture bindings, uniform buffer bindings, a few capabilities and the primitive restart index. Every setter compares against the
+// cached value and only calls GL when it differs, and counts both outcomes.
+//
+// Anything that changes this state behind the cache's back (ImGui's backend, raw GL in a test) leaves
+// it stale, so BeginFrame() forgets the context state every frame. The element buffer is vertex array
+// state and is remembered per vertex array, which survives Invalidate().
+class GLState {
+public:
+    enum class Kind {
+        Program,
+        VertexArray,
+        ElementBuffer,
+        ActiveTexture,
+        Texture,
+        UniformBuffer,
+        Capability,
+        Count
+    };
+    static constexpr int kKindCount = static_cast<int>(Kind::Count);
+    static constexpr int kMaxTextureUnits = 32;
+    static constexpr int kMaxUniformBufferBindings = 16;   // GL 3.3 guarantees at least 36, the renderer uses a few
+
+    struct Counters {
+        uint64_t issued[kKindCount] = {};
+        uint64_t elided[kKindCount] = {};
+
+        uint64_t TotalIssued() const;
+        uint64_t TotalElided() const;
+    };
+
+    static void UseProgram(unsigned int program);
+    static void BindVertexArray(unsigned int vertexArray);
+    // Binds into the current vertex array
+    static void BindElementBuffer(unsigned int buffer);
+    // Switches the active unit only when the binding actually changes
+    static void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+    // Binds size bytes of buffer from offset to a uniform block binding point, size 0 binds all of it
+    static void BindUniformBuffer(unsigned int binding, unsigned int buffer, size_t offset = 0, size_t size = 0);
+    // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE and GL_PRIMITIVE_RESTART are cached, other capabilities
+    // pass straight through
+    static void SetCapability(unsigned int capability, bool enabled);
+    // Counted as a capability
+    static void SetPrimitiveRestartIndex(unsigned int index);
+
+    // Deleted names can be handed out again, so the cache must not keep claiming they're bound
+    static void OnProgramDeleted(unsigned int program);
+    static void OnVertexArrayDeleted(unsigned int vertexArray);
+    static void OnBufferDeleted(unsigned int buffer);
+    static void OnTextureDeleted(unsigned int texture);
+
+    // Forgets the context state so the next setter of each kind is issued
+    static void Invalidate();
+
+    // Invalidates and closes the counters of the previous frame
+    static void BeginFrame();
+
+    static const Counters& GetCounters();       // Since the last ResetCounters()
+    static const Counters& GetFrameCounters();  // Of the last frame closed by BeginFrame()
+    static void ResetCounters();
+
+    static const char* GetKindName(Kind kind);
+};
@@ -0,0 +1,328 @@
+#include "HeadlessRunner.h"
+#include "OffscreenContext.h"
+#include "Renderer.h"
+#include "Framebuffer.h"
+#include "GLState.h"
+#include "FrustumCuller.h"
+#include "MeshOptimizer.h"
+#include "ShaderCache.h"
+#include "AssetWatcher.h"
+
+#include "imgui.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+bool HeadlessRunner::IsRequested(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--headless") == 0 || std::strcmp(argv[i], "--benchmark") == 0 || std::strcmp(argv[i], "--cull-benchmark") == 0 ||
+            std::strcmp(argv[i], "--mesh-report") == 0 || std::strcmp(argv[i], "--shader-report") == 0)
+            return true;
+    }
+    return false;
+}
+
+void HeadlessRunner::PrintUsage() {
+    std::cout << "Usage: OpenGLTest --headless --test <name> [--frames <n>] [--size <width>x<height>]\n"
+                 "                  [--output <directory>] [--dump-every <n>] [--watch]\n"
+                 "       OpenGLTest --benchmark [--tests <name,name,...>] [--warmup <n>] [--frames <n>]\n"
+                 "                  [--size <width>x<height>] [--json <file>] [--csv <file>]\n"
+                 "       OpenGLTest --cull-benchmark [--instances <n>] [--frames <n>]\n"
+                 "       OpenGLTest --mesh-report [--models <directory>]\n"
+                 "       OpenGLTest --shader-report [--shaders <directory>]\n"
+                 "       OpenGLTest --headless --list-tests\n"
+                 "  --gl-sync     Report GL errors synchronously, at the failing call (GL_ERRORS_CALLBACK builds)\n"
+                 "  --frames      Frames to render, or to measure with --benchmark (default 1 / 300)\n"
+                 "  --size        Framebuffer size (default 1280x720)\n"
+                 "  --output      Directory the PNG frames are written to (default frames)\n"
+                 "  --dump-every  Write every n-th frame, 0 writes none (default 1)\n"
+                 "  --watch       Reload shaders, textures and models under res/ when they change on disk\n"
+                 "  --tests       Tests to benchmark, all registered tests by default\n"
+                 "  --warmup      Unmeasured frames rendered before measuring (default 30)\n"
+                 "  --json        Benchmark results file (default benchmark.json)\n"
+                 "  --csv         Also write the benchmark results as CSV\n"
+                 "  --instances   Instances culled per iteration by --cull-benchmark, on the CPU only (default 100000),\n"
+                 "                --frames sets the iterations (default 20)\n"
+                 "  --models      Directory whose OBJ files --mesh-report analyzes (default res/models)\n"
+                 "  --shaders     Directory whose .shader files --shader-report creates, recursively (default res/shader)" << std::endl;
+}
+
+bool HeadlessRunner::ParseArguments(int argc, char** argv, HeadlessOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--headless") {
+            continue;
+        }
+        else if (argument == "--benchmark") {
+            options.benchmark = true;
+        }
+        else if (argument == "--tests" && hasValue) {
+            std::string list = argv[++i];
+            for (size_t start = 0, comma; start <= list.size(); start = comma + 1) {
+                comma = list.find(',', start);
+                if (comma == std::string::npos)
+                    comma = list.size();
+                if (comma > start)
+                    options.benchmarkOptions.tests.push_back(list.substr(start, comma - start));
+            }
+        }
+        else if (argument == "--cull-benchmark") {
+            options.cullBenchmark = true;
+        }
+        else if (argument == "--mesh-report") {
+            options.meshReport = true;
+        }
+        else if (argument == "--shader-report") {
+            options.shaderReport = true;
+        }
+        else if (argument == "--shaders" && hasValue) {
+            options.shaderDirectory = argv[++i];
+        }
+        else if (argument == "--models" && hasValue) {
+            options.modelDirectory = argv[++i];
+        }
+        else if (argument == "--instances" && hasValue) {
+            options.cullInstances = std::atoi(argv[++i]);
+        }
+        else if (argument == "--warmup" && hasValue) {
+            options.benchmarkOptions.warmupFrames = std::atoi(argv[++i]);
+        }
+        else if (argument == "--json" && hasValue) {
+            options.benchmarkOptions.jsonPath = argv[++i];
+        }
+        else if (argument == "--csv" && hasValue) {
+            options.benchmarkOptions.csvPath = argv[++i];
+        }
+        else if (argument == "--gl-sync") {
+            options.synchronousGLErrors = true;
+        }
+        else if (argument == "--watch") {
+            options.watchAssets = true;
+        }
+        else if (argument == "--list-tests") {
+            options.listTests = true;
+        }
+        else if (argument == "--test" && hasValue) {
+            options.testName = argv[++i];
+        }
+        else if (argument == "--frames" && hasValue) {
+            options.frames = std::atoi(argv[++i]);
+        }
+        else if (argument == "--dump-every" && hasValue) {
+            options.dumpEvery = std::atoi(argv[++i]);
+        }
+        else if (argument == "--output" && hasValue) {
+            options.outputDirectory = argv[++i];
+        }
+        else if (argument == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+                std::cerr << "Invalid --size, expected <width>x<height>: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Unknown or incomplete argument: " << argument << std::endl;
+            PrintUsage();
+            return false;
+        }
+    }
+
+    if (options.meshReport || options.shaderReport)
+        return true;
+
+    if (options.cullBenchmark) {
+        if (options.frames < 0)
+            options.frames = 20;
+        if (options.cullInstances <= 0 || options.frames <= 0) {
+            std::cerr << "Instance and iteration counts must be positive" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    if (options.frames < 0)
+        options.frames = options.benchmark ? options.benchmarkOptions.measuredFrames : 1;
+    options.benchmarkOptions.measuredFrames = options.frames;
+
+    if (!options.listTests && !options.benchmark && options.testName.empty()) {
+        std::cerr << "A headless run needs --test <name>" << std::endl;
+        PrintUsage();
+        return false;
+    }
+    if (options.width <= 0 || options.height <= 0 || options.dumpEvery < 0 || options.benchmarkOptions.warmupFrames < 0) {
+        std::cerr << "Frame counts and sizes must be positive" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int HeadlessRunner::Run(const HeadlessOptions& options, const std::function<void(test::TestMenu&)>& registerTests) {
+    // Runs on the CPU alone, so it works where no GL context can be created
+    if (options.cullBenchmark)
+        return FrustumCuller::RunBenchmark(static_cast<size_t>(options.cullInstances), options.frames, std::cout);
+    if (options.meshReport)
+        return MeshOptimizer::RunAnalyzer(options.modelDirectory, std::cout);
+
+    OffscreenContext context(options.width, options.height);
+    if (!context.IsValid())
+        return 1;
+
+    // A GLX build of GLEW reports the missing X display after it has loaded the entry points, which
+    // is expected with an EGL context
+    GLenum glewStatus = glewInit();
+    if (glewStatus != GLEW_OK && glewStatus != GLEW_ERROR_NO_GLX_DISPLAY) {
+        std::cout << "Failed to initialize GLEW!" << std::endl;
+        return 1;
+    }
+
+    std::cout << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+    GLDebug::Init(options.synchronousGLErrors);
+
+    if (options.shaderReport)
+        return ShaderCache::RunReport(options.shaderDirectory, std::cout);
+
+    // Tests look up ImGui windows in their constructors, so a context has to exist even though
+    // nothing is drawn with it
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::GetIO().DisplaySize = ImVec2(static_cast<float>(options.width), static_cast<float>(options.height));
+
+    int exitCode = 0;
+    { // GL objects must go before the context does
+
+        GLState::SetCapability(GL_BLEND, true);
+        GLCallV(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+        Framebuffer framebuffer(options.width, options.height);
+
+        test::Test* currentTest = nullptr;
+        test::TestMenu testMenu(currentTest);
+        registerTests(testMenu);
+
+        if (options.listTests) {
+            for (const std::string& name : testMenu.GetTestNames())
+                std::cout << name << std::endl;
+        }
+        else if (options.benchmark) {
+            exitCode = RunBenchmark(testMenu, framebuffer, options) ? 0 : 1;
+        }
+        else if (test::Test* test = testMenu.CreateTest(options.testName)) {
+            if (options.watchAssets)
+                AssetWatcher::Start("res");
+            exitCode = RunFrames(*test, framebuffer, options) ? 0 : 1;
+            delete test;
+            AssetWatcher::Stop();
+        }
+        else {
+            std::cerr << "No test named \"" << options.testName << "\", use --list-tests to see them" << std::endl;
+            exitCode = 1;
+        }
+    }
+
+    // Only GL_ERRORS_CALLBACK builds get here with errors, polling builds stop at the failing call
+    if (GLDebug::GetErrorCount() > 0) {
+        const GLDebugError error = GLDebug::GetFirstError();
+        std::cerr << GLDebug::GetErrorCount() << " GL error(s), the first near " << (error.site.call ? error.site.call : "an unchecked call");
+        if (error.site.file)
+            std::cerr << " (" << error.site.file << ":" << error.site.line << ")";
+        std::cerr << ": " << error.message << std::endl;
+        exitCode = 1;
+    }
+
+    ImGui::DestroyContext();
+    return exitCode;
+}
+
+bool HeadlessRunner::RunFrames(test::Test& test, Framebuffer& framebuffer, const HeadlessOptions& options) {
+    if (options.dumpEvery > 0) {
+        std::error_code error;
+        fs::create_directories(options.outputDirectory, error);
+        if (error) {
+            std::cerr << "Failed to create output directory " << options.outputDirectory << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    // File names use the test name with anything but letters and digits replaced
+    std::string filePrefix = options.testName;
+    for (char& c : filePrefix) {
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+            c = '_';
+    }
+
+    test.OnWindowResize(options.width, options.height);
+    stbi_flip_vertically_on_write(1); // glReadPixels returns the bottom row first
+
+    const float deltaTime = 1.0f / 60.0f; // Fixed step, so runs are reproducible
+    std::vector<unsigned char> pixels;
+    int written = 0;
+
+    for (int frame = 0; frame < options.frames; frame++) {
+        RenderFrame(test, framebuffer, deltaTime);
+
+        if (options.dumpEvery > 0 && frame % options.dumpEvery == 0) {
+            framebuffer.ReadPixels(pixels);
+
+            char fileName[32];
+            std::snprintf(fileName, sizeof(fileName), "_%05d.png", frame);
+            const std::string path = (fs::path(options.outputDirectory) / (filePrefix + fileName)).string();
+            if (!stbi_write_png(path.c_str(), framebuffer.GetWidth(), framebuffer.GetHeight(), 4, pixels.data(), framebuffer.GetWidth() * 4)) {
+                std::cerr << "Failed to write " << path << std::endl;
+                return false;
+            }
+            written++;
+        }
+    }
+    GLCallV(glFinish());
+
+    std::cout << "Rendered " << options.frames << " frames of \"" << options.testName << "\" at " << options.width << "x"
+        << options.height << ", wrote " << written << " to " << options.outputDirectory << std::endl;
+    return true;
+}
+
+void HeadlessRunner::RenderFrame(test::Test& test, Framebuffer& framebuffer, float deltaTime) {
+    AssetWatcher::Dispatch();
+    GLState::BeginFrame();
+    framebuffer.Bind();
+
+    GLCallV(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+    GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+    test.OnUpdate(deltaTime);
+    test.OnRender();
+
+    framebuffer.Unbind();
+    GLDebug::EndFrame();
+}
+
+bool HeadlessRunner::RunBenchmark(const test::TestMenu& testMenu, Framebuffer& framebuffer, const HeadlessOptions& options) {
+    const BenchmarkOptions& benchmarkOptions = options.benchmarkOptions;
+    const std::vector<std::string> names = benchmarkOptions.tests.empty() ? testMenu.GetTestNames() : benchmarkOptions.tests;
+
+    BenchmarkRunner runner(benchmarkOptions);
+    bool success = true;
+    for (const std::string& name : names) {
+        std::cout << "[Benchmark] Running " << name << std::endl;
+        success = runner.Run(name, testMenu, framebuffer).frames > 0 && success;
+    }
+
+    runner.PrintSummary(std::cout);
+    if (!benchmarkOptions.jsonPath.empty())
+        success = runner.WriteJSON(benchmarkOptions.jsonPath, options.width, options.height) && success;
+    if (!benchmarkOptions.csvPath.empty())
+        success = runner.WriteCSV(benchmarkOptions.csvPath) && success;
+    return success;
+}
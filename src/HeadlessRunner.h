@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include "tests/Test.h"
+#include "BenchmarkRunner.h"
+
+// Options of a headless run, see HeadlessRunner::PrintUsage
+struct HeadlessOptions {
+    std::string testName;
+    int frames = -1;                        // Defaults to 1, or BenchmarkOptions::measuredFrames with --benchmark
+    int width = 1280;
+    int height = 720;
+    int dumpEvery = 1;                      // Write every n-th frame as a PNG, 0 writes none
+    std::string outputDirectory = "frames";
+    bool listTests = false;
+    bool synchronousGLErrors = false;       // --gl-sync, see GLDebug
+    bool watchAssets = false;               // --watch, hot reload res/ between frames, see AssetWatcher
+
+    bool benchmark = false;                 // Time registered tests instead of dumping frames
+    BenchmarkOptions benchmarkOptions;
+
+    bool cullBenchmark = false;             // CPU only frustum culling benchmark, see FrustumCuller::RunBenchmark
+    int cullInstances = 100000;
+
+    bool meshReport = false;                // CPU only vertex cache report, see MeshOptimizer::RunAnalyzer
+    std::string modelDirectory = "res/models";
+
+    bool shaderReport = false;              // Cold versus warm shader creation, see ShaderCache::RunReport
+    std::string shaderDirectory = "res/shader";
+};
+
+// Runs one registered test into an offscreen Framebuffer for a fixed number of frames, without a
+// window or ImGui rendering, and dumps the frames to disk. With --benchmark it times registered tests
+// through BenchmarkRunner instead. Meant for CI machines without a display.
+class HeadlessRunner {
+public:
+    // True if the command line contains --headless, --benchmark, --cull-benchmark, --mesh-report or --shader-report
+    static bool IsRequested(int argc, char** argv);
+    static bool ParseArguments(int argc, char** argv, HeadlessOptions& options);
+    static void PrintUsage();
+
+    // Creates the offscreen context, registers the tests and runs options.testName. Returns the process exit code.
+    static int Run(const HeadlessOptions& options, const std::function<void(test::TestMenu&)>& registerTests);
+
+    // One frame of a test into the framebuffer, the same way the windowed loop renders it
+    static void RenderFrame(test::Test& test, Framebuffer& framebuffer, float deltaTime);
+
+private:
+    static bool RunFrames(test::Test& test, Framebuffer& framebuffer, const HeadlessOptions& options);
+    static bool RunBenchmark(const test::TestMenu& testMenu, Framebuffer& framebuffer, const HeadlessOptions& options);
+};
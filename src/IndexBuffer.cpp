@@ -1,28 +1,115 @@
 #include "IndexBuffer.h"
 
 #include "Renderer.h"
+#include "GLState.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+    // data narrowed to the buffer's index type, restarts mapped to the type's restart index
+    template<typename T>
+    std::vector<T> Narrow(const unsigned int* data, unsigned int count)
+    {
+        std::vector<T> narrowed(count);
+        for (unsigned int i = 0; i < count; i++)
+            narrowed[i] = data[i] == IndexBuffer::kRestartIndex ? static_cast<T>(~T(0)) : static_cast<T>(data[i]);
+        return narrowed;
+    }
+
+    void Upload(unsigned int type, const unsigned int* data, unsigned int first, unsigned int count, bool allocate)
+    {
+        const void* bytes = data;
+        std::vector<uint8_t> bytes8;
+        std::vector<uint16_t> bytes16;
+        if (data && type == GL_UNSIGNED_BYTE) {
+            bytes8 = Narrow<uint8_t>(data, count);
+            bytes = bytes8.data();
+        }
+        else if (data && type == GL_UNSIGNED_SHORT) {
+            bytes16 = Narrow<uint16_t>(data, count);
+            bytes = bytes16.data();
+        }
+
+        const unsigned int size = IndexBuffer::GetIndexSize(type);
+        if (allocate) {
+            GLCallV(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * size, bytes, GL_STATIC_DRAW));  // Linking our buffer with the pos. data
+        }
+        else {
+            GLCallV(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * size, count * size, bytes));
+        }
+    }
+}
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-    :m_Count(count)
+    :m_Count(count), m_Type(GL_UNSIGNED_INT), m_Primitive(GL_TRIANGLES)
 {
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
     
     GLCallV(glGenBuffers(1, &m_RendererID));
-    GLCallV(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-    GLCallV(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));  // Linking our buffer with the pos. data
+    GLState::BindElementBuffer(m_RendererID);
+    Upload(m_Type, data, 0, count, true);
+}
+
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, unsigned int vertexCount, unsigned int primitive)
+    :m_Count(count), m_Type(ChooseType(vertexCount)), m_Primitive(primitive)
+{
+    GLCallV(glGenBuffers(1, &m_RendererID));
+    GLState::BindElementBuffer(m_RendererID);
+    Upload(m_Type, data, 0, count, true);
 }
 
 IndexBuffer::~IndexBuffer()
 {
     GLCallV(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
+}
+
+void IndexBuffer::SetSubData(unsigned int first, const unsigned int* data, unsigned int count)
+{
+    // The element binding belongs to the current VAO, so callers bind the VAO this buffer is used with first
+    Bind();
+    Upload(m_Type, data, first, count, false);
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCallV(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLState::BindElementBuffer(m_RendererID);
 }
 
 void IndexBuffer::UnBind() const
 {
-    GLCallV(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-}
\ No newline at end of file
+    GLState::BindElementBuffer(0);
+}
+
+unsigned int IndexBuffer::ChooseType(unsigned int vertexCount)
+{
+    // The largest value of each type is the restart index, so it can't address a vertex
+    if (vertexCount <= 0xFFu)
+        return GL_UNSIGNED_BYTE;
+    if (vertexCount <= 0xFFFFu)
+        return GL_UNSIGNED_SHORT;
+    return GL_UNSIGNED_INT;
+}
+
+unsigned int IndexBuffer::GetIndexSize(unsigned int type)
+{
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE:	return 1;
+        case GL_UNSIGNED_SHORT:	return 2;
+        case GL_UNSIGNED_INT:	return 4;
+    }
+    ASSERT(false);
+    return 0;
+}
+
+unsigned int IndexBuffer::GetRestartIndex(unsigned int type)
+{
+    switch (type)
+    {
+        case GL_UNSIGNED_BYTE:	return 0xFFu;
+        case GL_UNSIGNED_SHORT:	return 0xFFFFu;
+        default:				return 0xFFFFFFFFu;
+    }
+}
@@ -1,16 +1,45 @@
 #pragma once
 
+#include <GL/glew.h>
+
+// count indices starting at index first, e.g. a meshlet or several adjacent ones
+struct IndexRange
+{
+	unsigned int first;
+	unsigned int count;
+};
+
 class IndexBuffer
 {
 private:
 	unsigned int m_RendererID;
 	unsigned int m_Count;
+	unsigned int m_Type;		// GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int m_Primitive;	// GL_TRIANGLES or GL_TRIANGLE_STRIP
 public:
-	IndexBuffer(const unsigned int* data, unsigned int size);
+	// Marks the end of a strip in the indices handed to the buffer, stored as the largest value of the index type
+	static constexpr unsigned int kRestartIndex = 0xFFFFFFFFu;
+
+	// 32 bit triangle list indices
+	IndexBuffer(const unsigned int* data, unsigned int count);
+	// Indices into vertexCount vertices, stored in the smallest type that holds all of them and still
+	// leaves its largest value free for the restart index. Strips restart at every kRestartIndex.
+	IndexBuffer(const unsigned int* data, unsigned int count, unsigned int vertexCount, unsigned int primitive = GL_TRIANGLES);
 	~IndexBuffer();
 
+	// Overwrites count indices starting at index first, e.g. to fill a buffer created with null data
+	void SetSubData(unsigned int first, const unsigned int* data, unsigned int count);
+
 	void Bind() const;
 	void UnBind() const;
 
 	inline unsigned int GetCount() const { return m_Count; }
-};
\ No newline at end of file
+	inline unsigned int GetType() const { return m_Type; }
+	inline unsigned int GetPrimitive() const { return m_Primitive; }
+	inline unsigned int GetIndexSize() const { return GetIndexSize(m_Type); }
+	inline unsigned int GetRestartIndex() const { return GetRestartIndex(m_Type); }
+
+	static unsigned int ChooseType(unsigned int vertexCount);
+	static unsigned int GetIndexSize(unsigned int type);
+	static unsigned int GetRestartIndex(unsigned int type);
+};
@@ -0,0 +1,23 @@
+#include "InstanceBuffer.h"
+
+#include <atomic>
+
+static std::atomic<uint64_t> s_NextSerial{ 1 };
+
+InstanceBuffer::InstanceBuffer()
+    : m_Buffer(std::make_unique<VertexBuffer>(nullptr, 0)), m_Layout(1), m_Count(0), m_Serial(s_NextSerial++)
+{
+    m_Layout.Push<glm::mat4>(1);
+}
+
+InstanceBuffer::InstanceBuffer(const std::vector<glm::mat4>& transforms)
+    : InstanceBuffer()
+{
+    SetTransforms(transforms);
+}
+
+void InstanceBuffer::SetTransforms(const glm::mat4* transforms, size_t count)
+{
+    m_Buffer->SetData(transforms, static_cast<unsigned int>(count * sizeof(glm::mat4)));
+    m_Count = count;
+}
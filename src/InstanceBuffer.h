@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+// Per-instance model matrices for Model::DrawInstanced. Each matrix is a mat4 vertex attribute with a
+// divisor of 1 at locations kFirstAttribute..kFirstAttribute + 3, see the INSTANCING variant of model_shader.shader.
+class InstanceBuffer {
+public:
+    static constexpr unsigned int kFirstAttribute = 3; // After the Vertex position, normal and texture coordinates
+
+    InstanceBuffer();
+    InstanceBuffer(const std::vector<glm::mat4>& transforms);
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    void SetTransforms(const glm::mat4* transforms, size_t count);
+    void SetTransforms(const std::vector<glm::mat4>& transforms) { SetTransforms(transforms.data(), transforms.size()); }
+
+    size_t GetCount() const { return m_Count; }
+    const VertexBuffer& GetBuffer() const { return *m_Buffer; }
+    const VertexBufferLayout& GetLayout() const { return m_Layout; }
+
+    // Unique for every InstanceBuffer ever created. A Mesh remembers the serial its VAO is attached
+    // to, buffer names and addresses can both be reused.
+    uint64_t GetSerial() const { return m_Serial; }
+
+private:
+    std::unique_ptr<VertexBuffer> m_Buffer;
+    VertexBufferLayout m_Layout;
+    size_t m_Count;
+    uint64_t m_Serial;
+};
@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+    : m_Data(nullptr), m_Size(0), m_IsOpen(false), m_FileHandle(INVALID_HANDLE_VALUE), m_MappingHandle(nullptr)
+{
+    m_FileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_FileHandle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open file for mapping: " << path << std::endl;
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_FileHandle, &size)) {
+        std::cerr << "Failed to query file size: " << path << std::endl;
+        return;
+    }
+    m_Size = static_cast<size_t>(size.QuadPart);
+    m_IsOpen = true;
+
+    if (m_Size == 0)
+        return; // Nothing to map, an empty view is still a valid file
+
+    m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_MappingHandle)
+        m_Data = static_cast<const char*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+
+    if (!m_Data) {
+        std::cerr << "Failed to map file: " << path << std::endl;
+        m_Size = 0;
+        m_IsOpen = false;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data)
+        UnmapViewOfFile(m_Data);
+    if (m_MappingHandle)
+        CloseHandle(m_MappingHandle);
+    if (m_FileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(m_FileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : m_Data(nullptr), m_Size(0), m_IsOpen(false), m_FileDescriptor(-1)
+{
+    m_FileDescriptor = open(path.c_str(), O_RDONLY);
+    if (m_FileDescriptor < 0) {
+        std::cerr << "Failed to open file for mapping: " << path << std::endl;
+        return;
+    }
+
+    struct stat info;
+    if (fstat(m_FileDescriptor, &info) != 0) {
+        std::cerr << "Failed to query file size: " << path << std::endl;
+        return;
+    }
+    m_Size = static_cast<size_t>(info.st_size);
+    m_IsOpen = true;
+
+    if (m_Size == 0)
+        return; // Nothing to map, an empty view is still a valid file
+
+    void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to map file: " << path << std::endl;
+        m_Size = 0;
+        m_IsOpen = false;
+        return;
+    }
+    madvise(data, m_Size, MADV_SEQUENTIAL);
+    m_Data = static_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data)
+        munmap(const_cast<char*>(m_Data), m_Size);
+    if (m_FileDescriptor >= 0)
+        close(m_FileDescriptor);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The view stays valid for the lifetime of the object.
+class MappedFile {
+public:
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline bool IsOpen() const { return m_IsOpen; }
+    inline const char* GetData() const { return m_Data; }
+    inline size_t GetSize() const { return m_Size; }
+
+private:
+    const char* m_Data;
+    size_t m_Size;
+    bool m_IsOpen;
+
+#ifdef _WIN32
+    void* m_FileHandle;     // HANDLE, kept as void* so Windows.h stays out of this header
+    void* m_MappingHandle;
+#else
+    int m_FileDescriptor;
+#endif
+};
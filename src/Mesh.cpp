@@ -1,47 +1,164 @@
 #include "Mesh.h"
-#include "Renderer.h" // For calling renderer.Draw()
+#include "MeshOptimizer.h"
+
+#include <algorithm>
 
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
     : vertices(vertices), indices(indices)
 {
-    SetupMesh();
+    m_Bounds = Bounds::FromVertices(this->vertices.data(), this->vertices.size());
+    SetupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+}
+
+Mesh::Mesh(const MeshGeometry& geometry, const MeshUploadOptions& options)
+    : m_Format(options.vertexFormat)
+{
+    m_Bounds = geometry.bounds ? *geometry.bounds : Bounds::FromVertices(geometry.vertices, geometry.vertexCount);
+    SetMeshlets(geometry.meshlets, geometry.meshletCount);
+
+    // The levels follow the full mesh in the loader's index buffer, already shifted past its vertices
+    m_Lods.assign(1, MeshLod{ 0, static_cast<uint32_t>(geometry.indexCount), 0.0f, static_cast<uint32_t>(geometry.indexCount / 3) });
+    for (size_t level = 0; level < geometry.lodCount && m_Lods.size() < kMaxLodLevels; level++)
+        m_Lods.push_back(geometry.lods[level]);
+    const unsigned int* indexData = geometry.indices;
+    size_t indexCount = geometry.indexCount + (geometry.lodCount > 0 ? geometry.lodIndexCount : 0);
+    const size_t lodVertexCount = geometry.lodCount > 0 ? geometry.lodVertexCount : 0;
+    const size_t vertexCount = geometry.vertexCount + lodVertexCount;
+
+    unsigned int primitive = GL_TRIANGLES;
+    std::vector<unsigned int> strips;
+    if (options.triangleStrips) {
+        // One run of strips per meshlet so culling still works, then one per level
+        std::vector<IndexRange> ranges;
+        for (const Meshlet& meshlet : m_Meshlets)
+            ranges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+        if (ranges.empty())
+            ranges.push_back({ 0, static_cast<unsigned int>(geometry.indexCount) });
+        const size_t fullDetailRanges = ranges.size();
+        for (size_t level = 1; level < m_Lods.size(); level++)
+            ranges.push_back({ m_Lods[level].firstIndex, m_Lods[level].indexCount });
+
+        strips = MeshOptimizer::GenerateStrips(indexData, vertexCount, ranges, IndexBuffer::kRestartIndex);
+        if (!strips.empty() && strips.size() < indexCount) {
+            for (size_t i = 0; i < m_Meshlets.size(); i++) {
+                m_Meshlets[i].firstIndex = ranges[i].first;
+                m_Meshlets[i].indexCount = ranges[i].count;
+            }
+            m_Lods[0].indexCount = ranges[fullDetailRanges - 1].first + ranges[fullDetailRanges - 1].count;
+            for (size_t level = 1; level < m_Lods.size(); level++) {
+                m_Lods[level].firstIndex = ranges[fullDetailRanges + level - 1].first;
+                m_Lods[level].indexCount = ranges[fullDetailRanges + level - 1].count;
+            }
+            indexData = strips.data();
+            indexCount = strips.size();
+            primitive = GL_TRIANGLE_STRIP;
+        }
+    }
+
+    if (m_Format == VertexFormat::Packed && geometry.packedVertices && geometry.quantization) {
+        m_Quantization = *geometry.quantization;
+        SetupMesh(geometry.packedVertices, vertexCount, indexData, indexCount, primitive);
+    }
+    else if (m_Format == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed;
+        m_Quantization = PackVertices(geometry, m_Bounds, packed);
+        SetupMesh(packed.data(), vertexCount, indexData, indexCount, primitive);
+    }
+    else if (lodVertexCount == 0) {
+        SetupMesh(geometry.vertices, geometry.vertexCount, indexData, indexCount, primitive);
+    }
+    else {
+        SetupMesh(nullptr, vertexCount, indexData, indexCount, primitive);
+        m_VBO->SetSubData(0, geometry.vertices, static_cast<unsigned int>(geometry.vertexCount * sizeof(Vertex)));
+        m_VBO->SetSubData(static_cast<unsigned int>(geometry.vertexCount * sizeof(Vertex)), geometry.lodVertices,
+            static_cast<unsigned int>(lodVertexCount * sizeof(Vertex)));
+    }
+}
+
+VertexQuantization Mesh::PackVertices(const MeshGeometry& geometry, const Bounds& bounds, std::vector<PackedVertex>& packed) {
+    // Simplification keeps positions, but the grid covers the levels too in case they ever don't
+    const VertexQuantization quantization = VertexQuantization::FromBounds(
+        Bounds::Merge(bounds, Bounds::FromVertices(geometry.lodVertices, geometry.lodVertexCount)));
+    packed.resize(geometry.vertexCount + geometry.lodVertexCount);
+    VertexPacker::Pack(geometry.vertices, geometry.vertexCount, quantization, packed.data());
+    VertexPacker::Pack(geometry.lodVertices, geometry.lodVertexCount, quantization, packed.data() + geometry.vertexCount);
+    return quantization;
 }
 
-void Mesh::SetupMesh() {
+void Mesh::SetupMesh(const void* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount, unsigned int primitive) {
+    if (m_Lods.empty())
+        m_Lods.assign(1, MeshLod{ 0, static_cast<uint32_t>(indexCount), 0.0f, static_cast<uint32_t>(indexCount / 3) });
+    m_VertexBytes = vertexCount * VertexPacker::GetVertexSize(m_Format);
+
     // Create our unique pointers for VAO, VBO, and IBO
     m_VAO = std::make_unique<VertexArray>();
-    if (!vertices.empty()) {
-        m_VBO = std::make_unique<VertexBuffer>(vertices.data(), vertices.size() * sizeof(Vertex));
+    if (vertexCount > 0) {
+        m_VBO = std::make_unique<VertexBuffer>(vertexData, static_cast<unsigned int>(m_VertexBytes));
     }
     else {
         std::cerr << "Error: vertices is empty, cannot create VertexBuffer.\n";
     }
-    m_IBO = std::make_unique<IndexBuffer>(indices.data(), indices.size());
+    // Created with the VAO bound so the element binding lands in it, not in whichever VAO drew last
+    m_VAO->Bind();
+    m_IBO = std::make_unique<IndexBuffer>(indexData, static_cast<unsigned int>(indexCount), static_cast<unsigned int>(vertexCount), primitive);
+
+    // Add the vertex buffer to the VAO with the layout of Vertex or PackedVertex
+    m_VAO->AddBuffer(*m_VBO, VertexPacker::GetLayout(m_Format));
+}
 
-    // Set up the layout for the vertex data.
-    // For example, if Vertex consists of Position (vec3), Normal (vec3), TexCoords (vec2):
-    VertexBufferLayout layout;
-    layout.Push<float>(3); // Position: 3 floats
-    // Uncomment the next two lines if your Vertex struct has normals and texture coordinates.
-    layout.Push<float>(3); // Normal: 3 floats
-    layout.Push<float>(2); // TexCoords: 2 floats
+RenderQueue::Command Mesh::Submit(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix) {
+    const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(m_Bounds.center, 1.0f));
+    ObjectUniforms object;
+    object.model = modelMatrix;
+    object.positionScale = glm::vec4(m_Quantization.scale, 0.0f);
+    object.positionOffset = glm::vec4(m_Quantization.offset, 0.0f);
+    return queue.Submit(RenderQueue::Pass::Opaque, shader, *m_VAO, *m_IBO, center).Object(object);
+}
 
-    // Add the vertex buffer to the VAO with the layout
-    m_VAO->AddBuffer(*m_VBO, layout);
+RenderQueue::Command Mesh::Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix) {
+    // Level 0 only, the levels of detail follow it in the index buffer. The queue binds the shader,
+    // VAO and IBO through GLState, so consecutive meshes only pay for what actually changes.
+    return Submit(queue, shader, modelMatrix).Range(IndexRange{ m_Lods[0].firstIndex, m_Lods[0].indexCount });
 }
 
-void Mesh::Draw(Shader& shader) {
-    // Bind the shader
-    shader.Bind();
+size_t Mesh::SelectLod(float pixelsPerUnit, float maxErrorPixels) const {
+    size_t level = 0;
+    while (level + 1 < m_Lods.size() && m_Lods[level + 1].error * pixelsPerUnit <= maxErrorPixels)
+        level++;
+    return level;
+}
 
-    // Bind the VAO (which holds our vertex attribute configuration)
-    m_VAO->Bind();
+void Mesh::DrawLod(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, size_t level) {
+    const MeshLod& lod = m_Lods[std::min(level, m_Lods.size() - 1)];
+    Submit(queue, shader, modelMatrix).Range(IndexRange{ lod.firstIndex, lod.indexCount });
+}
 
-    // Create or use your Renderer object to draw the mesh.
-    // This assumes you have a Renderer::Draw() function that accepts a VAO, IBO, and shader.
-    Renderer renderer;
-    renderer.Draw(*m_VAO, *m_IBO, shader);
+void Mesh::DrawInstanced(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const InstanceBuffer& instances) {
+    if (instances.GetCount() == 0)
+        return;
 
-    // Optionally unbind VAO after drawing
-    m_VAO->Unbind();
-}
\ No newline at end of file
+    // The attribute pointers live in the VAO, so they only change when another buffer is drawn
+    if (m_InstanceSerial != instances.GetSerial()) {
+        m_VAO->AddBuffer(instances.GetBuffer(), instances.GetLayout(), InstanceBuffer::kFirstAttribute);
+        m_InstanceSerial = instances.GetSerial();
+    }
+
+    Submit(queue, shader, modelMatrix)
+        .Range(IndexRange{ m_Lods[0].firstIndex, m_Lods[0].indexCount })
+        .Instances(static_cast<unsigned int>(instances.GetCount()));
+}
+
+MeshletCuller::Stats Mesh::DrawClusters(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const Frustum& frustum,
+    const glm::vec3& cameraPosition, const MeshletCuller::Options& options) {
+    if (m_Meshlets.empty()) {
+        Draw(queue, shader, modelMatrix);
+        return MeshletCuller::Stats();
+    }
+
+    m_VisibleRanges.clear();
+    MeshletCuller::Stats stats = MeshletCuller::Cull(m_Meshlets, modelMatrix, frustum, cameraPosition, options, m_VisibleRanges);
+
+    if (!m_VisibleRanges.empty())
+        Submit(queue, shader, modelMatrix).Ranges(m_VisibleRanges.data(), m_VisibleRanges.size());
+    return stats;
+}
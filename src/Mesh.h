@@ -7,9 +7,46 @@
 #include "VertexBufferLayout.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "InstanceBuffer.h"
+#include "Bounds.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+#include "PackedVertex.h"
+#include "RenderQueue.h"
+
+// One mesh as the loader hands it over: full detail geometry with meshlets over its indices, and
+// reduced levels of detail with their own vertices. The pointers belong to the loader.
+struct MeshGeometry {
+    const Vertex* vertices;
+    size_t vertexCount;
+    const unsigned int* indices;               // Full detail, followed by lodIndexCount indices of the levels
+    size_t indexCount;                         // Of the full detail mesh
+    const Meshlet* meshlets;
+    size_t meshletCount;
+    const Vertex* lodVertices = nullptr;
+    size_t lodVertexCount = 0;
+    size_t lodIndexCount = 0;                  // Already shifted past vertices, the index buffer uploads as is
+    const MeshLod* lods = nullptr;             // Ranges of indices, counted from its start
+    size_t lodCount = 0;
+    double lodBuildMs = 0.0;                   // 0 when the levels came from the mesh cache
+    // Derived data the loader may have cached, Mesh computes whatever is null
+    const Bounds* bounds = nullptr;            // Of vertices
+    const PackedVertex* packedVertices = nullptr;   // vertices then lodVertices, see Mesh::PackVertices
+    const VertexQuantization* quantization = nullptr;
+};
+
+// How a Mesh lays out its buffers on the GPU. Indices are always stored as 8, 16 or 32 bit, whichever
+// the vertex count allows.
+struct MeshUploadOptions {
+    VertexFormat vertexFormat = VertexFormat::Packed;
+    // Each meshlet and level of detail as triangle strips with primitive restart, kept only when that
+    // takes fewer indices than the triangle list
+    bool triangleStrips = false;
+};
 
 class Mesh {
 public:
+    static constexpr size_t kMaxLodLevels = 8;  // Including full detail
     // Mesh vertex and index data
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
@@ -17,8 +54,48 @@ public:
     // Constructor: takes the vertex and index data
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
 
-    // Draw the mesh using the provided shader
-    void Draw(Shader& shader);
+    // Uploads the full detail mesh and its levels of detail into one vertex and one index buffer.
+    // Packed meshes quantize positions to their bounds and pass u_PositionScale and u_PositionOffset
+    // in the ObjectData of every draw; float meshes pass the identity.
+    Mesh(const MeshGeometry& geometry, const MeshUploadOptions& options = MeshUploadOptions());
+
+    // The vertex buffer of a packed mesh: the vertices and then the levels' vertices, on one grid over
+    // bounds (those of the vertices) and the levels
+    static VertexQuantization PackVertices(const MeshGeometry& geometry, const Bounds& bounds, std::vector<PackedVertex>& packed);
+
+    // Queue the mesh for drawing with the provided shader, which must declare the ObjectData block.
+    // Draws carry the model matrix and position dequantization in it; everything else the shader
+    // needs is set on it before the queue flushes or added to the returned command.
+    RenderQueue::Command Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix);
+
+    // Level 0 is the full mesh, higher levels are coarser
+    size_t GetLodCount() const { return m_Lods.size(); }
+    const MeshLod& GetLod(size_t level) const { return m_Lods[level]; }
+    // Coarsest level whose error, at pixelsPerUnit screen pixels per mesh unit, is at most maxErrorPixels
+    size_t SelectLod(float pixelsPerUnit, float maxErrorPixels) const;
+    void DrawLod(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, size_t level);
+
+    // Draws one copy per transform in instances with a single draw call. The shader reads the
+    // transform from the instance attributes (see InstanceBuffer). The VAO points at instances from
+    // submission on, so a mesh takes one instance buffer per flush.
+    void DrawInstanced(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const InstanceBuffer& instances);
+
+    // Meshlets over this mesh's index buffer (see MeshletBuilder), set by the loader
+    void SetMeshlets(const Meshlet* meshlets, size_t count) { m_Meshlets.assign(meshlets, meshlets + count); }
+    const std::vector<Meshlet>& GetMeshlets() const { return m_Meshlets; }
+
+    // Culls the meshlets against the frustum and the camera and draws the survivors with one
+    // multi-draw. Without meshlets the whole mesh is drawn.
+    MeshletCuller::Stats DrawClusters(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const Frustum& frustum,
+        const glm::vec3& cameraPosition, const MeshletCuller::Options& options);
+
+    // Object space bounds, computed when the mesh is created
+    const Bounds& GetBounds() const { return m_Bounds; }
+    size_t GetTriangleCount() const { return m_Lods[0].triangleCount; }
+    VertexFormat GetVertexFormat() const { return m_Format; }
+    size_t GetVertexBytes() const { return m_VertexBytes; }
+    size_t GetIndexBytes() const { return static_cast<size_t>(m_IBO->GetCount()) * m_IBO->GetIndexSize(); }
+    bool UsesStrips() const { return m_IBO->GetPrimitive() == GL_TRIANGLE_STRIP; }
 
 private:
     // Unique pointers to our OpenGL buffer objects
@@ -26,6 +103,19 @@ private:
     std::unique_ptr<VertexBuffer> m_VBO;
     std::unique_ptr<IndexBuffer> m_IBO;
 
-    // Setup the VAO/VBO/IBO and link vertex attributes
-    void SetupMesh();
+    Bounds m_Bounds;
+    VertexFormat m_Format = VertexFormat::Float;
+    VertexQuantization m_Quantization;
+    size_t m_VertexBytes = 0;
+    std::vector<Meshlet> m_Meshlets;
+    std::vector<MeshLod> m_Lods;  // Index ranges of m_IBO, level 0 first
+    std::vector<IndexRange> m_VisibleRanges;  // Reused by DrawClusters, the queue copies them
+    uint64_t m_InstanceSerial = 0;  // InstanceBuffer the VAO's instance attributes point at, 0 for none
+
+    // Setup the VAO/VBO/IBO and link vertex attributes, vertexData holds vertices in m_Format. Without
+    // levels of detail set up, level 0 becomes the whole index buffer.
+    void SetupMesh(const void* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount,
+        unsigned int primitive = GL_TRIANGLES);
+    // Queues the mesh at its bounds center with its ObjectData: the model matrix and the dequantization of m_Format
+    RenderQueue::Command Submit(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix);
 };
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr char kMagic[4] = { 'O', 'M', 'S', 'H' };
+    constexpr uint32_t kVersion = 7;  // 2: meshlets, 3: levels of detail, 4: MeshOptimizer order, 5: triangle counts,
+                                      // 6: one index buffer for all levels, 7: bounds and packed vertices
+    constexpr size_t kAlignment = 16;
+    const char* kCacheDirectory = ".cache/meshes/";
+
+    struct MeshCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexStride;  // sizeof(Vertex) when written, guards against layout changes
+        uint32_t sectionCount;
+        uint64_t optionsHash;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t pathLength;
+        uint32_t reserved;
+    };
+
+    struct MeshCacheSection {
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t offset;        // From the start of the file
+        uint64_t size;          // In bytes
+    };
+
+    inline size_t AlignUp(size_t value) {
+        return (value + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull; // FNV-1a
+        }
+        return hash;
+    }
+
+    std::string NormalizePath(const std::string& path) {
+        std::error_code error;
+        fs::path canonical = fs::weakly_canonical(path, error);
+        return error ? path : canonical.generic_string();
+    }
+
+    bool GetSourceStamp(const std::string& path, uint64_t& size, int64_t& time) {
+        std::error_code error;
+        size = fs::file_size(path, error);
+        if (error)
+            return false;
+        time = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+        return !error;
+    }
+
+    const MeshCacheSection* GetSections(const char* data) {
+        const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(data);
+        return reinterpret_cast<const MeshCacheSection*>(data + AlignUp(sizeof(MeshCacheHeader) + header->pathLength));
+    }
+
+}
+
+MeshCache::Entry::Entry(std::unique_ptr<MappedFile> file)
+    : m_File(std::move(file)), m_Vertices(nullptr), m_VertexCount(0), m_Indices(nullptr), m_IndexCount(0)
+{
+    size_t size = 0;
+    m_Vertices = static_cast<const Vertex*>(GetSection(SectionType::Vertices, size));
+    m_VertexCount = size / sizeof(Vertex);
+    m_Indices = static_cast<const unsigned int*>(GetSection(SectionType::Indices, size));
+    m_IndexCount = size / sizeof(unsigned int);
+}
+
+const void* MeshCache::Entry::GetSection(SectionType type, size_t& size) const {
+    const char* data = m_File->GetData();
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(data);
+    const MeshCacheSection* sections = GetSections(data);
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        if (sections[i].type == static_cast<uint32_t>(type)) {
+            size = static_cast<size_t>(sections[i].size);
+            return data + sections[i].offset;
+        }
+    }
+    size = 0;
+    return nullptr;
+}
+
+uint64_t MeshCache::HashOptions(const OBJLoadOptions& options) {
+    // Only options that change the loader output belong here (threadCount and stats don't)
+    uint32_t epsilonBits = 0;  // The float's bit pattern, any epsilon hashes without overflow or rounding
+    if (options.weldMode == OBJWeldMode::Epsilon)
+        std::memcpy(&epsilonBits, &options.weldEpsilon, sizeof(epsilonBits));
+    const uint32_t key[3] = {
+        (options.computeFaceNormals ? 1u : 0u) | (options.computeVertexNormals ? 2u : 0u),
+        static_cast<uint32_t>(options.weldMode),
+        epsilonBits,
+    };
+    return HashBytes(key, sizeof(key));
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath, const OBJLoadOptions& options) {
+    const std::string normalized = NormalizePath(sourcePath);
+    const uint64_t optionsHash = HashOptions(options);
+    const uint64_t key = HashBytes(&optionsHash, sizeof(optionsHash), HashBytes(normalized.data(), normalized.size()));
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(key));
+    return std::string(kCacheDirectory) + name;
+}
+
+std::unique_ptr<MeshCache::Entry> MeshCache::Open(const std::string& sourcePath, const OBJLoadOptions& options) {
+    const std::string cachePath = GetCachePath(sourcePath, options);
+    std::error_code error;
+    if (!fs::exists(cachePath, error))
+        return nullptr;
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+        return nullptr;
+
+    auto file = std::make_unique<MappedFile>(cachePath);
+    if (!file->IsOpen() || file->GetSize() < sizeof(MeshCacheHeader))
+        return nullptr;
+
+    const char* data = file->GetData();
+    const size_t fileSize = file->GetSize();
+    const MeshCacheHeader* header = reinterpret_cast<const MeshCacheHeader*>(data);
+    const std::string normalized = NormalizePath(sourcePath);
+
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+        header->vertexStride != sizeof(Vertex) || header->optionsHash != HashOptions(options) ||
+        header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+        return nullptr; // Stale or written by another build, it will be overwritten after the reload
+
+    const size_t sectionTableOffset = AlignUp(sizeof(MeshCacheHeader) + header->pathLength);
+    if (header->pathLength != normalized.size() ||
+        sectionTableOffset + header->sectionCount * sizeof(MeshCacheSection) > fileSize ||
+        std::memcmp(data + sizeof(MeshCacheHeader), normalized.data(), normalized.size()) != 0)
+        return nullptr; // Key collision with another source file
+
+    const MeshCacheSection* sections = GetSections(data);
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        if (sections[i].offset % kAlignment != 0 || sections[i].offset > fileSize || sections[i].size > fileSize - sections[i].offset) {
+            std::cerr << "Corrupt mesh cache entry: " << cachePath << std::endl;
+            return nullptr;
+        }
+    }
+
+    auto entry = std::make_unique<Entry>(std::move(file));
+    if (!entry->GetVertices() || !entry->GetIndices())
+        return nullptr;
+    return entry;
+}
+
+bool MeshCache::Write(const std::string& sourcePath, const OBJLoadOptions& options,
+    const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+    const std::vector<SectionData>& extraSections) {
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.vertexStride = sizeof(Vertex);
+    header.optionsHash = HashOptions(options);
+    if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+        return false;
+
+    const std::string normalized = NormalizePath(sourcePath);
+    header.pathLength = static_cast<uint32_t>(normalized.size());
+
+    std::vector<SectionData> sectionData = {
+        { SectionType::Vertices, vertices.data(), vertices.size() * sizeof(Vertex) },
+        { SectionType::Indices, indices.data(), indices.size() * sizeof(unsigned int) },
+    };
+    sectionData.insert(sectionData.end(), extraSections.begin(), extraSections.end());
+    header.sectionCount = static_cast<uint32_t>(sectionData.size());
+
+    std::vector<MeshCacheSection> sections(sectionData.size());
+    size_t offset = AlignUp(AlignUp(sizeof(MeshCacheHeader) + normalized.size()) + sections.size() * sizeof(MeshCacheSection));
+    for (size_t i = 0; i < sectionData.size(); ++i) {
+        sections[i] = { static_cast<uint32_t>(sectionData[i].type), 0, offset, sectionData[i].size };
+        offset = AlignUp(offset + sectionData[i].size);
+    }
+
+    const std::string cachePath = GetCachePath(sourcePath, options);
+    const std::string tempPath = cachePath + ".tmp";
+    std::error_code error;
+    fs::create_directories(kCacheDirectory, error);
+
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to write mesh cache: " << tempPath << std::endl;
+            return false;
+        }
+
+        const char padding[kAlignment] = {};
+        auto padTo = [&](size_t position) {
+            size_t current = static_cast<size_t>(out.tellp());
+            out.write(padding, position - current);
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(normalized.data(), normalized.size());
+        padTo(AlignUp(sizeof(MeshCacheHeader) + normalized.size()));
+        out.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(MeshCacheSection));
+        for (size_t i = 0; i < sectionData.size(); ++i) {
+            padTo(static_cast<size_t>(sections[i].offset));
+            out.write(static_cast<const char*>(sectionData[i].data), sectionData[i].size);
+        }
+
+        if (!out) {
+            std::cerr << "Failed to write mesh cache: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    // Write then rename, so a crash or a concurrent reader never sees a half written entry
+    fs::rename(tempPath, cachePath, error);
+    if (error) {
+        std::cerr << "Failed to update mesh cache " << cachePath << ": " << error.message() << std::endl;
+        fs::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::Remove(const std::string& sourcePath, const OBJLoadOptions& options) {
+    std::error_code error;
+    fs::remove(GetCachePath(sourcePath, options), error);
+}
\ No newline at end of file
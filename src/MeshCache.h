@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "OBJLoader.h"
+#include "Vertex.h"
+
+// Binary cache of OBJLoader output, stored under .cache/meshes/. A cache file holds the welded vertex
+// array and index buffer in the exact in-memory layout, so a hit is a file mapping plus a GPU upload.
+//
+// Layout (all sections 16 byte aligned so they can be used in place):
+//   MeshCacheHeader | source path | MeshCacheSection[sectionCount] | section data...
+// Entries are keyed by the source path, its size and modification time, and every loader option that
+// changes the output. A mismatch on any of them is treated as a miss.
+class MeshCache {
+public:
+    enum class SectionType : uint32_t {
+        Vertices = 1,
+        Indices = 2,        // With levels of detail, their indices follow the full detail ones (see MeshGeometry)
+        Meshlets = 3,       // Meshlet[], the indices are stored in meshlet order
+        LodVertices = 4,    // LodChain::vertices
+        // 5 held the levels' indices on their own before version 6
+        Lods = 6,           // MeshLod[], ranges of Indices
+        Bounds = 7,         // Bounds of Vertices
+        PackedVertices = 8, // PackedVertex[] of Vertices then LodVertices, see Mesh::PackVertices
+        Quantization = 9,   // VertexQuantization of PackedVertices
+    };
+
+    // A mapped cache entry. The pointers stay valid for the lifetime of the entry.
+    class Entry {
+    public:
+        Entry(std::unique_ptr<MappedFile> file);
+
+        const Vertex* GetVertices() const { return m_Vertices; }
+        size_t GetVertexCount() const { return m_VertexCount; }
+        const unsigned int* GetIndices() const { return m_Indices; }
+        size_t GetIndexCount() const { return m_IndexCount; }
+
+        // Raw access for sections that aren't vertices or indices, returns nullptr if absent
+        const void* GetSection(SectionType type, size_t& size) const;
+
+    private:
+        std::unique_ptr<MappedFile> m_File;
+        const Vertex* m_Vertices;
+        size_t m_VertexCount;
+        const unsigned int* m_Indices;
+        size_t m_IndexCount;
+    };
+
+    // Maps the cache entry for sourcePath, or returns nullptr if there is none or it is stale
+    static std::unique_ptr<Entry> Open(const std::string& sourcePath, const OBJLoadOptions& options);
+
+    struct SectionData {
+        SectionType type;
+        const void* data;
+        size_t size;
+    };
+
+    // Writes (or replaces) the cache entry for sourcePath. extraSections carries derived data that
+    // should be cached alongside the mesh.
+    static bool Write(const std::string& sourcePath, const OBJLoadOptions& options,
+        const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+        const std::vector<SectionData>& extraSections = {});
+
+    // Removes the cache entry for sourcePath, used to force a cold load
+    static void Remove(const std::string& sourcePath, const OBJLoadOptions& options);
+
+    static std::string GetCachePath(const std::string& sourcePath, const OBJLoadOptions& options);
+
+private:
+    static uint64_t HashOptions(const OBJLoadOptions& options);
+};
\ No newline at end of file
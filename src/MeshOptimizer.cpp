@@ -0,0 +1,398 @@
+#include "MeshOptimizer.h"
+#include "OBJLoader.h"
+#include "Model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+    constexpr uint32_t kNone = 0xFFFFFFFFu;
+    constexpr size_t kFetchLineSize = 64;
+    constexpr size_t kFetchCacheLines = 256;    // 16 KB direct mapped, the size of a small vertex cache
+
+    // Next fanning vertex: the candidate that stays in the cache the longest once its remaining
+    // triangles are emitted, else the newest dead end with work left, else the next vertex in order
+    int64_t NextVertex(const std::vector<uint32_t>& candidates, const std::vector<uint32_t>& liveTriangles,
+        const std::vector<uint32_t>& cacheTime, uint32_t time, unsigned int cacheSize,
+        std::vector<uint32_t>& deadEnds, size_t& cursor)
+    {
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0)
+                continue;
+            int64_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                priority = time - cacheTime[vertex];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = vertex;
+            }
+        }
+        if (best >= 0)
+            return best;
+
+        while (!deadEnds.empty()) {
+            const uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0)
+                return vertex;
+        }
+        for (; cursor < liveTriangles.size(); cursor++) {
+            if (liveTriangles[cursor] > 0)
+                return static_cast<int64_t>(cursor++);
+        }
+        return -1;
+    }
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        if (indices[i] >= vertexCount)
+            return;
+    }
+
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        liveTriangles[indices[i]]++;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+    int64_t fanning = NextVertex(candidates, liveTriangles, cacheTime, time, cacheSize, deadEnds, cursor);
+    while (fanning >= 0) {
+        candidates.clear();
+        for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+            const uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+                continue;
+            emitted[triangle] = 1;
+            for (int corner = 0; corner < 3; corner++) {
+                const unsigned int vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                if (time - cacheTime[vertex] > cacheSize)
+                    cacheTime[vertex] = time++;
+            }
+        }
+        fanning = NextVertex(candidates, liveTriangles, cacheTime, time, cacheSize, deadEnds, cursor);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, std::vector<Meshlet>& meshlets)
+{
+    if (meshlets.size() < 2)
+        return;
+
+    // Meshlet centers weighted by their triangle counts approximate the mesh's centroid
+    glm::vec3 centroid(0.0f);
+    float weight = 0.0f;
+    for (const Meshlet& meshlet : meshlets) {
+        centroid += meshlet.center * static_cast<float>(meshlet.indexCount);
+        weight += static_cast<float>(meshlet.indexCount);
+    }
+    centroid /= std::max(weight, 1.0f);
+
+    std::vector<std::pair<float, uint32_t>> order(meshlets.size());
+    for (size_t i = 0; i < meshlets.size(); i++)
+        order[i] = { -glm::dot(meshlets[i].center - centroid, meshlets[i].coneAxis), static_cast<uint32_t>(i) };
+    std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    const uint32_t firstIndex = meshlets.front().firstIndex;
+    std::vector<unsigned int> sortedIndices;
+    std::vector<Meshlet> sortedMeshlets;
+    sortedMeshlets.reserve(meshlets.size());
+    for (const auto& entry : order) {
+        Meshlet meshlet = meshlets[entry.second];
+        sortedIndices.insert(sortedIndices.end(), indices + meshlet.firstIndex, indices + meshlet.firstIndex + meshlet.indexCount);
+        meshlet.firstIndex = firstIndex + static_cast<uint32_t>(sortedIndices.size()) - meshlet.indexCount;
+        sortedMeshlets.push_back(meshlet);
+    }
+    std::copy(sortedIndices.begin(), sortedIndices.end(), indices + firstIndex);
+    meshlets.swap(sortedMeshlets);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for (unsigned int index : indices) {
+        if (index >= vertices.size())
+            return;
+    }
+
+    std::vector<uint32_t> remap(vertices.size(), kNone);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for (unsigned int& index : indices) {
+        if (remap[index] == kNone) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+std::vector<Meshlet> MeshOptimizer::OptimizeIndices(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount)
+{
+    std::vector<Meshlet> meshlets = MeshletBuilder::Build(vertices, vertexCount, indices, indexCount);
+
+    // Vertex cache order inside each meshlet, on local vertex ids so the cost follows the meshlet size
+    std::vector<uint32_t> local(vertexCount, kNone);
+    std::vector<unsigned int> global;
+    std::vector<unsigned int> meshletIndices;
+    for (const Meshlet& meshlet : meshlets) {
+        global.clear();
+        meshletIndices.assign(indices + meshlet.firstIndex, indices + meshlet.firstIndex + meshlet.indexCount);
+        for (unsigned int& index : meshletIndices) {
+            if (local[index] == kNone) {
+                local[index] = static_cast<uint32_t>(global.size());
+                global.push_back(index);
+            }
+            index = local[index];
+        }
+        OptimizeVertexCache(meshletIndices.data(), meshletIndices.size(), global.size());
+        for (size_t i = 0; i < meshletIndices.size(); i++)
+            indices[meshlet.firstIndex + i] = global[meshletIndices[i]];
+        for (unsigned int vertex : global)
+            local[vertex] = kNone;
+    }
+
+    OptimizeOverdraw(indices, meshlets);
+    return meshlets;
+}
+
+std::vector<Meshlet> MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    std::vector<Meshlet> meshlets = OptimizeIndices(vertices.data(), vertices.size(), indices.data(), indices.size());
+    // Meshlets keep their index ranges and positions, so renumbering the vertices leaves them valid
+    OptimizeVertexFetch(vertices, indices);
+    return meshlets;
+}
+
+void MeshOptimizer::OptimizeLodChain(LodChain& chain)
+{
+    for (const MeshLod& level : chain.levels)
+        OptimizeVertexCache(chain.indices.data() + level.firstIndex, level.indexCount, chain.vertices.size());
+    OptimizeVertexFetch(chain.vertices, chain.indices);
+}
+
+std::vector<unsigned int> MeshOptimizer::GenerateStrips(const unsigned int* indices, size_t vertexCount, std::vector<IndexRange>& ranges,
+    unsigned int restartIndex)
+{
+    std::vector<unsigned int> strips;
+    for (const IndexRange& range : ranges) {
+        for (unsigned int i = range.first; i < range.first + range.count; i++) {
+            if (indices[i] >= vertexCount)
+                return strips; // Not drawable anyway, the caller keeps the list
+        }
+    }
+
+    // Corners around every vertex of the current range, in triangle order: cornerHead[v] is v's first
+    // corner and cornerNext links the rest. Only the range's vertices are touched, and reset after it.
+    std::vector<uint32_t> cornerHead(vertexCount, kNone);
+    std::vector<uint32_t> cornerNext;
+    std::vector<unsigned char> emitted;
+
+    for (IndexRange& range : ranges) {
+        const unsigned int* triangles = indices + range.first;
+        const uint32_t triangleCount = range.count / 3;
+        cornerNext.assign(triangleCount * 3, kNone);
+        emitted.assign(triangleCount, 0);
+        for (uint32_t corner = triangleCount * 3; corner-- > 0;) {
+            cornerNext[corner] = cornerHead[triangles[corner]];
+            cornerHead[triangles[corner]] = corner;
+        }
+
+        // Earliest triangle left with the directed edge from -> to, third receives its other vertex
+        auto findTriangle = [&](unsigned int from, unsigned int to, unsigned int& third) {
+            for (uint32_t corner = cornerHead[from]; corner != kNone; corner = cornerNext[corner]) {
+                const uint32_t triangle = corner / 3;
+                const uint32_t base = triangle * 3;
+                if (!emitted[triangle] && triangles[base + (corner - base + 1) % 3] == to) {
+                    third = triangles[base + (corner - base + 2) % 3];
+                    return triangle;
+                }
+            }
+            return kNone;
+        };
+
+        const size_t first = strips.size();
+        unsigned int third = 0;
+        for (uint32_t seed = 0; seed < triangleCount; seed++) {
+            if (emitted[seed])
+                continue;
+            emitted[seed] = 1;
+            if (strips.size() > first)
+                strips.push_back(restartIndex);
+
+            // Start on the rotation whose last edge leads on to another triangle
+            const unsigned int* triangle = triangles + seed * 3;
+            int rotation = 0;
+            for (int r = 0; r < 3; r++) {
+                if (findTriangle(triangle[(r + 2) % 3], triangle[(r + 1) % 3], third) != kNone) {
+                    rotation = r;
+                    break;
+                }
+            }
+            unsigned int previous = triangle[(rotation + 1) % 3];
+            unsigned int last = triangle[(rotation + 2) % 3];
+            strips.push_back(triangle[rotation]);
+            strips.push_back(previous);
+            strips.push_back(last);
+
+            // Strip triangle i is (s[i], s[i+1], s[i+2]) for even i and (s[i+1], s[i], s[i+2]) for odd i,
+            // so the shared edge alternates direction
+            for (bool odd = true;; odd = !odd) {
+                const uint32_t next = odd ? findTriangle(last, previous, third) : findTriangle(previous, last, third);
+                if (next == kNone)
+                    break;
+                emitted[next] = 1;
+                strips.push_back(third);
+                previous = last;
+                last = third;
+            }
+        }
+
+        for (uint32_t corner = 0; corner < triangleCount * 3; corner++)
+            cornerHead[triangles[corner]] = kNone;
+
+        // Ends with a restart so the next range can be drawn in the same call
+        if (strips.size() > first)
+            strips.push_back(restartIndex);
+        range = { static_cast<unsigned int>(first), static_cast<unsigned int>(strips.size() - first) };
+    }
+    return strips;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats;
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return stats;
+
+    // FIFO cache as a timestamp per vertex: a vertex is cached while fewer than cacheSize misses
+    // happened since it was last transformed
+    std::vector<size_t> transformedAt(vertexCount, 0);
+    std::vector<unsigned char> used(vertexCount, 0);
+    std::vector<size_t> fetchLines(kFetchCacheLines, SIZE_MAX);
+    size_t uniqueVertices = 0;
+    size_t fetchedBytes = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        const unsigned int vertex = indices[i];
+        if (vertex >= vertexCount)
+            continue;
+        if (!used[vertex]) {
+            used[vertex] = 1;
+            uniqueVertices++;
+        }
+        if (transformedAt[vertex] == 0 || stats.transformed - transformedAt[vertex] >= cacheSize) {
+            stats.transformed++;
+            transformedAt[vertex] = stats.transformed;
+
+            // Every line the vertex spans goes through the fetch cache
+            const size_t begin = vertex * sizeof(Vertex) / kFetchLineSize;
+            const size_t end = ((vertex + 1) * sizeof(Vertex) - 1) / kFetchLineSize;
+            for (size_t line = begin; line <= end; line++) {
+                size_t& slot = fetchLines[line % kFetchCacheLines];
+                if (slot != line) {
+                    slot = line;
+                    fetchedBytes += kFetchLineSize;
+                }
+            }
+        }
+    }
+
+    stats.acmr = static_cast<float>(stats.transformed) / triangleCount;
+    stats.atvr = uniqueVertices ? static_cast<float>(stats.transformed) / uniqueVertices : 0.0f;
+    stats.overfetch = uniqueVertices ? static_cast<float>(fetchedBytes) / (uniqueVertices * sizeof(Vertex)) : 0.0f;
+    return stats;
+}
+
+int MeshOptimizer::RunAnalyzer(const std::string& directory, std::ostream& stream)
+{
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".obj")
+            paths.push_back(entry.path().generic_string());
+    }
+    if (error || paths.empty()) {
+        std::cerr << "No OBJ files in " << directory << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    OBJLoadOptions faceNormals = Model::GetLoadOptions();
+    OBJLoadOptions vertexNormals = faceNormals;
+    vertexNormals.computeFaceNormals = false;
+    vertexNormals.computeVertexNormals = true;
+    const std::pair<const char*, OBJLoadOptions> variants[] = {
+        { "face normals", faceNormals },
+        { "vertex normals", vertexNormals },
+    };
+
+    stream << "Vertex cache analysis, " << kCacheSize << " entry FIFO, " << kFetchLineSize << " byte fetch lines, "
+           << "strips per meshlet as Mesh builds them" << std::endl;
+    stream << std::left << std::setw(24) << "model" << std::setw(16) << "normals" << std::setw(11) << "order"
+           << std::right << std::setw(10) << "triangles" << std::setw(10) << "vertices"
+           << std::setw(8) << "ACMR" << std::setw(8) << "ATVR" << std::setw(11) << "overfetch" << std::setw(13) << "strip idx/tri" << std::setw(11) << "time ms" << std::endl;
+
+    bool failed = false;
+    for (const std::string& path : paths) {
+        for (const auto& variant : variants) {
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> indices;
+            if (!OBJLoader::LoadOBJ(path, vertices, indices, variant.second)) {
+                failed = true;
+                continue;
+            }
+
+            auto report = [&](const char* order, std::vector<IndexRange> ranges, double ms) {
+                const VertexCacheStats stats = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+                const std::vector<unsigned int> strips = GenerateStrips(indices.data(), vertices.size(), ranges, kNone);
+                stream << std::left << std::setw(24) << std::filesystem::path(path).filename().string() << std::setw(16) << variant.first
+                       << std::setw(11) << order << std::right << std::setw(10) << indices.size() / 3 << std::setw(10) << vertices.size()
+                       << std::fixed << std::setprecision(3) << std::setw(8) << stats.acmr << std::setw(8) << stats.atvr
+                       << std::setw(11) << stats.overfetch << std::setw(13) << strips.size() / std::max(indices.size() / 3.0, 1.0)
+                       << std::setprecision(1) << std::setw(11) << ms << std::endl;
+            };
+
+            report("file", { { 0, static_cast<unsigned int>(indices.size()) } }, 0.0);
+            auto start = std::chrono::steady_clock::now();
+            const std::vector<Meshlet> meshlets = Optimize(vertices, indices);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::vector<IndexRange> ranges;
+            for (const Meshlet& meshlet : meshlets)
+                ranges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+            report("optimized", ranges, ms);
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Vertex.h"
+#include "Meshlet.h"
+#include "MeshSimplifier.h"
+
+// Index and vertex order optimizations that run on welded loader output before it is cached and
+// uploaded. The load pipeline is Optimize(): meshlets as the clusters, vertex cache order inside
+// every meshlet, meshlets sorted against overdraw, then the vertex array in first use order.
+class MeshOptimizer {
+public:
+    static constexpr unsigned int kCacheSize = 16;  // Post-transform cache entries assumed
+
+    // Results of simulating a FIFO post-transform cache and a vertex fetch cache over an index buffer
+    struct VertexCacheStats {
+        size_t transformed = 0;     // Vertex shader invocations
+        float acmr = 0.0f;          // Average cache miss ratio, transformed vertices per triangle (0.5 to 3)
+        float atvr = 0.0f;          // Average transformed to vertex ratio, 1 is optimal
+        float overfetch = 0.0f;     // Vertex bytes read through 64 byte lines per byte of vertices used, 1 is optimal
+    };
+
+    // Runs the whole pipeline and returns the meshlets over the reordered indices
+    static std::vector<Meshlet> Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+    // The index steps of Optimize(), for vertices that can't be reordered (e.g. a streamed batch)
+    static std::vector<Meshlet> OptimizeIndices(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount);
+    // Vertex cache order for every level and first use order for the chain's vertices
+    static void OptimizeLodChain(LodChain& chain);
+
+    // Tipsify (Sander, Nehab and Barczak 2007): fans around the most recently used vertex that is
+    // still likely in the cache, then jumps to a dead end or the next unfinished vertex
+    static void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = kCacheSize);
+    // Sorts meshlets so that clusters far out along their normal, the likely occluders, draw first,
+    // and moves their index ranges to match
+    static void OptimizeOverdraw(unsigned int* indices, std::vector<Meshlet>& meshlets);
+    // Rewrites every range of a triangle list as greedy triangle strips separated by restartIndex, in
+    // the triangle order the cache optimizations left. Each range's strips end with a restart so
+    // neighbouring ranges can still be drawn as one, and ranges are updated to point into the result.
+    // Returns an empty vector when an index is out of range. Strips share vertices by index, so meshes
+    // with face normals, whose triangles share none, need more indices than as a list.
+    static std::vector<unsigned int> GenerateStrips(const unsigned int* indices, size_t vertexCount, std::vector<IndexRange>& ranges,
+        unsigned int restartIndex);
+    // Reorders vertices by first use in indices and drops unreferenced ones
+    static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    static VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = kCacheSize);
+
+    // Loads every OBJ in directory and reports the vertex cache metrics in file order and after
+    // Optimize(), both as Model loads it (face normals) and welded with vertex normals. CPU only,
+    // needs no GL context. Returns the process exit code.
+    static int RunAnalyzer(const std::string& directory, std::ostream& stream);
+};
@@ -0,0 +1,326 @@
+#include "MeshSimplifier.h"
+#include "VertexWeldTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+    constexpr uint32_t kNone = 0xFFFFFFFFu;
+    constexpr float kBorderWeight = 10.0f;   // Border planes against face planes of the same size
+    constexpr int kMaxPasses = 100;
+    // Share of the candidate collapses, cheapest first, a pass may use. Taking all of them lets one
+    // pass reach deep into expensive collapses while cheaper ones are only blocked by locks.
+    constexpr size_t kPassFraction = 4;
+
+    // Sum of squared distances to a set of planes as a symmetric 4x4 matrix, upper triangle only:
+    // xx xy xz xw yy yz yw zz zw ww
+    struct Quadric {
+        double m[10] = {};
+
+        void AddPlane(const glm::vec3& normal, float distance, double weight) {
+            const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+            m[0] += weight * a * a; m[1] += weight * a * b; m[2] += weight * a * c; m[3] += weight * a * d;
+            m[4] += weight * b * b; m[5] += weight * b * c; m[6] += weight * b * d;
+            m[7] += weight * c * c; m[8] += weight * c * d;
+            m[9] += weight * d * d;
+        }
+
+        Quadric& operator+=(const Quadric& other) {
+            for (int i = 0; i < 10; i++)
+                m[i] += other.m[i];
+            return *this;
+        }
+
+        double Evaluate(const glm::vec3& point) const {
+            const double x = point.x, y = point.y, z = point.z;
+            const double value = m[0] * x * x + 2.0 * (m[1] * x * y + m[2] * x * z + m[3] * x)
+                + m[4] * y * y + 2.0 * (m[5] * y * z + m[6] * y)
+                + m[7] * z * z + 2.0 * m[8] * z + m[9];
+            return std::max(value, 0.0);
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        uint32_t triangles;     // Sharing the edge, the ones the collapse removes
+        double cost;
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b) {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(const Vertex* vertices, size_t vertexCount, const unsigned int* indices,
+    size_t indexCount, size_t targetIndexCount, float& error)
+{
+    error = 0.0f;
+    std::vector<unsigned int> triangles(indices, indices + indexCount / 3 * 3);
+    if (targetIndexCount >= triangles.size())
+        return triangles;
+    for (unsigned int index : triangles) {
+        if (index >= vertexCount)
+            return triangles;
+    }
+
+    // Topology and quadrics live on positions: positionOf maps a vertex to the first vertex at its
+    // position, and collapses move positions. A corner keeps its own vertex until its position moves.
+    std::vector<uint32_t> positionOf = WeldPositions(vertices, vertexCount);
+    auto position = [&](uint32_t p) -> const glm::vec3& { return vertices[p].Position; };
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<double> weights(vertexCount, 0.0);
+    std::vector<unsigned char> border(vertexCount, 0);
+    std::vector<uint32_t> collapsedInto(vertexCount);
+    for (size_t p = 0; p < vertexCount; p++)
+        collapsedInto[p] = static_cast<uint32_t>(p);
+
+    // Face planes weighted by area, so the error per position is a mean squared distance
+    std::vector<glm::vec3> faceNormals(triangles.size() / 3, glm::vec3(0.0f));
+    for (size_t t = 0; t < triangles.size() / 3; t++) {
+        const uint32_t p0 = positionOf[triangles[t * 3]], p1 = positionOf[triangles[t * 3 + 1]], p2 = positionOf[triangles[t * 3 + 2]];
+        const glm::vec3 normal = glm::cross(position(p1) - position(p0), position(p2) - position(p0));
+        const float length = glm::length(normal);
+        if (length <= 0.0f)
+            continue;
+        faceNormals[t] = normal / length;
+        const float distance = -glm::dot(faceNormals[t], position(p0));
+        for (uint32_t p : { p0, p1, p2 }) {
+            quadrics[p].AddPlane(faceNormals[t], distance, length * 0.5);
+            weights[p] += length * 0.5;
+        }
+    }
+
+    // Edges with a single triangle get a plane through the edge, perpendicular to the triangle
+    {
+        std::vector<std::pair<uint64_t, uint32_t>> edges;
+        edges.reserve(triangles.size());
+        for (size_t t = 0; t < triangles.size() / 3; t++) {
+            for (int corner = 0; corner < 3; corner++) {
+                const uint32_t a = positionOf[triangles[t * 3 + corner]], b = positionOf[triangles[t * 3 + (corner + 1) % 3]];
+                if (a != b)
+                    edges.push_back({ EdgeKey(a, b), static_cast<uint32_t>(t) });
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size(); i++) {
+            const bool shared = (i > 0 && edges[i - 1].first == edges[i].first) || (i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+            if (shared)
+                continue;
+            const uint32_t a = static_cast<uint32_t>(edges[i].first >> 32), b = static_cast<uint32_t>(edges[i].first);
+            const glm::vec3 edge = position(b) - position(a);
+            const glm::vec3 normal = glm::cross(edge, faceNormals[edges[i].second]);
+            const float length = glm::length(normal);
+            border[a] = border[b] = 1;
+            if (length <= 0.0f)
+                continue;
+            const glm::vec3 planeNormal = normal / length;
+            const double weight = kBorderWeight * glm::dot(edge, edge);
+            quadrics[a].AddPlane(planeNormal, -glm::dot(planeNormal, position(a)), weight);
+            quadrics[b].AddPlane(planeNormal, -glm::dot(planeNormal, position(b)), weight);
+        }
+    }
+
+    auto resolve = [&](uint32_t p) {
+        uint32_t root = p;
+        while (collapsedInto[root] != root)
+            root = collapsedInto[root];
+        while (collapsedInto[p] != root) {
+            const uint32_t next = collapsedInto[p];
+            collapsedInto[p] = root;
+            p = next;
+        }
+        return root;
+    };
+
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<uint64_t> edgeKeys;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned char> locked(vertexCount);
+    double maxCost = 0.0;
+
+    for (int pass = 0; pass < kMaxPasses; pass++) {
+        // Moves corners whose position collapsed last pass and drops triangles that became degenerate
+        size_t kept = 0;
+        for (size_t t = 0; t < triangles.size() / 3; t++) {
+            uint32_t corners[3];
+            for (int corner = 0; corner < 3; corner++) {
+                const uint32_t vertex = triangles[t * 3 + corner];
+                const uint32_t p = resolve(positionOf[vertex]);
+                corners[corner] = p == positionOf[vertex] ? vertex : p;
+            }
+            if (positionOf[corners[0]] == positionOf[corners[1]] || positionOf[corners[1]] == positionOf[corners[2]] || positionOf[corners[0]] == positionOf[corners[2]])
+                continue;
+            for (int corner = 0; corner < 3; corner++)
+                triangles[kept * 3 + corner] = corners[corner];
+            kept++;
+        }
+        triangles.resize(kept * 3);
+        if (triangles.size() <= targetIndexCount)
+            break;
+
+        // Triangles around each position
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (unsigned int vertex : triangles)
+            adjacencyOffsets[positionOf[vertex] + 1]++;
+        for (size_t p = 0; p < vertexCount; p++)
+            adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+        adjacency.resize(triangles.size());
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < triangles.size(); i++)
+                adjacency[cursor[positionOf[triangles[i]]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        edgeKeys.clear();
+        for (size_t t = 0; t < triangles.size() / 3; t++) {
+            for (int corner = 0; corner < 3; corner++)
+                edgeKeys.push_back(EdgeKey(positionOf[triangles[t * 3 + corner]], positionOf[triangles[t * 3 + (corner + 1) % 3]]));
+        }
+        std::sort(edgeKeys.begin(), edgeKeys.end());
+
+        // The cheaper direction of every edge. A border position may only slide along the border.
+        collapses.clear();
+        for (size_t i = 0; i < edgeKeys.size();) {
+            size_t end = i + 1;
+            while (end < edgeKeys.size() && edgeKeys[end] == edgeKeys[i])
+                end++;
+            const uint32_t a = static_cast<uint32_t>(edgeKeys[i] >> 32), b = static_cast<uint32_t>(edgeKeys[i]);
+            const uint32_t sharing = static_cast<uint32_t>(end - i);
+            i = end;
+
+            const bool borderEdge = sharing == 1;
+            const bool aMovable = !border[a] || borderEdge;
+            const bool bMovable = !border[b] || borderEdge;
+            if (!aMovable && !bMovable)
+                continue;
+
+            Quadric sum = quadrics[a];
+            sum += quadrics[b];
+            const double weight = std::max(weights[a] + weights[b], 1e-30);
+            const double costAB = aMovable ? sum.Evaluate(position(b)) / weight : HUGE_VAL;
+            const double costBA = bMovable ? sum.Evaluate(position(a)) / weight : HUGE_VAL;
+            if (costAB <= costBA)
+                collapses.push_back({ a, b, sharing, costAB });
+            else
+                collapses.push_back({ b, a, sharing, costBA });
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+            return x.cost < y.cost || (x.cost == y.cost && (x.from < y.from || (x.from == y.from && x.to < y.to)));
+        });
+
+        // Independent collapses only: a collapse locks every position of the triangles it changes
+        const size_t toRemove = (triangles.size() - targetIndexCount) / 3 + 1;
+        size_t removed = 0;
+        std::fill(locked.begin(), locked.end(), 0);
+        const size_t candidates = collapses.size() / kPassFraction + 1;
+        for (size_t c = 0; c < candidates && c < collapses.size() && removed < toRemove; c++) {
+            const Collapse& collapse = collapses[c];
+            if (locked[collapse.from] || locked[collapse.to])
+                continue;
+
+            // Moving 'from' onto 'to' mustn't turn any remaining triangle around
+            bool flips = false;
+            for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; a++) {
+                const uint32_t t = adjacency[a];
+                uint32_t p[3];
+                bool hasTarget = false;
+                for (int corner = 0; corner < 3; corner++) {
+                    p[corner] = positionOf[triangles[t * 3 + corner]];
+                    hasTarget |= p[corner] == collapse.to;
+                }
+                if (hasTarget)
+                    continue;
+                const glm::vec3 before = glm::cross(position(p[1]) - position(p[0]), position(p[2]) - position(p[0]));
+                for (uint32_t& corner : p) {
+                    if (corner == collapse.from)
+                        corner = collapse.to;
+                }
+                const glm::vec3 after = glm::cross(position(p[1]) - position(p[0]), position(p[2]) - position(p[0]));
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+            if (flips)
+                continue;
+
+            for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++) {
+                for (int corner = 0; corner < 3; corner++)
+                    locked[positionOf[triangles[adjacency[a] * 3 + corner]]] = 1;
+            }
+            collapsedInto[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            weights[collapse.to] += weights[collapse.from];
+            maxCost = std::max(maxCost, collapse.cost);
+            removed += collapse.triangles;
+        }
+        if (removed == 0)
+            break;  // Every remaining collapse would flip a triangle or move a border
+    }
+
+    // Quadric error metric, not a measured distance: the RMS distance to the planes of the worst collapse
+    error = static_cast<float>(std::sqrt(maxCost));
+    return triangles;
+}
+
+LodChain MeshSimplifier::BuildLodChain(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+    bool flatNormals, const std::vector<float>& ratios)
+{
+    // Every level simplifies the full mesh, so the levels are independent and run side by side
+    std::vector<std::vector<unsigned int>> levels(ratios.size());
+    std::vector<float> errors(ratios.size(), 0.0f);
+    {
+        std::vector<std::thread> workers;
+        for (size_t level = 0; level < ratios.size(); level++) {
+            workers.emplace_back([&, level]() {
+                const size_t target = static_cast<size_t>(indexCount / 3 * ratios[level]) * 3;
+                levels[level] = Simplify(vertices, vertexCount, indices, indexCount, target, errors[level]);
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    LodChain chain;
+    std::vector<uint32_t> remap(flatNormals ? 0 : vertexCount, kNone);
+    size_t previousCount = indexCount;
+    for (size_t level = 0; level < levels.size(); level++) {
+        const std::vector<unsigned int>& levelIndices = levels[level];
+        if (levelIndices.empty() || levelIndices.size() >= previousCount)
+            continue;
+        previousCount = levelIndices.size();
+
+        MeshLod lod{ static_cast<uint32_t>(chain.indices.size()), static_cast<uint32_t>(levelIndices.size()), errors[level],
+            static_cast<uint32_t>(levelIndices.size() / 3) };
+        for (size_t i = 0; i < levelIndices.size(); i += 3) {
+            glm::vec3 faceNormal(0.0f);
+            if (flatNormals) {
+                const glm::vec3& p0 = vertices[levelIndices[i]].Position;
+                const glm::vec3 normal = glm::cross(vertices[levelIndices[i + 1]].Position - p0, vertices[levelIndices[i + 2]].Position - p0);
+                const float length = glm::length(normal);
+                if (length > 0.0f)
+                    faceNormal = normal / length;
+            }
+
+            for (int corner = 0; corner < 3; corner++) {
+                const unsigned int source = levelIndices[i + corner];
+                if (flatNormals) {
+                    Vertex vertex = vertices[source];
+                    vertex.Normal = faceNormal;
+                    chain.indices.push_back(static_cast<unsigned int>(chain.vertices.size()));
+                    chain.vertices.push_back(vertex);
+                }
+                else {
+                    if (remap[source] == kNone) {
+                        remap[source] = static_cast<uint32_t>(chain.vertices.size());
+                        chain.vertices.push_back(vertices[source]);
+                    }
+                    chain.indices.push_back(remap[source]);
+                }
+            }
+        }
+        chain.levels.push_back(lod);
+    }
+    return chain;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "Vertex.h"
+
+// One reduced level of detail, a range of LodChain::indices. Stored as is in the mesh cache.
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;        // Square root of the largest quadric error, an RMS plane distance in mesh units, not a bound
+    uint32_t triangleCount;     // indexCount / 3 for triangle lists, strips need fewer indices
+};
+
+// Reduced levels of a mesh with their own vertices, indices are relative to these vertices
+struct LodChain {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<MeshLod> levels;    // Coarser with every level, the full mesh is not included
+};
+
+// Quadric error metric simplification (Garland and Heckbert). Edges are collapsed cheapest first in
+// passes, each pass collapsing a set of independent edges, until the target triangle count is met or
+// every remaining collapse would flip a triangle. Vertices only ever collapse into a neighbouring
+// vertex, so texture coordinates are kept and no new positions appear. Open borders are held in
+// place by extra planes along them.
+class MeshSimplifier {
+public:
+    static constexpr float kDefaultLodRatios[] = { 0.5f, 0.25f, 0.125f };
+
+    // Indices of the simplified mesh, indexing vertices. error receives the square root of the largest
+    // collapse cost, the area weighted mean squared distance to the merged vertices' original face planes.
+    // It approximates how far the surface moved but is not the Hausdorff distance from the full mesh.
+    static std::vector<unsigned int> Simplify(const Vertex* vertices, size_t vertexCount, const unsigned int* indices,
+        size_t indexCount, size_t targetIndexCount, float& error);
+
+    // Simplifies to every ratio of the triangle count, one thread per level. With flatNormals each
+    // triangle gets its own vertices and its face normal, as OBJLoader does with computeFaceNormals;
+    // otherwise the vertices the levels reference are copied once. Levels that couldn't get below
+    // the previous level's triangle count are dropped.
+    static LodChain BuildLodChain(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+        bool flatNormals, const std::vector<float>& ratios = std::vector<float>(std::begin(kDefaultLodRatios), std::end(kDefaultLodRatios)));
+};
@@ -0,0 +1,241 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "VertexWeldTable.h"
+
+namespace {
+    constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    // Normal cones whose triangles spread wider than this (minimum dot with the axis) are never back
+    // facing as a whole often enough to be worth testing
+    constexpr float kMinConeDot = 0.1f;
+
+    Meshlet FinishMeshlet(const Vertex* vertices, const std::vector<uint32_t>& meshletVertices,
+        const unsigned int* indices, uint32_t firstIndex, uint32_t indexCount)
+    {
+        Meshlet meshlet;
+        meshlet.firstIndex = firstIndex;
+        meshlet.indexCount = indexCount;
+        meshlet.vertexCount = static_cast<uint32_t>(meshletVertices.size());
+        meshlet.triangleCount = indexCount / 3;
+
+        glm::vec3 min = vertices[meshletVertices[0]].Position;
+        glm::vec3 max = min;
+        for (uint32_t vertex : meshletVertices) {
+            min = glm::min(min, vertices[vertex].Position);
+            max = glm::max(max, vertices[vertex].Position);
+        }
+        meshlet.center = (min + max) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (uint32_t vertex : meshletVertices) {
+            const glm::vec3 offset = vertices[vertex].Position - meshlet.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        meshlet.radius = std::sqrt(radiusSquared);
+
+        // Geometric normals, counter clockwise triangles face front. Degenerate triangles have none.
+        std::vector<glm::vec3> normals;
+        normals.reserve(indexCount / 3);
+        glm::vec3 sum(0.0f);
+        for (uint32_t i = firstIndex; i + 2 < firstIndex + indexCount; i += 3) {
+            const glm::vec3& a = vertices[indices[i]].Position;
+            const glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - a, vertices[indices[i + 2]].Position - a);
+            const float length = glm::length(normal);
+            if (length > 0.0f) {
+                normals.push_back(normal / length);
+                sum += normals.back();
+            }
+        }
+
+        meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.coneCutoff = 1.0f;
+        const float sumLength = glm::length(sum);
+        if (normals.empty() || sumLength <= 0.0f)
+            return meshlet;
+
+        const glm::vec3 axis = sum / sumLength;
+        float minDot = 1.0f;
+        for (const glm::vec3& normal : normals)
+            minDot = std::min(minDot, glm::dot(axis, normal));
+
+        meshlet.coneAxis = axis;
+        if (minDot > kMinConeDot)
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        return meshlet;
+    }
+}
+
+std::vector<Meshlet> MeshletBuilder::Build(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount)
+{
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return meshlets;
+
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        if (indices[i] >= vertexCount)
+            return meshlets; // Not drawable anyway, leave the indices alone
+    }
+
+    // Neighbours are found through positions, face normals split vertices along every edge
+    const std::vector<uint32_t> positionOf = WeldPositions(vertices, vertexCount);
+
+    // Triangles around each position, compressed rows: position p's triangles are
+    // adjacency[adjacencyOffsets[p] .. adjacencyOffsets[p + 1])
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacencyOffsets[positionOf[indices[i]] + 1]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[cursor[positionOf[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<uint32_t> vertexMeshlet(vertexCount, kNone);    // Meshlet that last took the vertex
+    std::vector<uint32_t> positionMeshlet(vertexCount, kNone);  // Same for positions
+    std::vector<unsigned int> reordered;
+    reordered.reserve(triangleCount * 3);
+
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint32_t> meshletPositions;
+    meshletVertices.reserve(kMaxVertices);
+    meshletPositions.reserve(kMaxVertices);
+    meshlets.reserve(triangleCount / kMaxTriangles + 1);
+
+    size_t seed = 0;
+    for (;;) {
+        while (seed < triangleCount && emitted[seed])
+            seed++;
+        if (seed == triangleCount)
+            break;
+
+        const uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+        const uint32_t firstIndex = static_cast<uint32_t>(reordered.size());
+        uint32_t triangles = 0;
+        meshletVertices.clear();
+        meshletPositions.clear();
+
+        uint32_t next = static_cast<uint32_t>(seed);
+        while (next != kNone) {
+            emitted[next] = 1;
+            triangles++;
+            for (int corner = 0; corner < 3; corner++) {
+                const unsigned int vertex = indices[next * 3 + corner];
+                reordered.push_back(vertex);
+                if (vertexMeshlet[vertex] != meshletId) {
+                    vertexMeshlet[vertex] = meshletId;
+                    meshletVertices.push_back(vertex);
+                }
+                if (positionMeshlet[positionOf[vertex]] != meshletId) {
+                    positionMeshlet[positionOf[vertex]] = meshletId;
+                    meshletPositions.push_back(positionOf[vertex]);
+                }
+            }
+            if (triangles == kMaxTriangles)
+                break;
+
+            // The neighbour adding the fewest vertices, then the fewest positions; ties go to the
+            // earliest triangle so the result doesn't depend on adjacency order
+            next = kNone;
+            uint32_t nextNewVertices = 0;
+            uint32_t nextScore = kNone;
+            for (uint32_t position : meshletPositions) {
+                for (uint32_t a = adjacencyOffsets[position]; a < adjacencyOffsets[position + 1]; a++) {
+                    const uint32_t candidate = adjacency[a];
+                    if (emitted[candidate])
+                        continue;
+                    uint32_t newVertices = 0;
+                    uint32_t newPositions = 0;
+                    for (int corner = 0; corner < 3; corner++) {
+                        const unsigned int vertex = indices[candidate * 3 + corner];
+                        newVertices += vertexMeshlet[vertex] != meshletId;
+                        newPositions += positionMeshlet[positionOf[vertex]] != meshletId;
+                    }
+                    const uint32_t score = newVertices * 4 + newPositions;
+                    if (score < nextScore || (score == nextScore && candidate < next)) {
+                        next = candidate;
+                        nextNewVertices = newVertices;
+                        nextScore = score;
+                    }
+                }
+            }
+            if (next != kNone && meshletVertices.size() + nextNewVertices > kMaxVertices)
+                next = kNone;
+        }
+
+        meshlets.push_back(FinishMeshlet(vertices, meshletVertices, reordered.data(), firstIndex,
+            static_cast<uint32_t>(reordered.size()) - firstIndex));
+    }
+
+    std::copy(reordered.begin(), reordered.end(), indices);
+    return meshlets;
+}
+
+MeshletCuller::Stats& MeshletCuller::Stats::operator+=(const Stats& other)
+{
+    meshlets += other.meshlets;
+    frustumCulled += other.frustumCulled;
+    backfaceCulled += other.backfaceCulled;
+    visible += other.visible;
+    triangles += other.triangles;
+    ranges += other.ranges;
+    return *this;
+}
+
+MeshletCuller::Stats MeshletCuller::Cull(const std::vector<Meshlet>& meshlets, const glm::mat4& modelMatrix, const Frustum& frustum,
+    const glm::vec3& cameraPosition, const Options& options, std::vector<IndexRange>& ranges)
+{
+    Stats stats;
+    stats.meshlets = meshlets.size();
+
+    const glm::mat3 rotationScale(modelMatrix);
+    const float scale = std::max(glm::length(rotationScale[0]), std::max(glm::length(rotationScale[1]), glm::length(rotationScale[2])));
+    const size_t firstRange = ranges.size();
+
+    for (const Meshlet& meshlet : meshlets) {
+        const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(meshlet.center, 1.0f));
+        const float radius = meshlet.radius * scale;
+
+        if (options.frustum) {
+            bool outside = false;
+            for (const glm::vec4& plane : frustum.planes) {
+                if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+                    outside = true;
+                    break;
+                }
+            }
+            if (outside) {
+                stats.frustumCulled++;
+                continue;
+            }
+        }
+
+        // Every triangle faces away when the camera lies inside the cone of directions behind all
+        // of them, widened by the sphere so it holds for any point of the meshlet
+        if (options.backface && meshlet.coneCutoff < 1.0f) {
+            const glm::vec3 axis = rotationScale * meshlet.coneAxis;
+            const float axisLength = glm::length(axis);
+            const glm::vec3 toCenter = center - cameraPosition;
+            if (axisLength > 0.0f && glm::dot(toCenter, axis) >= (meshlet.coneCutoff * glm::length(toCenter) + radius) * axisLength) {
+                stats.backfaceCulled++;
+                continue;
+            }
+        }
+
+        stats.visible++;
+        stats.triangles += meshlet.triangleCount;
+        if (ranges.size() > firstRange && ranges.back().first + ranges.back().count == meshlet.firstIndex)
+            ranges.back().count += meshlet.indexCount;
+        else
+            ranges.push_back({ meshlet.firstIndex, meshlet.indexCount });
+    }
+
+    stats.ranges = ranges.size() - firstRange;
+    return stats;
+}
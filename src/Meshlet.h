@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "Vertex.h"
+#include "IndexBuffer.h"
+#include "FrustumCuller.h"
+
+// A cluster of up to MeshletBuilder::kMaxVertices vertices and kMaxTriangles triangles whose indices
+// are one contiguous range of the mesh's index buffer. Stored as is in the mesh cache, so it is POD.
+struct Meshlet {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t vertexCount;   // Unique vertices referenced
+    uint32_t triangleCount; // indexCount / 3 until the range is turned into strips
+    glm::vec3 center;       // Object space bounding sphere
+    float radius;
+    glm::vec3 coneAxis;     // Average triangle normal
+    float coneCutoff;       // Sine of the normal cone's half angle, 1 when the cone is too wide to cull
+};
+
+// Splits a triangle list into meshlets. Meshlets grow from a seed triangle by repeatedly adding the
+// neighbouring triangle that brings in the fewest new vertices, so they stay compact, which keeps the
+// spheres small and, on smooth surfaces, the cones narrow.
+class MeshletBuilder {
+public:
+    static constexpr uint32_t kMaxVertices = 64;
+    static constexpr uint32_t kMaxTriangles = 124;
+
+    // Reorders indices in place so every meshlet's triangles are contiguous and returns the meshlets
+    // in index buffer order. Runs when a model is first loaded, the result is cached with the mesh.
+    static std::vector<Meshlet> Build(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount);
+};
+
+// Per frame meshlet culling on the CPU. Surviving meshlets become index ranges, neighbours in the
+// index buffer merged into one range, for Renderer::DrawRanges.
+class MeshletCuller {
+public:
+    struct Options {
+        bool frustum = true;
+        bool backface = true;
+    };
+
+    struct Stats {
+        size_t meshlets = 0;
+        size_t frustumCulled = 0;
+        size_t backfaceCulled = 0;
+        size_t visible = 0;
+        size_t triangles = 0;   // In visible meshlets
+        size_t ranges = 0;      // Index ranges emitted
+
+        Stats& operator+=(const Stats& other);
+    };
+
+    // cameraPosition is in world space, modelMatrix may rotate, translate and scale (a non uniform
+    // scale is treated as its largest axis). Appends to ranges.
+    static Stats Cull(const std::vector<Meshlet>& meshlets, const glm::mat4& modelMatrix, const Frustum& frustum,
+        const glm::vec3& cameraPosition, const Options& options, std::vector<IndexRange>& ranges);
+};
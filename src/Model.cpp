@@ -1,37 +1,300 @@
 #include "Model.h"
 #include "Mesh.h"
+#include "Profiler.h"
+#include "MeshOptimizer.h"
 
-Model::Model(const std::string& path) {
-    // Use OBJLoader to parse the .obj file
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 
-    if (OBJLoader::LoadOBJ(path, vertices, indices, true, false)) {
-        // Create and store the Mesh object as a unique pointer
-        m_Meshes.push_back(std::make_unique<Mesh>(vertices, indices));
-    }
-    else {
-        std::cerr << "Failed to load model: " << path << std::endl;
-    }
+// OBJ files at least this large are streamed into one Mesh per batch instead of being loaded whole.
+// They skip the mesh cache, whose entries hold a single welded mesh.
+static constexpr uintmax_t kStreamingThresholdBytes = 256ull << 20;
+
+Model::Model(const std::string& path, const MeshUploadOptions& options)
+    : m_UploadOptions(options) {
+    LoadModel(path);
 }
 
 
+OBJLoadOptions Model::GetLoadOptions() {
+    OBJLoadOptions options;
+    options.computeFaceNormals = true;
+    options.threadCount = 0; // Large files are parsed on every core, small ones stay serial
+    return options;
+}
+
 void Model::LoadModel(const std::string& path) {
     // Clear existing data and load new model
     m_Meshes.clear();
+    m_Path = path;
+    m_Bounds = Bounds();
+    m_LodBuildMs = 0.0;
+    LoadGeometry(path, [this](const MeshGeometry& geometry) {
+        m_Meshes.push_back(std::make_unique<Mesh>(geometry, m_UploadOptions));
+        m_LodBuildMs += geometry.lodBuildMs;
+        m_Bounds = Bounds::Merge(m_Bounds, m_Meshes.back()->GetBounds());
+    });
+}
+
+bool Model::Reload() {
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    Bounds bounds;
+    double lodBuildMs = 0.0;
+    LoadGeometry(m_Path, [&](const MeshGeometry& geometry) {
+        meshes.push_back(std::make_unique<Mesh>(geometry, m_UploadOptions));
+        lodBuildMs += geometry.lodBuildMs;
+        bounds = Bounds::Merge(bounds, meshes.back()->GetBounds());
+    });
+    if (meshes.empty())
+        return false;
+
+    m_Meshes.swap(meshes);
+    m_Bounds = bounds;
+    m_LodBuildMs = lodBuildMs;
+    return true;
+}
+
+void Model::SetUploadOptions(const MeshUploadOptions& options) {
+    if (options.vertexFormat == m_UploadOptions.vertexFormat && options.triangleStrips == m_UploadOptions.triangleStrips)
+        return;
+    m_UploadOptions = options;
+    LoadModel(m_Path);
+}
+
+bool Model::LoadGeometry(const std::string& path, const GeometryCallback& onMesh) {
+    const OBJLoadOptions options = GetLoadOptions();
+
+    // Warm path: the welded mesh, its meshlets, its levels of detail, its bounds and its packed vertices
+    // are mapped from the cache and uploaded as is
+    if (auto cached = MeshCache::Open(path, options)) {
+        size_t meshletBytes = 0, lodVertexBytes = 0, lodBytes = 0, boundsBytes = 0, packedBytes = 0, quantizationBytes = 0;
+        const void* meshlets = cached->GetSection(MeshCache::SectionType::Meshlets, meshletBytes);
+        const void* lodVertices = cached->GetSection(MeshCache::SectionType::LodVertices, lodVertexBytes);
+        const MeshLod* lods = static_cast<const MeshLod*>(cached->GetSection(MeshCache::SectionType::Lods, lodBytes));
+        const void* bounds = cached->GetSection(MeshCache::SectionType::Bounds, boundsBytes);
+        const void* packed = cached->GetSection(MeshCache::SectionType::PackedVertices, packedBytes);
+        const void* quantization = cached->GetSection(MeshCache::SectionType::Quantization, quantizationBytes);
+        const size_t lodCount = lodBytes / sizeof(MeshLod);
+        // The levels' indices follow the full detail ones, so the first level starts where those end
+        const size_t indexCount = lodCount > 0 ? std::min<size_t>(lods[0].firstIndex, cached->GetIndexCount()) : cached->GetIndexCount();
+        if (meshlets && lodVertices && lods && bounds && packed && quantization && meshletBytes % sizeof(Meshlet) == 0 &&
+            lodBytes % sizeof(MeshLod) == 0 && boundsBytes == sizeof(Bounds) && quantizationBytes == sizeof(VertexQuantization) &&
+            packedBytes == (cached->GetVertexCount() + lodVertexBytes / sizeof(Vertex)) * sizeof(PackedVertex)) {
+            MeshGeometry geometry{ cached->GetVertices(), cached->GetVertexCount(), cached->GetIndices(), indexCount,
+                static_cast<const Meshlet*>(meshlets), meshletBytes / sizeof(Meshlet) };
+            geometry.lodVertices = static_cast<const Vertex*>(lodVertices);
+            geometry.lodVertexCount = lodVertexBytes / sizeof(Vertex);
+            geometry.lodIndexCount = cached->GetIndexCount() - indexCount;
+            geometry.lods = lods;
+            geometry.lodCount = lodCount;
+            geometry.bounds = static_cast<const Bounds*>(bounds);
+            geometry.packedVertices = static_cast<const PackedVertex*>(packed);
+            geometry.quantization = static_cast<const VertexQuantization*>(quantization);
+            onMesh(geometry);
+            return true;
+        }
+
+        // Written without some of the derived data, build it now and store it for the next load
+        std::vector<Vertex> vertices(cached->GetVertices(), cached->GetVertices() + cached->GetVertexCount());
+        std::vector<unsigned int> indices(cached->GetIndices(), cached->GetIndices() + indexCount);
+        cached.reset(); // Unmapped before the entry is replaced
+        return BuildDerivedData(path, options, vertices, indices, onMesh);
+    }
+
+    // Streamed vertex normals would be computed per batch and seam at batch boundaries, so a mesh
+    // that may need them is always loaded whole
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (!error && fileSize >= kStreamingThresholdBytes && !options.computeVertexNormals) {
+        OBJLoadOptions streamOptions = options;
+        streamOptions.streamBatchVertices = 1 << 20;
+        streamOptions.streamBatchIndices = 3 << 20;
+        std::vector<unsigned int> indices;
+        const bool loaded = OBJLoader::LoadOBJStreaming(path, streamOptions, [&onMesh, &indices](const OBJMeshBatch& batch) {
+            // The batch is read only, so only a copy of its indices is optimized. Files this large
+            // are already bound by memory, so they get no levels of detail.
+            indices.assign(batch.indices, batch.indices + batch.indexCount);
+            const std::vector<Meshlet> meshlets = MeshOptimizer::OptimizeIndices(batch.vertices, batch.vertexCount, indices.data(), indices.size());
+            onMesh({ batch.vertices, batch.vertexCount, indices.data(), indices.size(), meshlets.data(), meshlets.size() });
+            return true;
+        });
+        if (!loaded) {
+            std::cerr << "Failed to load model: " << path << std::endl;
+        }
+        return loaded;
+    }
+
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
 
-    if (OBJLoader::LoadOBJ(path, vertices, indices, true, false)) {
-        m_Meshes.push_back(std::make_unique<Mesh>(vertices, indices));
+    if (OBJLoader::LoadOBJ(path, vertices, indices, options))
+        return BuildDerivedData(path, options, vertices, indices, onMesh);
+
+    std::cerr << "Failed to load model: " << path << std::endl;
+    return false;
+}
+
+bool Model::BuildDerivedData(const std::string& path, const OBJLoadOptions& options, std::vector<Vertex>& vertices,
+    std::vector<unsigned int>& indices, const GeometryCallback& onMesh) {
+    const std::vector<Meshlet> meshlets = MeshOptimizer::Optimize(vertices, indices);
+
+    auto start = std::chrono::steady_clock::now();
+    LodChain lods = MeshSimplifier::BuildLodChain(vertices.data(), vertices.size(), indices.data(), indices.size(), options.computeFaceNormals);
+    MeshOptimizer::OptimizeLodChain(lods);
+    const double lodBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Built " << lods.levels.size() << " levels of detail for " << path << " in " << lodBuildMs << " ms" << std::endl;
+
+    // One index buffer for all levels: the reduced levels go behind the full mesh, shifted past its
+    // vertices, so a cache hit uploads it straight from the mapping
+    const size_t indexCount = indices.size();
+    indices.reserve(indexCount + lods.indices.size());
+    for (unsigned int index : lods.indices)
+        indices.push_back(index + static_cast<unsigned int>(vertices.size()));
+    for (MeshLod& level : lods.levels)
+        level.firstIndex += static_cast<uint32_t>(indexCount);
+
+    MeshGeometry geometry{ vertices.data(), vertices.size(), indices.data(), indexCount, meshlets.data(), meshlets.size() };
+    geometry.lodVertices = lods.vertices.data();
+    geometry.lodVertexCount = lods.vertices.size();
+    geometry.lodIndexCount = lods.indices.size();
+    geometry.lods = lods.levels.data();
+    geometry.lodCount = lods.levels.size();
+    geometry.lodBuildMs = lodBuildMs;
+
+    // Packed here once, whichever format the model uploads, so warm loads of packed meshes skip it
+    const Bounds bounds = Bounds::FromVertices(vertices.data(), vertices.size());
+    std::vector<PackedVertex> packed;
+    const VertexQuantization quantization = Mesh::PackVertices(geometry, bounds, packed);
+    geometry.bounds = &bounds;
+    geometry.packedVertices = packed.data();
+    geometry.quantization = &quantization;
+
+    MeshCache::Write(path, options, vertices, indices, {
+        { MeshCache::SectionType::Meshlets, meshlets.data(), meshlets.size() * sizeof(Meshlet) },
+        { MeshCache::SectionType::LodVertices, lods.vertices.data(), lods.vertices.size() * sizeof(Vertex) },
+        { MeshCache::SectionType::Lods, lods.levels.data(), lods.levels.size() * sizeof(MeshLod) },
+        { MeshCache::SectionType::Bounds, &bounds, sizeof(Bounds) },
+        { MeshCache::SectionType::PackedVertices, packed.data(), packed.size() * sizeof(PackedVertex) },
+        { MeshCache::SectionType::Quantization, &quantization, sizeof(VertexQuantization) },
+    });
+    onMesh(geometry);
+    return true;
+}
+
+size_t Model::GetLodCount() const {
+    size_t levels = 0;
+    for (const auto& mesh : m_Meshes) {
+        levels = std::max(levels, mesh->GetLodCount());
+    }
+    return levels;
+}
+
+Model::LodSelection Model::LodSelection::FromCamera(const glm::mat4& view, const glm::mat4& projection, int viewportHeight, float maxErrorPixels) {
+    LodSelection selection;
+    selection.cameraPosition = glm::vec3(glm::inverse(view)[3]);
+    selection.pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;
+    selection.maxErrorPixels = maxErrorPixels;
+    return selection;
+}
+
+size_t Model::GetTriangleCount() const {
+    size_t triangles = 0;
+    for (const auto& mesh : m_Meshes) {
+        triangles += mesh->GetTriangleCount();
+    }
+    return triangles;
+}
+
+size_t Model::GetVertexBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : m_Meshes) {
+        bytes += mesh->GetVertexBytes();
+    }
+    return bytes;
+}
+
+size_t Model::GetIndexBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : m_Meshes) {
+        bytes += mesh->GetIndexBytes();
+    }
+    return bytes;
+}
+
+size_t Model::GetStripMeshCount() const {
+    size_t meshes = 0;
+    for (const auto& mesh : m_Meshes) {
+        meshes += mesh->UsesStrips();
+    }
+    return meshes;
+}
+
+void Model::Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix) {
+    PROFILE_SCOPE("Model::Draw");
+    for (auto& mesh : m_Meshes) {
+        mesh->Draw(queue, shader, modelMatrix);  // Use `->` since we now store unique pointers
+    }
+}
+
+void Model::Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const glm::vec3& objectColor) {
+    PROFILE_SCOPE("Model::Draw");
+    for (auto& mesh : m_Meshes) {
+        mesh->Draw(queue, shader, modelMatrix).Uniform("objectColor", objectColor);
+    }
+}
+
+size_t Model::Draw(RenderQueue& queue, Shader& shader, const Frustum& frustum, const glm::mat4& modelMatrix) {
+    PROFILE_SCOPE("Model::Draw");
+    size_t drawn = 0;
+    for (auto& mesh : m_Meshes) {
+        if (frustum.Intersects(mesh->GetBounds().Transformed(modelMatrix))) {
+            mesh->Draw(queue, shader, modelMatrix);
+            drawn++;
+        }
+    }
+    return drawn;
+}
+
+MeshletCuller::Stats Model::DrawClusters(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const Frustum& frustum,
+    const glm::vec3& cameraPosition, const MeshletCuller::Options& options) {
+    PROFILE_SCOPE("Model::DrawClusters");
+    MeshletCuller::Stats stats;
+    for (auto& mesh : m_Meshes) {
+        stats += mesh->DrawClusters(queue, shader, modelMatrix, frustum, cameraPosition, options);
     }
-    else {
-        std::cerr << "Failed to load model: " << path << std::endl;
+    return stats;
+}
+
+Model::LodStats Model::Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const LodSelection& lod, const Frustum* frustum) {
+    PROFILE_SCOPE("Model::Draw");
+    LodStats stats;
+    const glm::mat3 rotationScale(modelMatrix);
+    const float scale = std::max(glm::length(rotationScale[0]), std::max(glm::length(rotationScale[1]), glm::length(rotationScale[2])));
+    for (auto& mesh : m_Meshes) {
+        const Bounds bounds = mesh->GetBounds().Transformed(modelMatrix);
+        if (frustum && !frustum->Intersects(bounds))
+            continue;
+
+        size_t level;
+        if (lod.forcedLevel >= 0) {
+            level = std::min(static_cast<size_t>(lod.forcedLevel), mesh->GetLodCount() - 1);
+        }
+        else {
+            // The nearest point of the bounding sphere decides, the camera may be inside it
+            const float distance = std::max(glm::length(bounds.center - lod.cameraPosition) - bounds.radius, 1e-3f);
+            level = mesh->SelectLod(scale * lod.pixelsPerUnit / distance, lod.maxErrorPixels);
+        }
+        mesh->DrawLod(queue, shader, modelMatrix, level);
+        stats.triangles += mesh->GetLod(level).triangleCount;
+        stats.meshesPerLevel[level]++;
     }
+    return stats;
 }
 
-void Model::Draw(Shader& shader) {
+void Model::DrawInstanced(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const InstanceBuffer& instances) {
+    PROFILE_SCOPE("Model::DrawInstanced");
     for (auto& mesh : m_Meshes) {
-        mesh->Draw(shader);  // Use `->` since we now store unique pointers
+        mesh->DrawInstanced(queue, shader, modelMatrix, instances);
     }
 }
\ No newline at end of file
@@ -3,15 +3,86 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <functional>
 #include "Mesh.h"
 #include "OBJLoader.h"
+#include "MeshCache.h"
+#include "FrustumCuller.h"
+#include "Meshlet.h"
 
 class Model {
 public:
-    Model(const std::string& path); // Constructor to load a model from a file
+    // Constructor to load a model from a file, options decide the meshes' GPU buffer layout
+    Model(const std::string& path, const MeshUploadOptions& options = MeshUploadOptions());
     void LoadModel(const std::string& path); // Remove old model and load a new model
-    void Draw(Shader& shader);       // Draw method for rendering
+    const std::string& GetPath() const { return m_Path; }
+    // Loads the file again, keeping the current meshes when it has none (e.g. a parse error)
+    bool Reload();
+    // Reloads the model with options when they differ from the current ones
+    void SetUploadOptions(const MeshUploadOptions& options);
+    const MeshUploadOptions& GetUploadOptions() const { return m_UploadOptions; }
+    // Queues every mesh for rendering, see Mesh::Draw for the uniforms the draws carry
+    void Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix);
+    // Same, with objectColor set per draw so differently colored models can share the shader
+    void Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const glm::vec3& objectColor);
+    // Skips meshes whose bounds under modelMatrix lie outside the frustum, returns the number drawn
+    size_t Draw(RenderQueue& queue, Shader& shader, const Frustum& frustum, const glm::mat4& modelMatrix);
+
+    // Screen space level of detail: each mesh is drawn at the coarsest level whose simplification
+    // error, projected at the mesh's distance from the camera, spans at most maxErrorPixels
+    struct LodSelection {
+        glm::vec3 cameraPosition = glm::vec3(0.0f);
+        float pixelsPerUnit = 0.0f;     // Pixels one unit covers at distance one, projection[1][1] * viewport height / 2
+        float maxErrorPixels = 1.0f;
+        int forcedLevel = -1;           // Draws every mesh at this level (clamped) instead
+
+        static LodSelection FromCamera(const glm::mat4& view, const glm::mat4& projection, int viewportHeight, float maxErrorPixels = 1.0f);
+    };
+
+    struct LodStats {
+        size_t triangles = 0;
+        size_t meshesPerLevel[Mesh::kMaxLodLevels] = {};
+    };
+
+    // Draws every mesh at its selected level, skipping meshes outside frustum when one is given
+    LodStats Draw(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const LodSelection& lod, const Frustum* frustum = nullptr);
+    // One draw call per mesh for all instances, modelMatrix applies before each instance's transform
+    void DrawInstanced(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const InstanceBuffer& instances);
+    // Draws only the meshlets that are inside the frustum and not facing away from cameraPosition
+    MeshletCuller::Stats DrawClusters(RenderQueue& queue, Shader& shader, const glm::mat4& modelMatrix, const Frustum& frustum,
+        const glm::vec3& cameraPosition, const MeshletCuller::Options& options = MeshletCuller::Options());
+
+    // Loader flags used for every model, also part of the mesh cache key
+    static OBJLoadOptions GetLoadOptions();
+
+    // Receives one mesh, the pointers are only valid during the call
+    using GeometryCallback = std::function<void(const MeshGeometry& geometry)>;
+
+    // Loads path the same way LoadModel does (mesh cache, streaming for huge files, full parse) but
+    // hands the geometry to onMesh instead of creating Meshes, e.g. for BatchRenderer
+    static bool LoadGeometry(const std::string& path, const GeometryCallback& onMesh);
+
+    // Time the levels of detail took to build when the model was loaded, 0 when they were cached
+    double GetLodBuildMs() const { return m_LodBuildMs; }
+    size_t GetLodCount() const;     // Most levels of any mesh, including full detail
+
+    // Object space bounds of all meshes
+    const Bounds& GetBounds() const { return m_Bounds; }
+    size_t GetMeshCount() const { return m_Meshes.size(); }
+    size_t GetTriangleCount() const;
+    size_t GetVertexBytes() const;  // GPU memory of all vertex buffers, levels of detail included
+    size_t GetIndexBytes() const;   // Same for the index buffers
+    size_t GetStripMeshCount() const;
 
 private:
+    // Optimizes a freshly loaded mesh (see MeshOptimizer), builds its levels of detail, caches
+    // everything and hands it on
+    static bool BuildDerivedData(const std::string& path, const OBJLoadOptions& options, std::vector<Vertex>& vertices,
+        std::vector<unsigned int>& indices, const GeometryCallback& onMesh);
+
     std::vector<std::unique_ptr<Mesh>> m_Meshes;    // Store loaded meshes
+    std::string m_Path;
+    MeshUploadOptions m_UploadOptions;
+    Bounds m_Bounds;
+    double m_LodBuildMs = 0.0;
 };
\ No newline at end of file
@@ -5,11 +5,20 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
 #include <glm/glm.hpp>
 #include "Vertex.h"
 #include "OBJLoader.h"
+#include "MappedFile.h"
+#include "VertexWeldTable.h"
 
-// Hash function for Vertex to use in unordered_map
+// Hash function for Vertex to use in unordered_map (legacy loader)
 struct VertexHash {
     std::size_t operator()(const Vertex& v) const {
         size_t seed = 0;
@@ -34,7 +43,818 @@ struct VertexEqual {
         return a.Position == b.Position && a.Normal == b.Normal && a.TexCoords == b.TexCoords;
     }
 };
+namespace {
+
+    // In-place tokenizer helpers for the memory mapped parser. They never allocate and never
+    // read past 'end', which matters because a mapped file is not null terminated.
+    inline bool IsBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline const char* SkipBlanks(const char* p, const char* end) {
+        while (p < end && IsBlank(*p)) ++p;
+        return p;
+    }
+
+    inline const char* SkipToken(const char* p, const char* end) {
+        while (p < end && !IsBlank(*p)) ++p;
+        return p;
+    }
+
+    inline const char* NextLine(const char* p, const char* end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        return lineEnd ? lineEnd : end;
+    }
+
+    inline const char* ParseFloat(const char* p, const char* end, float& value) {
+        p = SkipBlanks(p, end);
+        if (p < end && *p == '+') ++p; // from_chars does not accept a leading plus sign
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc()) {
+            value = 0.0f;
+            return SkipToken(p, end);
+        }
+        return next;
+    }
+
+    inline void ParseVec3(const char* p, const char* end, glm::vec3& value) {
+        p = ParseFloat(p, end, value.x);
+        p = ParseFloat(p, end, value.y);
+        ParseFloat(p, end, value.z);
+    }
+
+    inline void ParseTexCoord(const char* p, const char* end, glm::vec2& value) {
+        p = ParseFloat(p, end, value.x);
+        ParseFloat(p, end, value.y);
+        value.y = 1.0f - value.y;  // Flip Y for OpenGL
+    }
+
+    inline const char* ParseRawIndex(const char* p, const char* end, int& value) {
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc())
+            value = 0; // 0 is never a valid OBJ index, so it doubles as "missing"
+        return next;
+    }
+
+    // Index triple of a face corner exactly as written in the file (one based, negative = relative, 0 = missing)
+    struct RawCorner {
+        int position, texCoord, normal;
+    };
+
+    // Parses a "v", "v/t", "v//n" or "v/t/n" corner starting at p.
+    inline const char* ParseCorner(const char* p, const char* end, RawCorner& corner) {
+        corner.texCoord = corner.normal = 0;
+        p = ParseRawIndex(p, end, corner.position);
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/')
+                p = ParseRawIndex(p, end, corner.texCoord);
+            if (p < end && *p == '/')
+                p = ParseRawIndex(p + 1, end, corner.normal);
+        }
+        return SkipToken(p, end);
+    }
+
+    // Converts a raw OBJ index to zero based, given how many elements had been read when the face
+    // was declared. Returns -1 for a missing or out of range index.
+    inline long long ResolveIndex(int raw, size_t count) {
+        if (raw == 0)
+            return -1;
+        long long index = raw > 0 ? static_cast<long long>(raw) - 1 : static_cast<long long>(count) + raw;
+        return (index >= 0 && index < static_cast<long long>(count)) ? index : -1;
+    }
+
+    struct FaceCorner {
+        long long position, texCoord, normal;
+
+        bool operator==(const FaceCorner& other) const {
+            return position == other.position && texCoord == other.texCoord && normal == other.normal;
+        }
+    };
+
+    inline bool ResolveCorner(const RawCorner& raw, size_t positionCount, size_t texCoordCount, size_t normalCount, FaceCorner& corner) {
+        corner.position = ResolveIndex(raw.position, positionCount);
+        corner.texCoord = ResolveIndex(raw.texCoord, texCoordCount);
+        corner.normal = ResolveIndex(raw.normal, normalCount);
+        return corner.position >= 0;
+    }
+
+    // Attribute source for TriangulateFace backed by fully parsed arrays
+    struct AttributeArrays {
+        const glm::vec3* positions;
+        const glm::vec2* texCoords;
+        const glm::vec3* normals;
+
+        const glm::vec3& Position(long long index) const { return positions[index]; }
+        const glm::vec2& TexCoord(long long index) const { return texCoords[index]; }
+        const glm::vec3& Normal(long long index) const { return normals[index]; }
+    };
+
+    // Builds the vertices of one polygon and hands them to 'emit' in triangle order. Every loader goes
+    // through here, which is what keeps their output bit-identical. 'attributes' provides
+    // Position/TexCoord/Normal lookups by resolved index; normals are only read when they are used.
+    template<typename Attributes, typename EmitVertex>
+    void TriangulateFace(const FaceCorner* corners, size_t cornerCount, Attributes& attributes, bool computeFaceNormals, EmitVertex&& emit) {
+        glm::vec3 faceNormal(0.0f);
+        if (computeFaceNormals) {
+            // Compute face normal for flat shading
+            const glm::vec3 p0 = attributes.Position(corners[0].position);
+            glm::vec3 edge1 = attributes.Position(corners[1].position) - p0;
+            glm::vec3 edge2 = attributes.Position(corners[2].position) - p0;
+            faceNormal = glm::normalize(glm::cross(edge1, edge2));
+        }
+
+        // Fan triangulation, which gives the same 0,1,2 / 0,2,3 split as before for quads
+        for (size_t tri = 1; tri + 1 < cornerCount; ++tri) {
+            for (size_t i : { size_t(0), tri, tri + 1 }) {
+                const FaceCorner& corner = corners[i];
+                Vertex vertex{};
+                vertex.Position = attributes.Position(corner.position);
+
+                if (!computeFaceNormals && corner.normal >= 0) {
+                    vertex.Normal = attributes.Normal(corner.normal);  // Use normals from file
+                }
+                else {
+                    vertex.Normal = faceNormal;  // Use computed face normal
+                }
+
+                if (corner.texCoord >= 0) {
+                    vertex.TexCoords = attributes.TexCoord(corner.texCoord);
+                }
+
+                emit(vertex, corner);
+            }
+        }
+    }
+
+    inline uint64_t MixHash(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    inline uint64_t HashWords(const uint32_t* words, size_t count) {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < count; ++i)
+            hash = (hash + words[i]) * 0x9e3779b97f4a7c15ull;
+        return MixHash(hash);
+    }
+
+    inline uint32_t FloatBits(float value) {
+        if (value == 0.0f)
+            return 0; // -0 and +0 compare equal, so they must hash equal too
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Welds vertices into an output array through a VertexWeldTable. The key depends on the mode:
+    // the resolved v/vt/vn triple when the vertex is fully defined by it, the exact attribute values,
+    // or the attribute values snapped to a grid of weldEpsilon.
+    class VertexWelder {
+    public:
+        enum class Mode { IndexTriple, ExactValue, Epsilon };
+
+        VertexWelder(const OBJLoadOptions& options, size_t expectedVertices)
+            : m_Mode(Mode::ExactValue), m_InverseEpsilon(1.0f)
+        {
+            if (options.weldMode == OBJWeldMode::Epsilon && options.weldEpsilon > 0.0f) {
+                m_Mode = Mode::Epsilon;
+                m_InverseEpsilon = 1.0f / options.weldEpsilon;
+            }
+            else if (options.weldMode == OBJWeldMode::Auto && !options.computeFaceNormals) {
+                m_Mode = Mode::IndexTriple; // Face normals make a vertex depend on more than its indices
+            }
+            m_Table.Reserve(expectedVertices);
+            if (m_Mode == Mode::IndexTriple)
+                m_Corners.reserve(expectedVertices);
+        }
+
+        // Returns the index of 'vertex' in 'vertices', appending it if it hasn't been seen yet
+        unsigned int Weld(const Vertex& vertex, const FaceCorner& corner, std::vector<Vertex>& vertices) {
+            const uint32_t newIndex = static_cast<uint32_t>(vertices.size());
+            std::pair<uint32_t, bool> result;
+
+            if (m_Mode == Mode::IndexTriple) {
+                const uint32_t words[3] = { static_cast<uint32_t>(corner.position), static_cast<uint32_t>(corner.texCoord), static_cast<uint32_t>(corner.normal) };
+                result = m_Table.FindOrInsert(HashWords(words, 3), newIndex, [&](uint32_t index) { return m_Corners[index] == corner; });
+                if (result.second)
+                    m_Corners.push_back(corner);
+            }
+            else if (m_Mode == Mode::ExactValue) {
+                uint32_t words[8];
+                GetValueKey(vertex, words);
+                result = m_Table.FindOrInsert(HashWords(words, 8), newIndex, [&](uint32_t index) { return VertexEqual()(vertices[index], vertex); });
+            }
+            else {
+                uint32_t words[8], other[8];
+                GetQuantizedKey(vertex, words);
+                result = m_Table.FindOrInsert(HashWords(words, 8), newIndex, [&](uint32_t index) {
+                    GetQuantizedKey(vertices[index], other);
+                    return std::memcmp(words, other, sizeof(words)) == 0;
+                });
+            }
+
+            if (result.second)
+                vertices.push_back(vertex);
+            return result.first;
+        }
+
+        // Forgets every welded vertex but keeps the allocations, so the next batch starts empty
+        void Reset() {
+            m_Table.Reset();
+            m_Corners.clear();
+        }
+
+        // Corner of every welded vertex, in output order (index triple mode only)
+        const std::vector<FaceCorner>& GetCorners() const { return m_Corners; }
+
+        size_t GetMemoryUsage() const { return m_Table.GetMemoryUsage() + m_Corners.capacity() * sizeof(FaceCorner); }
+
+    private:
+        Mode m_Mode;
+        float m_InverseEpsilon;
+        VertexWeldTable m_Table;
+        std::vector<FaceCorner> m_Corners;
+
+        static void GetValueKey(const Vertex& vertex, uint32_t* words) {
+            const float values[8] = { vertex.Position.x, vertex.Position.y, vertex.Position.z,
+                vertex.Normal.x, vertex.Normal.y, vertex.Normal.z, vertex.TexCoords.x, vertex.TexCoords.y };
+            for (int i = 0; i < 8; ++i)
+                words[i] = FloatBits(values[i]);
+        }
+
+        void GetQuantizedKey(const Vertex& vertex, uint32_t* words) const {
+            const float values[8] = { vertex.Position.x, vertex.Position.y, vertex.Position.z,
+                vertex.Normal.x, vertex.Normal.y, vertex.Normal.z, vertex.TexCoords.x, vertex.TexCoords.y };
+            for (int i = 0; i < 8; ++i) {
+                double cell = std::floor(static_cast<double>(values[i]) * m_InverseEpsilon + 0.5);
+                cell = std::clamp(cell, -2147483648.0, 2147483647.0);
+                words[i] = static_cast<uint32_t>(static_cast<int32_t>(cell));
+            }
+        }
+    };
+
+    struct OBJRecordCounts {
+        size_t positions = 0;
+        size_t faces = 0;
+    };
+
+    // Number of position and face records in the file, used to pre-size buffers before parsing
+    OBJRecordCounts CountRecords(const char* p, const char* end) {
+        OBJRecordCounts counts;
+        while (p < end) {
+            const char* cursor = SkipBlanks(p, end);
+            if (end - cursor > 1 && IsBlank(cursor[1])) {
+                if (cursor[0] == 'v')
+                    ++counts.positions;
+                else if (cursor[0] == 'f')
+                    ++counts.faces;
+            }
+            p = NextLine(cursor, end) + 1;
+        }
+        return counts;
+    }
+
+    // Rough unique vertex count: flat shading splits every corner, smooth meshes share each vertex
+    // between about six triangles. Files that repeat geometry weld far below that, so the guess is
+    // capped at the position count when it is known and the table grows past it if needed.
+    inline size_t EstimateVertexCount(size_t faceCount, size_t positionCount, const OBJLoadOptions& options) {
+        size_t estimate = options.computeFaceNormals ? faceCount * 3 : faceCount;
+        if (positionCount > 0 && estimate > positionCount)
+            estimate = positionCount;
+        return estimate;
+    }
+
+    void ComputeVertexNormals(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+        std::vector<glm::vec3> computedVertexNormals(vertices.size(), glm::vec3(0.0f));
+
+        // Accumulate normals for each vertex
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            unsigned int i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+            glm::vec3 normal = glm::normalize(glm::cross(
+                vertices[i1].Position - vertices[i0].Position,
+                vertices[i2].Position - vertices[i0].Position
+            ));
+            computedVertexNormals[i0] += normal;
+            computedVertexNormals[i1] += normal;
+            computedVertexNormals[i2] += normal;
+        }
+
+        // Normalize the accumulated normals
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            vertices[i].Normal = glm::normalize(computedVertexNormals[i]);
+        }
+    }
+
+    // Runs task(0) ... task(count - 1), one thread each, and waits for all of them
+    template<typename Task>
+    void RunParallel(size_t count, Task&& task) {
+        std::vector<std::thread> workers;
+        workers.reserve(count - 1);
+        for (size_t i = 1; i < count; ++i)
+            workers.emplace_back(task, i);
+        task(size_t(0));
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    // Files are only split once each chunk gets at least this much text, below that the thread
+    // startup and the merge cost more than they save.
+    constexpr size_t kMinParallelChunkBytes = 256 * 1024;
+
+    // Everything one worker produces for its slice of the file
+    struct OBJChunk {
+        const char* begin;
+        const char* end;
+
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+
+        // Faces keep their raw indices plus how many v/vt/vn records this chunk had read when the
+        // face was declared, so relative indices and range checks resolve exactly like the serial pass.
+        struct Face {
+            size_t firstCorner;
+            unsigned int cornerCount;
+            unsigned int positionCount, texCoordCount, normalCount;
+        };
+        std::vector<RawCorner> corners;
+        std::vector<Face> faces;
+
+        size_t positionOffset = 0, texCoordOffset = 0, normalOffset = 0;
+
+        // Vertices deduplicated within the chunk (in first use order) and indices into them
+        std::vector<Vertex> uniqueVertices;
+        std::vector<FaceCorner> uniqueCorners; // Weld keys of uniqueVertices, index triple mode only
+        std::vector<unsigned int> localIndices;
+        std::vector<unsigned int> globalIndex; // uniqueVertices[i] ends up as vertices[globalIndex[i]]
+        size_t indexOffset = 0;
+    };
+
+    void ParseChunk(OBJChunk& chunk) {
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* lineEnd = NextLine(p, chunk.end);
+            const char* cursor = SkipBlanks(p, lineEnd);
+            const char* keywordEnd = SkipToken(cursor, lineEnd);
+            const size_t keywordLength = keywordEnd - cursor;
+            p = lineEnd + 1;
+
+            if (keywordLength == 1 && cursor[0] == 'v') {
+                glm::vec3 pos;
+                ParseVec3(keywordEnd, lineEnd, pos);
+                chunk.positions.push_back(pos);
+            }
+            else if (keywordLength == 2 && cursor[0] == 'v' && cursor[1] == 't') {
+                glm::vec2 tex;
+                ParseTexCoord(keywordEnd, lineEnd, tex);
+                chunk.texCoords.push_back(tex);
+            }
+            else if (keywordLength == 2 && cursor[0] == 'v' && cursor[1] == 'n') {
+                glm::vec3 normal;
+                ParseVec3(keywordEnd, lineEnd, normal);
+                chunk.normals.push_back(normal);
+            }
+            else if (keywordLength == 1 && cursor[0] == 'f') {
+                OBJChunk::Face face;
+                face.firstCorner = chunk.corners.size();
+                face.positionCount = static_cast<unsigned int>(chunk.positions.size());
+                face.texCoordCount = static_cast<unsigned int>(chunk.texCoords.size());
+                face.normalCount = static_cast<unsigned int>(chunk.normals.size());
+
+                cursor = SkipBlanks(keywordEnd, lineEnd);
+                while (cursor < lineEnd) {
+                    RawCorner corner;
+                    cursor = SkipBlanks(ParseCorner(cursor, lineEnd, corner), lineEnd);
+                    chunk.corners.push_back(corner);
+                }
+
+                face.cornerCount = static_cast<unsigned int>(chunk.corners.size() - face.firstCorner);
+                if (face.cornerCount >= 3)
+                    chunk.faces.push_back(face);
+                else
+                    chunk.corners.resize(face.firstCorner);
+            }
+        }
+    }
+
+    void BuildChunkVertices(OBJChunk& chunk, const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords,
+        const std::vector<glm::vec3>& normals, const OBJLoadOptions& options) {
+        VertexWelder welder(options, EstimateVertexCount(chunk.faces.size(), positions.size(), options));
+        std::vector<FaceCorner> corners;
+
+        chunk.localIndices.reserve(chunk.corners.size() * 3 / 2);
+        for (const OBJChunk::Face& face : chunk.faces) {
+            corners.resize(face.cornerCount);
+            bool valid = true;
+            for (unsigned int i = 0; i < face.cornerCount && valid; ++i) {
+                valid = ResolveCorner(chunk.corners[face.firstCorner + i],
+                    chunk.positionOffset + face.positionCount, chunk.texCoordOffset + face.texCoordCount,
+                    chunk.normalOffset + face.normalCount, corners[i]);
+            }
+            if (!valid)
+                continue; // A face referencing a missing position can't be built
+
+            AttributeArrays attributes = { positions.data(), texCoords.data(), normals.data() };
+            TriangulateFace(corners.data(), corners.size(), attributes, options.computeFaceNormals,
+                [&](const Vertex& vertex, const FaceCorner& corner) {
+                    chunk.localIndices.push_back(welder.Weld(vertex, corner, chunk.uniqueVertices));
+                });
+        }
+        chunk.uniqueCorners = welder.GetCorners();
+
+        // The raw records are no longer needed, release them before the merge allocates the output
+        std::vector<RawCorner>().swap(chunk.corners);
+        std::vector<OBJChunk::Face>().swap(chunk.faces);
+    }
+
+    // Parallel load: parse chunks, concatenate attributes, build and weld vertices per chunk, then
+    // merge the chunk-local vertex sets in file order. Welding the chunks' first-use vertex lists in
+    // chunk order visits every distinct vertex in the same order as one serial pass would, so the
+    // final vertex order and indices are identical to the serial loader.
+    void LoadOBJParallel(const MappedFile& file, size_t chunkCount, const OBJLoadOptions& options,
+        std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool& hasFileNormals, OBJLoadStats* stats) {
+        std::vector<OBJChunk> chunks(chunkCount);
+
+        const char* const fileBegin = file.GetData();
+        const char* const fileEnd = fileBegin + file.GetSize();
+        const char* chunkBegin = fileBegin;
+        for (size_t i = 0; i < chunkCount; ++i) {
+            const char* chunkEnd = (i + 1 == chunkCount) ? fileEnd : fileBegin + file.GetSize() * (i + 1) / chunkCount;
+            if (chunkEnd < chunkBegin)
+                chunkEnd = chunkBegin;
+            if (chunkEnd < fileEnd)
+                chunkEnd = std::min(NextLine(chunkEnd, fileEnd) + 1, fileEnd); // Split on line boundaries only
+            chunks[i].begin = chunkBegin;
+            chunks[i].end = chunkEnd;
+            chunkBegin = chunkEnd;
+        }
+
+        RunParallel(chunkCount, [&](size_t i) { ParseChunk(chunks[i]); });
+
+        size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+        for (OBJChunk& chunk : chunks) {
+            chunk.positionOffset = positionCount;
+            chunk.texCoordOffset = texCoordCount;
+            chunk.normalOffset = normalCount;
+            positionCount += chunk.positions.size();
+            texCoordCount += chunk.texCoords.size();
+            normalCount += chunk.normals.size();
+        }
+        hasFileNormals = normalCount > 0;
+
+        std::vector<glm::vec3> positions(positionCount);
+        std::vector<glm::vec2> texCoords(texCoordCount);
+        std::vector<glm::vec3> normals(normalCount);
+        RunParallel(chunkCount, [&](size_t i) {
+            OBJChunk& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionOffset);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordOffset);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalOffset);
+            std::vector<glm::vec3>().swap(chunk.positions);
+            std::vector<glm::vec2>().swap(chunk.texCoords);
+            std::vector<glm::vec3>().swap(chunk.normals);
+        });
+
+        RunParallel(chunkCount, [&](size_t i) {
+            BuildChunkVertices(chunks[i], positions, texCoords, normals, options);
+        });
+
+        size_t uniqueCount = 0, indexCount = 0, chunkBytes = 0;
+        for (OBJChunk& chunk : chunks) {
+            chunk.indexOffset = indexCount;
+            indexCount += chunk.localIndices.size();
+            uniqueCount += chunk.uniqueVertices.size();
+            chunkBytes += chunk.uniqueVertices.capacity() * sizeof(Vertex) + chunk.uniqueCorners.capacity() * sizeof(FaceCorner) +
+                chunk.localIndices.capacity() * sizeof(unsigned int);
+        }
+
+        // Serial weld of the (much smaller) per-chunk unique vertex lists, in file order
+        VertexWelder welder(options, uniqueCount);
+        vertices.reserve(uniqueCount);
+        for (OBJChunk& chunk : chunks) {
+            const bool hasCorners = !chunk.uniqueCorners.empty();
+            const FaceCorner noCorner = { -1, -1, -1 };
+            chunk.globalIndex.resize(chunk.uniqueVertices.size());
+            for (size_t i = 0; i < chunk.uniqueVertices.size(); ++i) {
+                chunk.globalIndex[i] = welder.Weld(chunk.uniqueVertices[i], hasCorners ? chunk.uniqueCorners[i] : noCorner, vertices);
+            }
+            std::vector<Vertex>().swap(chunk.uniqueVertices);
+            std::vector<FaceCorner>().swap(chunk.uniqueCorners);
+        }
+
+        indices.resize(indexCount);
+        RunParallel(chunkCount, [&](size_t i) {
+            const OBJChunk& chunk = chunks[i];
+            unsigned int* out = indices.data() + chunk.indexOffset;
+            for (size_t k = 0; k < chunk.localIndices.size(); ++k)
+                out[k] = chunk.globalIndex[chunk.localIndices[k]];
+        });
+
+        if (stats) {
+            const size_t attributeBytes = positions.capacity() * sizeof(glm::vec3) + normals.capacity() * sizeof(glm::vec3) +
+                texCoords.capacity() * sizeof(glm::vec2);
+            stats->weldBytes = welder.GetMemoryUsage();
+            stats->peakBytes = attributeBytes + chunkBytes + welder.GetMemoryUsage() +
+                vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+        }
+    }
+
+    // Random access to one attribute kind (v, vt or vn) read straight from the mapping, used by the
+    // streaming loader instead of an attribute array. Only the line of every kBlockSize-th record is
+    // remembered; a lookup decodes the whole block it falls in into a small direct mapped cache.
+    // Faces of scanned meshes mostly reference recent vertices, so nearly every lookup is a hit.
+    template<typename T>
+    class StreamedAttributes {
+    public:
+        static constexpr size_t kBlockSize = 64;
+        static constexpr size_t kCacheBlocks = 4096; // Power of two, about 3 MB of decoded vec3 blocks
+
+        StreamedAttributes(const char* keyword, const char* fileEnd)
+            : m_Keyword(keyword), m_KeywordLength(std::strlen(keyword)), m_FileEnd(fileEnd), m_Count(0) {}
+
+        // Called by the parser for every record of this kind, in file order
+        void OnRecord(const char* line) {
+            if (m_Count % kBlockSize == 0)
+                m_BlockLines.push_back(line);
+            ++m_Count;
+        }
+
+        size_t GetCount() const { return m_Count; }
+
+        T Get(long long index) {
+            // The cache grows with the attribute count up to kCacheBlocks, so small files stay small
+            if (m_Cache.size() < kCacheBlocks && m_Cache.size() < m_BlockLines.size()) {
+                size_t capacity = std::max<size_t>(m_Cache.size(), 16);
+                while (capacity < m_BlockLines.size() && capacity < kCacheBlocks)
+                    capacity <<= 1;
+                m_Cache.assign(capacity, Block());
+            }
+
+            const size_t record = static_cast<size_t>(index);
+            const size_t blockIndex = record / kBlockSize;
+            Block& block = m_Cache[blockIndex & (m_Cache.size() - 1)];
+            if (block.blockIndex != blockIndex) {
+                block.blockIndex = blockIndex;
+                block.count = 0;
+                block.next = m_BlockLines[blockIndex];
+            }
+            // A block decoded while it was still being read only holds the records seen at the time
+            if (record % kBlockSize >= block.count)
+                Decode(block);
+            return block.values[record % kBlockSize];
+        }
+
+        size_t GetMemoryUsage() const { return m_BlockLines.capacity() * sizeof(const char*) + m_Cache.capacity() * sizeof(Block); }
+
+    private:
+        struct Block {
+            size_t blockIndex = SIZE_MAX;
+            size_t count = 0;
+            const char* next = nullptr; // Line to resume decoding from
+            T values[kBlockSize];
+        };
+
+        const char* m_Keyword;
+        size_t m_KeywordLength;
+        const char* m_FileEnd;
+        size_t m_Count;
+        std::vector<const char*> m_BlockLines;
+        std::vector<Block> m_Cache;
+
+        // Decodes every record of the block that has been read so far
+        void Decode(Block& block) {
+            const size_t count = std::min(kBlockSize, m_Count - block.blockIndex * kBlockSize);
+            const char* p = block.next;
+            while (block.count < count && p < m_FileEnd) {
+                const char* lineEnd = NextLine(p, m_FileEnd);
+                const char* cursor = SkipBlanks(p, lineEnd);
+                const char* keywordEnd = SkipToken(cursor, lineEnd);
+                p = lineEnd + 1;
+
+                if (static_cast<size_t>(keywordEnd - cursor) != m_KeywordLength || std::memcmp(cursor, m_Keyword, m_KeywordLength) != 0)
+                    continue;
+                if constexpr (std::is_same_v<T, glm::vec2>)
+                    ParseTexCoord(keywordEnd, lineEnd, block.values[block.count++]);
+                else
+                    ParseVec3(keywordEnd, lineEnd, block.values[block.count++]);
+            }
+            block.next = p;
+        }
+    };
+
+    // Attribute source for TriangulateFace backed by the mapping
+    struct StreamedAttributeSet {
+        StreamedAttributes<glm::vec3> positions;
+        StreamedAttributes<glm::vec2> texCoords;
+        StreamedAttributes<glm::vec3> normals;
+
+        StreamedAttributeSet(const char* fileEnd)
+            : positions("v", fileEnd), texCoords("vt", fileEnd), normals("vn", fileEnd) {}
+
+        glm::vec3 Position(long long index) { return positions.Get(index); }
+        glm::vec2 TexCoord(long long index) { return texCoords.Get(index); }
+        glm::vec3 Normal(long long index) { return normals.Get(index); }
+
+        size_t GetMemoryUsage() const { return positions.GetMemoryUsage() + texCoords.GetMemoryUsage() + normals.GetMemoryUsage(); }
+    };
+}
+
 bool OBJLoader::LoadOBJ(const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool computeFaceNormals, bool computeVertexNormals) {
+    OBJLoadOptions options;
+    options.computeFaceNormals = computeFaceNormals;
+    options.computeVertexNormals = computeVertexNormals;
+    return LoadOBJ(path, vertices, indices, options);
+}
+
+bool OBJLoader::LoadOBJ(const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const OBJLoadOptions& options) {
+    MappedFile file(path);
+    if (!file.IsOpen()) {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return false;
+    }
+
+    size_t threadCount = options.threadCount ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkCount = std::min(threadCount, file.GetSize() / kMinParallelChunkBytes);
+    if (chunkCount > 1) {
+        bool hasFileNormals = false;
+        LoadOBJParallel(file, chunkCount, options, vertices, indices, hasFileNormals, options.stats);
+
+        // If we need vertex normals and they are not in the file, compute them
+        if (options.computeVertexNormals && !hasFileNormals) {
+            ComputeVertexNormals(vertices, indices);
+        }
+        return true;
+    }
+
+    std::vector<glm::vec3> temp_positions;
+    std::vector<glm::vec3> temp_normals;
+    std::vector<glm::vec2> temp_texCoords;
+
+    const char* p = file.GetData();
+    const char* const fileEnd = p + file.GetSize();
+
+    // A quick pass over the mapping to size the weld table and index buffer before parsing
+    const OBJRecordCounts counts = CountRecords(p, fileEnd);
+    VertexWelder welder(options, EstimateVertexCount(counts.faces, counts.positions, options));
+    indices.reserve(indices.size() + counts.faces * 3);
+
+    // Reused for every face so polygons don't allocate once it has grown to the largest face
+    std::vector<FaceCorner> corners;
+
+    while (p < fileEnd) {
+        const char* lineEnd = NextLine(p, fileEnd);
+        const char* cursor = SkipBlanks(p, lineEnd);
+        const char* keywordEnd = SkipToken(cursor, lineEnd);
+        const size_t keywordLength = keywordEnd - cursor;
+        p = lineEnd + 1;
+
+        if (keywordLength == 1 && cursor[0] == 'v') {  // Vertex position
+            glm::vec3 pos;
+            ParseVec3(keywordEnd, lineEnd, pos);
+            temp_positions.push_back(pos);
+        }
+        else if (keywordLength == 2 && cursor[0] == 'v' && cursor[1] == 't') {  // Texture coordinate
+            glm::vec2 tex;
+            ParseTexCoord(keywordEnd, lineEnd, tex);
+            temp_texCoords.push_back(tex);
+        }
+        else if (keywordLength == 2 && cursor[0] == 'v' && cursor[1] == 'n') {  // Normal
+            glm::vec3 normal;
+            ParseVec3(keywordEnd, lineEnd, normal);
+            temp_normals.push_back(normal);
+        }
+        else if (keywordLength == 1 && cursor[0] == 'f') {  // Face (triangles, quads and convex polygons)
+            corners.clear();
+            bool valid = true;
+            cursor = SkipBlanks(keywordEnd, lineEnd);
+            while (cursor < lineEnd) {
+                RawCorner raw;
+                FaceCorner corner;
+                cursor = SkipBlanks(ParseCorner(cursor, lineEnd, raw), lineEnd);
+                valid = ResolveCorner(raw, temp_positions.size(), temp_texCoords.size(), temp_normals.size(), corner) && valid;
+                corners.push_back(corner);
+            }
+            if (!valid || corners.size() < 3)
+                continue; // A face referencing a missing position can't be built
+
+            AttributeArrays attributes = { temp_positions.data(), temp_texCoords.data(), temp_normals.data() };
+            TriangulateFace(corners.data(), corners.size(), attributes, options.computeFaceNormals, [&](const Vertex& vertex, const FaceCorner& corner) {
+                    indices.push_back(welder.Weld(vertex, corner, vertices));
+                });
+        }
+    }
+
+    if (options.stats) {
+        options.stats->weldBytes = welder.GetMemoryUsage();
+        options.stats->peakBytes = temp_positions.capacity() * sizeof(glm::vec3) + temp_normals.capacity() * sizeof(glm::vec3) +
+            temp_texCoords.capacity() * sizeof(glm::vec2) + welder.GetMemoryUsage() +
+            vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+    }
+
+    // If we need vertex normals and they are not in the file, compute them
+    if (options.computeVertexNormals && temp_normals.empty()) {
+        ComputeVertexNormals(vertices, indices);
+    }
+
+    return true;
+}
+
+bool OBJLoader::LoadOBJStreaming(const std::string& path, const OBJLoadOptions& options, const OBJBatchSink& sink) {
+    MappedFile file(path);
+    if (!file.IsOpen()) {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return false;
+    }
+
+    const char* p = file.GetData();
+    const char* const fileEnd = p + file.GetSize();
+
+    StreamedAttributeSet attributes(fileEnd);
+    const size_t maxVertices = std::max<size_t>(options.streamBatchVertices, 3);
+    const size_t maxIndices = std::max<size_t>(options.streamBatchIndices, 3);
+
+    // The only buffers that scale with the mesh are the block line indices; the batch buffers grow up
+    // to the batch limits once and are then reused for every batch
+    const size_t initialVertices = std::min<size_t>(maxVertices, 1 << 16);
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    vertices.reserve(initialVertices);
+    indices.reserve(std::min<size_t>(maxIndices, initialVertices * 3));
+    VertexWelder welder(options, initialVertices);
+    std::vector<FaceCorner> corners;
+
+    auto flush = [&]() {
+        if (indices.empty())
+            return true;
+        // Only this batch's faces contribute, see the seam limitation in OBJLoader.h
+        if (options.computeVertexNormals && attributes.normals.GetCount() == 0) {
+            ComputeVertexNormals(vertices, indices);
+        }
+        const bool keepGoing = sink(OBJMeshBatch{ vertices.data(), vertices.size(), indices.data(), indices.size() });
+        vertices.clear();
+        indices.clear();
+        welder.Reset();
+        return keepGoing;
+    };
+
+    while (p < fileEnd) {
+        const char* lineEnd = NextLine(p, fileEnd);
+        const char* cursor = SkipBlanks(p, lineEnd);
+        const char* keywordEnd = SkipToken(cursor, lineEnd);
+        const size_t keywordLength = keywordEnd - cursor;
+        p = lineEnd + 1;
+
+        if (keywordLength == 1 && cursor[0] == 'v') {
+            attributes.positions.OnRecord(cursor);
+        }
+        else if (keywordLength == 2 && cursor[0] == 'v' && cursor[1] == 't') {
+            attributes.texCoords.OnRecord(cursor);
+        }
+        else if (keywordLength == 2 && cursor[0] == 'v' && cursor[1] == 'n') {
+            attributes.normals.OnRecord(cursor);
+        }
+        else if (keywordLength == 1 && cursor[0] == 'f') {
+            corners.clear();
+            bool valid = true;
+            cursor = SkipBlanks(keywordEnd, lineEnd);
+            while (cursor < lineEnd) {
+                RawCorner raw;
+                FaceCorner corner;
+                cursor = SkipBlanks(ParseCorner(cursor, lineEnd, raw), lineEnd);
+                valid = ResolveCorner(raw, attributes.positions.GetCount(), attributes.texCoords.GetCount(), attributes.normals.GetCount(), corner) && valid;
+                corners.push_back(corner);
+            }
+            if (!valid || corners.size() < 3)
+                continue; // A face referencing a missing position can't be built
+
+            // Start a new batch rather than split a face. A single polygon larger than the limits gets a batch of its own.
+            const size_t faceIndices = (corners.size() - 2) * 3;
+            if (vertices.size() + faceIndices > maxVertices || indices.size() + faceIndices > maxIndices) {
+                if (!flush())
+                    return false;
+            }
+
+            TriangulateFace(corners.data(), corners.size(), attributes, options.computeFaceNormals, [&](const Vertex& vertex, const FaceCorner& corner) {
+                indices.push_back(welder.Weld(vertex, corner, vertices));
+            });
+        }
+    }
+
+    if (options.stats) {
+        options.stats->weldBytes = welder.GetMemoryUsage();
+        options.stats->peakBytes = attributes.GetMemoryUsage() + welder.GetMemoryUsage() + corners.capacity() * sizeof(FaceCorner) +
+            vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+    }
+
+    return flush();
+}
+
+bool OBJLoader::LoadOBJLegacy(const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool computeFaceNormals, bool computeVertexNormals, OBJLoadStats* stats) {
     std::vector<glm::vec3> temp_positions;
     std::vector<glm::vec3> temp_normals;
     std::vector<glm::vec2> temp_texCoords;
@@ -137,6 +957,16 @@ bool OBJLoader::LoadOBJ(const std::string& path, std::vector<Vertex>& vertices,
         }
     }
 
+    if (stats) {
+        // Estimated std::unordered_map footprint: one node per entry (next pointer, cached hash, key and
+        // value) plus the bucket array
+        stats->weldBytes = vertexMap.size() * (sizeof(std::pair<const Vertex, unsigned int>) + sizeof(void*) + sizeof(size_t)) +
+            vertexMap.bucket_count() * sizeof(void*);
+        stats->peakBytes = temp_positions.capacity() * sizeof(glm::vec3) + temp_normals.capacity() * sizeof(glm::vec3) +
+            temp_texCoords.capacity() * sizeof(glm::vec2) + stats->weldBytes +
+            vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+    }
+
     // If we need vertex normals and they are not in the file, compute them
     if (computeVertexNormals && temp_normals.empty()) {
         std::vector<glm::vec3> computedVertexNormals(vertices.size(), glm::vec3(0.0f));
@@ -2,9 +2,67 @@
 
 #include <vector>
 #include <string>
+#include <functional>
 #include "Vertex.h"
 
+enum class OBJWeldMode {
+    Auto,       // Weld on the v/vt/vn index triple, or on exact values when face normals are computed
+    ExactValue, // Weld vertices whose position, normal and texture coordinates compare equal
+    Epsilon,    // Weld vertices whose attributes fall in the same weldEpsilon sized grid cell
+};
+
+// Filled in by the loader when OBJLoadOptions::stats is set
+struct OBJLoadStats {
+    size_t weldBytes = 0;  // Memory held by the vertex welding structures
+    size_t peakBytes = 0;  // Approximate peak of loader owned memory (attributes, welding and output)
+};
+
+struct OBJLoadOptions {
+    bool computeFaceNormals = false;
+    bool computeVertexNormals = false;
+
+    // Worker threads used to parse and weld. 1 keeps the serial loader, 0 uses every hardware thread.
+    // Large files are split on line boundaries and merged back so the output is bit-identical to the
+    // serial loader; small files always load serially.
+    unsigned int threadCount = 1;
+
+    OBJWeldMode weldMode = OBJWeldMode::Auto;
+    float weldEpsilon = 1e-5f;
+
+    // LoadOBJStreaming only: a batch goes to the sink before it would exceed either limit
+    size_t streamBatchVertices = 1 << 16;
+    size_t streamBatchIndices = 3 << 16;
+
+    OBJLoadStats* stats = nullptr;
+};
+
+// One bounded slice of a streamed mesh. Indices refer to this batch's vertices, and both arrays are
+// only valid for the duration of the sink call.
+struct OBJMeshBatch {
+    const Vertex* vertices;
+    size_t vertexCount;
+    const unsigned int* indices;
+    size_t indexCount;
+};
+
+// Receives the batches of OBJLoader::LoadOBJStreaming in file order. Returning false stops the load.
+using OBJBatchSink = std::function<bool(const OBJMeshBatch&)>;
+
 class OBJLoader {
 public:
+    // Memory maps the file and tokenizes it in place (std::from_chars, no per-line allocations)
     static bool LoadOBJ(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool computeFaceNormals, bool computeVertexNormals);
+    static bool LoadOBJ(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const OBJLoadOptions& options);
+
+    // Bounded memory load for files too large to materialize: attributes are read back from the
+    // mapping on demand instead of being copied into arrays, and welded vertices are handed to 'sink'
+    // in batches instead of being accumulated. Vertices are only welded within a batch. Always serial,
+    // threadCount is ignored.
+    // Limitation: when the file has no "vn" records, computeVertexNormals only averages the faces of
+    // each batch, so faces sharing a vertex across a batch boundary get a visible seam. Load such files
+    // with LoadOBJ, or use computeFaceNormals, when smooth normals matter.
+    static bool LoadOBJStreaming(const std::string& filePath, const OBJLoadOptions& options, const OBJBatchSink& sink);
+
+    // Original std::getline/std::istringstream parser, kept as the baseline for the load benchmark
+    static bool LoadOBJLegacy(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool computeFaceNormals, bool computeVertexNormals, OBJLoadStats* stats = nullptr);
 };
\ No newline at end of file
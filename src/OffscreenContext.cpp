@@ -0,0 +1,135 @@
+#include "OffscreenContext.h"
+
+#include <iostream>
+
+#if defined(_WIN32) || defined(__APPLE__)
+
+#include <GLFW/glfw3.h>
+
+OffscreenContext::OffscreenContext(int width, int height)
+    : m_IsValid(false), m_Window(nullptr)
+{
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW for the offscreen context" << std::endl;
+        return;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(width, height, "OpenGL Test Application (headless)", NULL, NULL);
+    if (!window) {
+        std::cerr << "Failed to create the hidden offscreen window" << std::endl;
+        glfwTerminate();
+        return;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0); // Never wait for vblank, benchmarks run uncapped
+    m_Window = window;
+    m_IsValid = true;
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    if (m_Window) {
+        glfwDestroyWindow(static_cast<GLFWwindow*>(m_Window));
+        glfwTerminate();
+    }
+}
+
+#else
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+OffscreenContext::OffscreenContext(int width, int height)
+    : m_IsValid(false), m_Display(EGL_NO_DISPLAY), m_Context(EGL_NO_CONTEXT), m_Surface(EGL_NO_SURFACE)
+{
+    // Prefer Mesa's surfaceless platform, which needs neither a display server nor a GPU
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cerr << "Failed to initialize EGL (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return;
+    }
+    m_Display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL implementation does not support desktop OpenGL" << std::endl;
+        return;
+    }
+
+    const char* displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+    const bool surfaceless = displayExtensions && std::strstr(displayExtensions, "EGL_KHR_surfaceless_context");
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        std::cerr << "No suitable EGL config for an offscreen OpenGL context" << std::endl;
+        return;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL 3.3 core EGL context (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return;
+    }
+    m_Context = context;
+
+    EGLSurface surface = EGL_NO_SURFACE;
+    if (!surfaceless) {
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        if (surface == EGL_NO_SURFACE) {
+            std::cerr << "Failed to create an EGL pbuffer surface" << std::endl;
+            return;
+        }
+        m_Surface = surface;
+    }
+
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Failed to make the offscreen context current" << std::endl;
+        return;
+    }
+    m_IsValid = true;
+}
+
+OffscreenContext::~OffscreenContext()
+{
+    if (m_Display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_Surface != EGL_NO_SURFACE)
+        eglDestroySurface(m_Display, m_Surface);
+    if (m_Context != EGL_NO_CONTEXT)
+        eglDestroyContext(m_Display, m_Context);
+    eglTerminate(m_Display);
+}
+
+#endif
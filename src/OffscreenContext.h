@@ -0,0 +1,27 @@
+#pragma once
+
+// OpenGL 3.3 core context without a visible window, for headless runs. On Linux it is an EGL context
+// made current without a surface (Mesa's software rasterizer works, no display or GPU needed); when
+// the driver lacks surfaceless support a small pbuffer is used instead. On Windows and macOS it is a
+// hidden GLFW window. All rendering is expected to go to a Framebuffer, never to the default framebuffer.
+class OffscreenContext {
+public:
+    OffscreenContext(int width, int height);
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    inline bool IsValid() const { return m_IsValid; }
+
+private:
+    bool m_IsValid;
+
+#if defined(_WIN32) || defined(__APPLE__)
+    void* m_Window;     // GLFWwindow*
+#else
+    void* m_Display;    // EGLDisplay, kept as void* so the EGL headers stay out of this header
+    void* m_Context;    // EGLContext
+    void* m_Surface;    // EGLSurface, only set for the pbuffer fallback
+#endif
+};
@@ -0,0 +1,112 @@
+#include "PackedVertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr float kPositionSteps = 32767.0f;  // Quantized positions span -32767..32767
+
+    // Snorm with bits bits, the GL 4.2 conversion: c / (2^(bits - 1) - 1)
+    float UnpackSnorm(uint32_t value, int bits) {
+        const int32_t signedValue = static_cast<int32_t>(value << (32 - bits)) >> (32 - bits);
+        return std::max(static_cast<float>(signedValue) / static_cast<float>((1 << (bits - 1)) - 1), -1.0f);
+    }
+}
+
+VertexQuantization VertexQuantization::FromBounds(const Bounds& bounds) {
+    VertexQuantization quantization;
+    if (!bounds.valid)
+        return quantization;
+
+    // Flat axes still need a non zero step
+    const glm::vec3 extent = glm::max(bounds.GetExtent(), glm::vec3(1e-20f));
+    quantization.scale = extent / kPositionSteps;
+    quantization.offset = (bounds.min + bounds.max) * 0.5f;
+    return quantization;
+}
+
+void VertexPacker::Pack(const Vertex* vertices, size_t count, const VertexQuantization& quantization, PackedVertex* packed) {
+    const glm::vec3 inverseScale = glm::vec3(1.0f) / quantization.scale;
+    for (size_t i = 0; i < count; i++) {
+        const Vertex& vertex = vertices[i];
+        const glm::vec3 grid = glm::clamp((vertex.Position - quantization.offset) * inverseScale, glm::vec3(-kPositionSteps), glm::vec3(kPositionSteps));
+        PackedVertex& out = packed[i];
+        out.Position[0] = static_cast<int16_t>(std::lround(grid.x));
+        out.Position[1] = static_cast<int16_t>(std::lround(grid.y));
+        out.Position[2] = static_cast<int16_t>(std::lround(grid.z));
+        out.Position[3] = 0;
+        out.Normal = PackNormal(vertex.Normal);
+        out.TexCoords[0] = PackHalf(vertex.TexCoords.x);
+        out.TexCoords[1] = PackHalf(vertex.TexCoords.y);
+    }
+}
+
+Vertex VertexPacker::Unpack(const PackedVertex& packed, const VertexQuantization& quantization) {
+    Vertex vertex;
+    vertex.Position = glm::vec3(packed.Position[0], packed.Position[1], packed.Position[2]) * quantization.scale + quantization.offset;
+    vertex.Normal = glm::vec3(UnpackSnorm(packed.Normal.bits, 10), UnpackSnorm(packed.Normal.bits >> 10, 10), UnpackSnorm(packed.Normal.bits >> 20, 10));
+    vertex.TexCoords = glm::vec2(UnpackHalf(packed.TexCoords[0]), UnpackHalf(packed.TexCoords[1]));
+    return vertex;
+}
+
+VertexBufferLayout VertexPacker::GetLayout(VertexFormat format) {
+    VertexBufferLayout layout;
+    if (format == VertexFormat::Packed) {
+        layout.Push<short>(4);              // Position, grid coordinates
+        layout.Push<PackedSnorm10x3>(1);    // Normal
+        layout.Push<HalfFloat>(2);          // TexCoords
+    }
+    else {
+        layout.Push<float>(3); // Position: 3 floats
+        layout.Push<float>(3); // Normal: 3 floats
+        layout.Push<float>(2); // TexCoords: 2 floats
+    }
+    return layout;
+}
+
+HalfFloat VertexPacker::PackHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+    if (magnitude >= 0x7F800000u) // Infinity stays infinity, NaN stays a quiet NaN
+        return { static_cast<uint16_t>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x0200u : 0u)) };
+    if (magnitude >= 0x477FF000u) // Rounds to 65536 or above
+        return { static_cast<uint16_t>(sign | 0x7C00u) };
+    if (magnitude < 0x38800000u) { // Below the smallest normal half, 2^-14: multiples of 2^-24
+        float absolute;
+        std::memcpy(&absolute, &magnitude, sizeof(absolute));
+        return { static_cast<uint16_t>(sign | static_cast<uint16_t>(std::nearbyint(absolute * 16777216.0f))) };
+    }
+
+    // Rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits to nearest even
+    magnitude += 0xC8000FFFu + ((magnitude >> 13) & 1u);
+    return { static_cast<uint16_t>(sign | (magnitude >> 13)) };
+}
+
+float VertexPacker::UnpackHalf(HalfFloat value) {
+    const uint32_t sign = static_cast<uint32_t>(value.bits & 0x8000u) << 16;
+    const uint32_t exponent = (value.bits >> 10) & 0x1Fu;
+    const uint32_t mantissa = value.bits & 0x3FFu;
+
+    float result;
+    if (exponent == 0) {
+        result = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -result : result;
+    }
+    const uint32_t bits = sign | (exponent == 0x1Fu ? 0x7F800000u : (exponent + 112u) << 23) | (mantissa << 13);
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+PackedSnorm10x3 VertexPacker::PackNormal(const glm::vec3& normal) {
+    uint32_t bits = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        const float component = std::isfinite(normal[axis]) ? std::clamp(normal[axis], -1.0f, 1.0f) : 0.0f;
+        const int32_t value = static_cast<int32_t>(std::lround(component * 511.0f));
+        bits |= (static_cast<uint32_t>(value) & 0x3FFu) << (axis * 10);
+    }
+    return { bits };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Vertex.h"
+#include "Bounds.h"
+#include "VertexBufferLayout.h"
+
+// How a Mesh keeps its vertices on the GPU
+enum class VertexFormat {
+    Float,      // Vertex as is, 32 bytes
+    Packed,     // PackedVertex, 16 bytes
+};
+
+// Vertex in half the memory. Positions are 16 bit integers on a grid over the mesh bounds, which
+// the vertex shader maps back with u_PositionScale and u_PositionOffset (see VertexQuantization).
+// Normals keep 10 bits per axis, texture coordinates are half floats so tiling UVs outside 0..1 work.
+struct PackedVertex {
+    int16_t Position[4];    // w is always 0 and keeps the normal 4 byte aligned
+    PackedSnorm10x3 Normal;
+    HalfFloat TexCoords[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed");
+
+// Maps quantized positions back to mesh units, position = quantized * scale + offset
+struct VertexQuantization {
+    glm::vec3 scale = glm::vec3(1.0f);
+    glm::vec3 offset = glm::vec3(0.0f);
+
+    // 65535 steps along each axis of bounds, so the error is at most half a step
+    static VertexQuantization FromBounds(const Bounds& bounds);
+};
+
+class VertexPacker {
+public:
+    static void Pack(const Vertex* vertices, size_t count, const VertexQuantization& quantization, PackedVertex* packed);
+    static Vertex Unpack(const PackedVertex& packed, const VertexQuantization& quantization);
+
+    // Attribute layout matching the shaders' aPos, aNormal and aTexCoord at locations 0 to 2
+    static VertexBufferLayout GetLayout(VertexFormat format);
+    static size_t GetVertexSize(VertexFormat format) { return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex); }
+
+    // Rounds to nearest even, overflows to infinity and keeps subnormals
+    static HalfFloat PackHalf(float value);
+    static float UnpackHalf(HalfFloat value);
+    static PackedSnorm10x3 PackNormal(const glm::vec3& normal);
+};
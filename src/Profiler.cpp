@@ -0,0 +1,429 @@
+#include "Profiler.h"
+#include "Renderer.h"
+#include "GLState.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <iostream>
+
+#include "imgui.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr unsigned int kNoQuery = 0xFFFFFFFFu;
+    constexpr size_t kQueryBatch = 64;
+    constexpr int kAverageFrames = 60;  // Window of the rolling averages
+
+    struct PendingZone {
+        const char* name;
+        int depth;
+        double cpuStartMs, cpuEndMs;
+        unsigned int beginQuery, endQuery;  // Indices into FrameSlot::queries
+    };
+
+    // Everything recorded for one in-flight frame
+    struct FrameSlot {
+        uint64_t index = 0;
+        bool pending = false;
+        double cpuMs = 0.0;
+        std::vector<PendingZone> zones;
+        std::vector<GLuint> queries;
+        size_t usedQueries = 0;
+    };
+
+    struct FrameTotals {
+        double calls, cpuMs, gpuMs;
+        bool hasGpuTimes;
+    };
+
+    // The last kAverageFrames per-frame totals of one zone name, summed as they go in and out
+    struct ZoneWindow {
+        FrameTotals frames[kAverageFrames] = {};
+        FrameTotals sum{ 0.0, 0.0, 0.0, false };
+        int gpuFrames = 0;
+    };
+
+    struct ProfilerState {
+        bool enabled = true;
+        bool requestedEnabled = true;  // Applied at the next BeginFrame so zones never straddle a toggle
+        bool paused = false;
+        bool inFrame = false;
+        bool initialized = false;
+        bool gpuTimers = false;
+        uint64_t frameIndex = 0;
+        Clock::time_point frameStart;
+
+        FrameSlot slots[Profiler::kFrameLatency];
+        std::vector<size_t> openZones;
+        std::vector<GLuint64> timestamps;
+
+        Profiler::Frame lastFrame;
+        std::vector<Profiler::ZoneAverage> averages;
+        std::vector<ZoneWindow> windows;  // Parallel to averages
+        std::vector<FrameTotals> totals;
+        int windowFrames = 0;  // Frames in the window so far, up to kAverageFrames
+        int windowHead = 0;
+
+        std::vector<float> cpuHistory = std::vector<float>(Profiler::kHistoryFrames, 0.0f);
+        std::vector<float> gpuHistory = std::vector<float>(Profiler::kHistoryFrames, 0.0f);
+        int historyOffset = 0;
+    };
+
+    ProfilerState& State() {
+        static ProfilerState state;
+        return state;
+    }
+
+    FrameSlot& CurrentSlot(ProfilerState& state) {
+        return state.slots[state.frameIndex % Profiler::kFrameLatency];
+    }
+
+    double ElapsedMs(const ProfilerState& state) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - state.frameStart).count();
+    }
+
+    unsigned int IssueTimestamp(FrameSlot& slot) {
+        if (slot.usedQueries == slot.queries.size()) {
+            size_t oldSize = slot.queries.size();
+            slot.queries.resize(oldSize + std::max(kQueryBatch, oldSize));
+            GLCallV(glGenQueries((GLsizei)(slot.queries.size() - oldSize), &slot.queries[oldSize]));
+        }
+        GLCallV(glQueryCounter(slot.queries[slot.usedQueries], GL_TIMESTAMP));
+        return (unsigned int)slot.usedQueries++;
+    }
+
+    void UpdateAverages(ProfilerState& state) {
+        const Profiler::Frame& frame = state.lastFrame;
+
+        state.totals.assign(state.averages.size(), FrameTotals{ 0.0, 0.0, 0.0, frame.hasGpuTimes });
+        for (const Profiler::Zone& zone : frame.zones) {
+            size_t i = 0;
+            while (i < state.averages.size() && state.averages[i].name != zone.name)
+                ++i;
+            if (i == state.averages.size()) {
+                Profiler::ZoneAverage average;
+                average.name = zone.name;
+                state.averages.push_back(average);
+                state.windows.emplace_back();
+                state.totals.push_back(FrameTotals{ 0.0, 0.0, 0.0, frame.hasGpuTimes });
+            }
+            state.totals[i].calls += 1.0;
+            state.totals[i].cpuMs += zone.cpuEndMs - zone.cpuStartMs;
+            if (frame.hasGpuTimes)
+                state.totals[i].gpuMs += zone.gpuEndMs - zone.gpuStartMs;
+        }
+
+        // Every zone gets an entry each frame, zero if it wasn't hit, so the window stays aligned
+        state.windowFrames = std::min(state.windowFrames + 1, kAverageFrames);
+        for (size_t i = 0; i < state.averages.size(); ++i) {
+            ZoneWindow& window = state.windows[i];
+            FrameTotals& slot = window.frames[state.windowHead];
+            const FrameTotals& total = state.totals[i];
+
+            window.sum.calls += total.calls - slot.calls;
+            window.sum.cpuMs += total.cpuMs - slot.cpuMs;
+            window.sum.gpuMs += total.gpuMs - slot.gpuMs;
+            window.gpuFrames += (total.hasGpuTimes ? 1 : 0) - (slot.hasGpuTimes ? 1 : 0);
+            slot = total;
+
+            Profiler::ZoneAverage& average = state.averages[i];
+            average.calls = window.sum.calls / state.windowFrames;
+            average.cpuMs = window.sum.cpuMs / state.windowFrames;
+            average.gpuMs = window.gpuFrames > 0 ? window.sum.gpuMs / window.gpuFrames : 0.0;
+        }
+        state.windowHead = (state.windowHead + 1) % kAverageFrames;
+
+        // Drop zones that haven't been hit for a whole window, e.g. after switching tests
+        for (size_t i = state.averages.size(); i-- > 0;) {
+            if (state.windows[i].sum.calls < 0.5) {
+                state.averages.erase(state.averages.begin() + i);
+                state.windows.erase(state.windows.begin() + i);
+            }
+        }
+    }
+
+    // Turns a slot whose frame came round again into a Frame. Only reads the queries back if the GPU
+    // has already finished them, a slow GPU costs the frame its GPU times rather than a stall.
+    void ResolveSlot(ProfilerState& state, FrameSlot& slot) {
+        slot.pending = false;
+        if (state.paused || slot.zones.empty())
+            return;
+
+        bool hasGpuTimes = state.gpuTimers && slot.usedQueries > 0;
+        if (hasGpuTimes) {
+            // Timestamps are written in submission order, so the last one landing means all of them have
+            GLint available = 0;
+            GLCallV(glGetQueryObjectiv(slot.queries[slot.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+            hasGpuTimes = available != 0;
+        }
+        if (hasGpuTimes) {
+            state.timestamps.resize(slot.usedQueries);
+            for (size_t i = 0; i < slot.usedQueries; ++i) {
+                GLCallV(glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &state.timestamps[i]));
+            }
+        }
+
+        Profiler::Frame& frame = state.lastFrame;
+        frame.index = slot.index;
+        frame.cpuMs = slot.cpuMs;
+        frame.hasGpuTimes = hasGpuTimes;
+        frame.zones.clear();
+
+        const GLuint64 gpuBase = hasGpuTimes ? state.timestamps[slot.zones.front().beginQuery] : 0;
+        for (const PendingZone& pending : slot.zones) {
+            Profiler::Zone zone{ pending.name, pending.depth, pending.cpuStartMs, pending.cpuEndMs, 0.0, 0.0 };
+            if (hasGpuTimes && pending.endQuery != kNoQuery) {
+                zone.gpuStartMs = (double)(state.timestamps[pending.beginQuery] - gpuBase) * 1e-6;
+                zone.gpuEndMs = (double)(state.timestamps[pending.endQuery] - gpuBase) * 1e-6;
+            }
+            frame.zones.push_back(zone);
+        }
+        frame.gpuMs = hasGpuTimes ? frame.zones.front().gpuEndMs : 0.0;
+
+        state.cpuHistory[state.historyOffset] = (float)frame.cpuMs;
+        state.gpuHistory[state.historyOffset] = (float)frame.gpuMs;
+        state.historyOffset = (state.historyOffset + 1) % Profiler::kHistoryFrames;
+
+        UpdateAverages(state);
+    }
+
+    ImU32 ZoneColor(const char* name) {
+        uint32_t hash = 2166136261u;
+        for (const char* c = name; *c; ++c)
+            hash = (hash ^ (unsigned char)*c) * 16777619u;
+        return IM_COL32(70 + (hash & 0x7F), 70 + ((hash >> 8) & 0x7F), 70 + ((hash >> 16) & 0x7F), 255);
+    }
+
+    // One lane of the timeline, zones stacked by depth. Returns the lane height.
+    float DrawTimelineLane(const Profiler::Frame& frame, bool gpu, float scale, float width) {
+        const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+        int depthCount = 1;
+        for (const Profiler::Zone& zone : frame.zones)
+            depthCount = std::max(depthCount, zone.depth + 1);
+
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        drawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + depthCount * rowHeight), IM_COL32(30, 30, 30, 255));
+
+        for (const Profiler::Zone& zone : frame.zones) {
+            double start = gpu ? zone.gpuStartMs : zone.cpuStartMs;
+            double end = gpu ? zone.gpuEndMs : zone.cpuEndMs;
+
+            ImVec2 min(origin.x + (float)(start * scale), origin.y + zone.depth * rowHeight);
+            ImVec2 max(std::max(min.x + 1.0f, origin.x + (float)(end * scale)), min.y + rowHeight - 1.0f);
+            drawList->AddRectFilled(min, max, ZoneColor(zone.name));
+
+            if (max.x - min.x > ImGui::CalcTextSize(zone.name).x + 4.0f)
+                drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(255, 255, 255, 255), zone.name);
+            if (ImGui::IsMouseHoveringRect(min, max))
+                ImGui::SetTooltip("%s\n%s %.3f ms", zone.name, gpu ? "GPU" : "CPU", end - start);
+        }
+
+        float height = depthCount * rowHeight;
+        ImGui::Dummy(ImVec2(width, height));
+        return height;
+    }
+}
+
+void Profiler::BeginFrame()
+{
+    ProfilerState& state = State();
+    state.enabled = state.requestedEnabled;
+    if (!state.enabled)
+        return;
+
+    if (!state.initialized) {
+        state.initialized = true;
+        state.gpuTimers = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+        if (!state.gpuTimers)
+            std::cout << "Profiler: timer queries unavailable, recording CPU times only" << std::endl;
+    }
+
+    FrameSlot& slot = CurrentSlot(state);
+    if (slot.pending)
+        ResolveSlot(state, slot);
+
+    slot.index = state.frameIndex;
+    slot.pending = true;
+    slot.zones.clear();
+    slot.usedQueries = 0;
+    state.openZones.clear();
+    state.frameStart = Clock::now();
+    state.inFrame = true;
+
+    PushZone("Frame");
+}
+
+void Profiler::EndFrame()
+{
+    ProfilerState& state = State();
+    if (!state.inFrame)
+        return;
+
+    // Close anything left open so a missing PopZone can't leak into the next frame
+    while (!state.openZones.empty())
+        PopZone();
+
+    CurrentSlot(state).cpuMs = ElapsedMs(state);
+    state.inFrame = false;
+    ++state.frameIndex;
+}
+
+bool Profiler::PushZone(const char* name)
+{
+    ProfilerState& state = State();
+    if (!state.inFrame)
+        return false;
+
+    FrameSlot& slot = CurrentSlot(state);
+    PendingZone zone{ name, (int)state.openZones.size(), ElapsedMs(state), 0.0, kNoQuery, kNoQuery };
+    if (state.gpuTimers)
+        zone.beginQuery = IssueTimestamp(slot);
+
+    state.openZones.push_back(slot.zones.size());
+    slot.zones.push_back(zone);
+    return true;
+}
+
+void Profiler::PopZone()
+{
+    ProfilerState& state = State();
+    if (!state.inFrame || state.openZones.empty())
+        return;
+
+    FrameSlot& slot = CurrentSlot(state);
+    PendingZone& zone = slot.zones[state.openZones.back()];
+    state.openZones.pop_back();
+
+    zone.cpuEndMs = ElapsedMs(state);
+    if (state.gpuTimers)
+        zone.endQuery = IssueTimestamp(slot);
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+    State().requestedEnabled = enabled;
+}
+
+bool Profiler::IsEnabled()
+{
+    return State().requestedEnabled;
+}
+
+const Profiler::Frame& Profiler::GetLastFrame()
+{
+    return State().lastFrame;
+}
+
+const std::vector<Profiler::ZoneAverage>& Profiler::GetAverages()
+{
+    return State().averages;
+}
+
+void Profiler::OnImGuiRender()
+{
+    ProfilerState& state = State();
+    PROFILE_SCOPE("Profiler::OnImGuiRender");
+
+    ImGui::Begin("Profiler");
+
+    bool enabled = state.requestedEnabled;
+    if (ImGui::Checkbox("Enabled", &enabled))
+        state.requestedEnabled = enabled;
+    ImGui::SameLine();
+    ImGui::Checkbox("Pause", &state.paused);
+    if (state.initialized && !state.gpuTimers) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(no timer queries, CPU only)");
+    }
+
+    const Frame& frame = state.lastFrame;
+    if (frame.hasGpuTimes)
+        ImGui::Text("Frame %llu   CPU %.3f ms   GPU %.3f ms", (unsigned long long)frame.index, frame.cpuMs, frame.gpuMs);
+    else
+        ImGui::Text("Frame %llu   CPU %.3f ms   GPU n/a", (unsigned long long)frame.index, frame.cpuMs);
+
+    float graphWidth = ImGui::GetContentRegionAvail().x * 0.5f - 4.0f;
+    ImGui::PlotLines("##CPU", state.cpuHistory.data(), kHistoryFrames, state.historyOffset, "CPU ms", 0.0f, FLT_MAX, ImVec2(graphWidth, 40.0f));
+    ImGui::SameLine();
+    ImGui::PlotLines("##GPU", state.gpuHistory.data(), kHistoryFrames, state.historyOffset, "GPU ms", 0.0f, FLT_MAX, ImVec2(graphWidth, 40.0f));
+
+    if (!frame.zones.empty()) {
+        // Both lanes share one time scale so CPU and GPU bars line up
+        float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+        double span = std::max(frame.cpuMs, frame.hasGpuTimes ? frame.gpuMs : 0.0);
+        float scale = span > 0.0 ? (float)(width / span) : 0.0f;
+
+        ImGui::Text("CPU timeline");
+        DrawTimelineLane(frame, false, scale, width);
+        if (frame.hasGpuTimes) {
+            ImGui::Text("GPU timeline");
+            DrawTimelineLane(frame, true, scale, width);
+        }
+    }
+
+    if (ImGui::BeginTable("ProfilerAverages", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Calls / frame");
+        ImGui::TableSetupColumn("CPU ms");
+        ImGui::TableSetupColumn("GPU ms");
+        ImGui::TableHeadersRow();
+
+        for (const ZoneAverage& average : state.averages) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(average.name.c_str());
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.1f", average.calls);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", average.cpuMs);
+            ImGui::TableSetColumnIndex(3);
+            if (state.gpuTimers)
+                ImGui::Text("%.3f", average.gpuMs);
+            else
+                ImGui::TextDisabled("n/a");
+        }
+        ImGui::EndTable();
+    }
+
+    const GLState::Counters& stateCounters = GLState::GetFrameCounters();
+    if (ImGui::CollapsingHeader("GL state changes")) {
+        ImGui::Text("Last frame: %llu issued, %llu elided", (unsigned long long)stateCounters.TotalIssued(), (unsigned long long)stateCounters.TotalElided());
+        if (ImGui::BeginTable("ProfilerGLState", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("State");
+            ImGui::TableSetupColumn("Issued");
+            ImGui::TableSetupColumn("Elided");
+            ImGui::TableHeadersRow();
+            for (int kind = 0; kind < GLState::kKindCount; kind++) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(GLState::GetKindName(static_cast<GLState::Kind>(kind)));
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%llu", (unsigned long long)stateCounters.issued[kind]);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%llu", (unsigned long long)stateCounters.elided[kind]);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    ImGui::End();
+}
+
+void Profiler::Shutdown()
+{
+    ProfilerState& state = State();
+    for (FrameSlot& slot : state.slots) {
+        if (!slot.queries.empty()) {
+            GLCallV(glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data()));
+        }
+        slot.queries.clear();
+        slot.zones.clear();
+        slot.usedQueries = 0;
+        slot.pending = false;
+    }
+    state.inFrame = false;
+    state.initialized = false;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Frame profiler with nested CPU+GPU zones. A zone records the CPU clock and issues a GL_TIMESTAMP
+// query at both ends. Queries live in a ring of kFrameLatency frame slots and a slot is only read
+// back when it comes round again, so the GPU results arrive a few frames late but never stall the
+// pipeline. Zones are only recorded between BeginFrame and EndFrame, anywhere else PROFILE_SCOPE
+// costs one branch.
+class Profiler {
+public:
+    static constexpr int kFrameLatency = 4;
+    static constexpr int kHistoryFrames = 240;
+
+    struct Zone {
+        const char* name;   // Must outlive the profiler, zones are named with string literals
+        int depth;
+        double cpuStartMs, cpuEndMs;  // Relative to the start of the frame
+        double gpuStartMs, gpuEndMs;  // Relative to the first GPU timestamp of the frame
+    };
+
+    struct Frame {
+        uint64_t index = 0;
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+        bool hasGpuTimes = false;
+        std::vector<Zone> zones;  // In begin order, so a zone's children follow it
+    };
+
+    // Rolling per-frame totals of every zone with the same name
+    struct ZoneAverage {
+        std::string name;
+        double calls = 0.0;
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+    };
+
+    static void BeginFrame();
+    static void EndFrame();
+
+    // Returns false if nothing was recorded, in which case PopZone must not be called
+    static bool PushZone(const char* name);
+    static void PopZone();
+
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // The most recent frame whose GPU results have been read back
+    static const Frame& GetLastFrame();
+    static const std::vector<ZoneAverage>& GetAverages();
+
+    // Draws the "Profiler" window: frame time graph, zone timeline and rolling averages
+    static void OnImGuiRender();
+
+    // Releases the query objects, must be called while the GL context is still current
+    static void Shutdown();
+};
+
+class ProfileScope {
+public:
+    ProfileScope(const char* name)
+        : m_Active(Profiler::PushZone(name)) {}
+    ~ProfileScope() {
+        if (m_Active)
+            Profiler::PopZone();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    bool m_Active;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
@@ -0,0 +1,295 @@
+#include "RenderQueue.h"
+#include "GLState.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    constexpr uint32_t kIdBits = 12;
+    constexpr uint32_t kMaxId = (1u << kIdBits) - 1;
+    constexpr uint32_t kDepthBits = 24;
+
+    // Non negative floats order like their bit patterns, the top 24 bits below the sign keep the
+    // exponent and 15 bits of mantissa
+    uint64_t QuantizeDepth(float depth) {
+        if (!(depth > 0.0f))
+            return 0;
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return (bits >> (31 - kDepthBits)) & ((1u << kDepthBits) - 1);
+    }
+}
+
+RenderQueue::Command& RenderQueue::Command::Uniform(Shader::UniformId id, const glm::mat4& value)
+{
+    UniformValue uniform{ id, UniformType::Mat4, {} };
+    std::memcpy(uniform.floats, &value[0][0], sizeof(float) * 16);
+    m_Queue.m_Uniforms.push_back(uniform);
+    m_Queue.m_Draws[m_Index].uniformCount++;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Uniform(Shader::UniformId id, const glm::vec3& value)
+{
+    UniformValue uniform{ id, UniformType::Vec3, {} };
+    uniform.floats[0] = value.x;
+    uniform.floats[1] = value.y;
+    uniform.floats[2] = value.z;
+    m_Queue.m_Uniforms.push_back(uniform);
+    m_Queue.m_Draws[m_Index].uniformCount++;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Uniform(Shader::UniformId id, const glm::vec4& value)
+{
+    UniformValue uniform{ id, UniformType::Vec4, {} };
+    uniform.floats[0] = value.x;
+    uniform.floats[1] = value.y;
+    uniform.floats[2] = value.z;
+    uniform.floats[3] = value.w;
+    m_Queue.m_Uniforms.push_back(uniform);
+    m_Queue.m_Draws[m_Index].uniformCount++;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Uniform(Shader::UniformId id, float value)
+{
+    UniformValue uniform{ id, UniformType::Float, {} };
+    uniform.floats[0] = value;
+    m_Queue.m_Uniforms.push_back(uniform);
+    m_Queue.m_Draws[m_Index].uniformCount++;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Uniform(Shader::UniformId id, int value)
+{
+    UniformValue uniform{ id, UniformType::Int, {} };
+    uniform.integer = value;
+    m_Queue.m_Uniforms.push_back(uniform);
+    m_Queue.m_Draws[m_Index].uniformCount++;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Object(const ObjectUniforms& object)
+{
+    std::vector<unsigned char>& objects = m_Queue.m_Objects;
+    if (m_Queue.m_ObjectStride == 0) {
+        const size_t alignment = UniformBuffer::GetOffsetAlignment();
+        m_Queue.m_ObjectStride = (sizeof(ObjectUniforms) + alignment - 1) / alignment * alignment;
+    }
+    m_Queue.m_Draws[m_Index].object = static_cast<uint32_t>(objects.size() / m_Queue.m_ObjectStride);
+    objects.resize(objects.size() + m_Queue.m_ObjectStride);
+    std::memcpy(objects.data() + objects.size() - m_Queue.m_ObjectStride, &object, sizeof(object));
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Texture(unsigned int unit, unsigned int texture, unsigned int target)
+{
+    Draw& draw = m_Queue.m_Draws[m_Index];
+    draw.textureUnit = unit;
+    draw.textureTarget = target;
+    draw.texture = texture;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Range(const IndexRange& range)
+{
+    m_Queue.m_Draws[m_Index].range = range;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Ranges(const IndexRange* ranges, size_t count)
+{
+    Draw& draw = m_Queue.m_Draws[m_Index];
+    draw.firstRange = static_cast<uint32_t>(m_Queue.m_Ranges.size());
+    draw.rangeCount = static_cast<uint32_t>(count);
+    draw.range = IndexRange{ 0, 0 };  // Nothing when count is 0
+    m_Queue.m_Ranges.insert(m_Queue.m_Ranges.end(), ranges, ranges + count);
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::BaseVertex(int baseVertex)
+{
+    m_Queue.m_Draws[m_Index].baseVertex = baseVertex;
+    return *this;
+}
+
+RenderQueue::Command& RenderQueue::Command::Instances(unsigned int count)
+{
+    m_Queue.m_Draws[m_Index].instanceCount = count;
+    return *this;
+}
+
+void RenderQueue::SetFrame(const FrameUniforms& frame)
+{
+    if (!m_FrameBuffer)
+        m_FrameBuffer = std::make_unique<UniformBuffer>();
+    m_FrameBuffer->SetData(&frame, sizeof(frame));
+    m_FrameBuffer->Bind(UniformBlock::Frame);
+    m_View = frame.view;
+}
+
+RenderQueue::Command RenderQueue::Submit(Pass pass, Shader& shader, const VertexArray& va, const IndexBuffer& ib, const glm::vec3& position)
+{
+    Draw draw;
+    draw.pass = pass;
+    draw.shader = &shader;
+    draw.va = &va;
+    draw.ib = &ib;
+    draw.depth = -(m_View * glm::vec4(position, 1.0f)).z;  // The camera looks down -z
+    draw.firstUniform = static_cast<uint32_t>(m_Uniforms.size());
+    draw.uniformCount = 0;
+    draw.object = kNoObject;
+    draw.firstRange = 0;
+    draw.rangeCount = 0;
+    draw.range = IndexRange{ 0, ib.GetCount() };
+    draw.baseVertex = 0;
+    draw.instanceCount = 0;
+    draw.textureUnit = 0;
+    draw.textureTarget = GL_TEXTURE_2D;
+    draw.texture = 0;
+    m_Draws.push_back(draw);
+    return Command(*this, m_Draws.size() - 1);
+}
+
+uint32_t RenderQueue::DenseId(std::unordered_map<unsigned int, uint32_t>& ids, unsigned int name)
+{
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+    const uint32_t id = std::min(static_cast<uint32_t>(ids.size()), kMaxId);
+    ids.emplace(name, id);
+    return id;
+}
+
+uint64_t RenderQueue::MakeKey(const Draw& draw)
+{
+    const uint64_t program = DenseId(m_ProgramIds, draw.shader->GetRendererID());
+    const uint64_t texture = draw.texture ? std::min(DenseId(m_TextureIds, draw.texture) + 1, kMaxId) : 0;  // 0 for none
+    const uint64_t vertexArray = DenseId(m_VertexArrayIds, draw.va->GetRendererID());
+    const uint64_t depth = QuantizeDepth(draw.depth);
+    const uint64_t state = (program << (2 * kIdBits)) | (texture << kIdBits) | vertexArray;
+
+    uint64_t key = static_cast<uint64_t>(draw.pass) << 62;
+    if (draw.pass == Pass::Transparent)
+        key |= ((((1ull << kDepthBits) - 1) - depth) << 38) | (state << 2);
+    else
+        key |= (state << 26) | (depth << 2);
+    return key;
+}
+
+void RenderQueue::RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    // Least significant byte first; each pass is stable, so equal keys keep submission order. Bytes
+    // every key shares, usually most of the id bytes, are skipped.
+    scratch.resize(entries.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const SortEntry& entry : entries)
+            counts[(entry.key >> shift) & 0xFF]++;
+        if (counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+            continue;
+
+        size_t offset = 0;
+        for (size_t& count : counts) {
+            const size_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const SortEntry& entry : entries)
+            scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        entries.swap(scratch);
+    }
+}
+
+void RenderQueue::Execute(const Draw& draw)
+{
+    if (draw.texture)
+        GLState::BindTexture(draw.textureUnit, draw.textureTarget, draw.texture);
+
+    if (draw.object != kNoObject)
+        m_ObjectBuffer->BindRange(UniformBlock::Object, draw.object * m_ObjectStride, sizeof(ObjectUniforms));
+
+    Shader& shader = *draw.shader;
+    shader.Bind();
+    for (uint32_t i = draw.firstUniform; i < draw.firstUniform + draw.uniformCount; i++) {
+        const UniformValue& uniform = m_Uniforms[i];
+        const float* v = uniform.floats;
+        switch (uniform.type) {
+            case UniformType::Mat4: {
+                glm::mat4 matrix;
+                std::memcpy(&matrix[0][0], v, sizeof(float) * 16);
+                shader.SetUniformMat4f(uniform.id, matrix);
+                break;
+            }
+            case UniformType::Vec3:  shader.SetUniform3f(uniform.id, v[0], v[1], v[2]); break;
+            case UniformType::Vec4:  shader.SetUniform4f(uniform.id, v[0], v[1], v[2], v[3]); break;
+            case UniformType::Float: shader.SetUniform1f(uniform.id, v[0]); break;
+            case UniformType::Int:   shader.SetUniform1i(uniform.id, uniform.integer); break;
+        }
+    }
+
+    Renderer renderer;
+    if (draw.rangeCount > 0)
+        renderer.DrawRanges(*draw.va, *draw.ib, shader, m_Ranges.data() + draw.firstRange, draw.rangeCount);
+    else if (draw.instanceCount > 0)
+        renderer.DrawInstanced(*draw.va, *draw.ib, shader, draw.instanceCount, draw.range);
+    else if (draw.baseVertex != 0)
+        renderer.Draw(*draw.va, *draw.ib, shader, draw.baseVertex);
+    else
+        renderer.Draw(*draw.va, *draw.ib, shader, draw.range);
+}
+
+void RenderQueue::Flush()
+{
+    PROFILE_SCOPE("RenderQueue::Flush");
+    m_Stats = Stats();
+    m_Stats.draws = m_Draws.size();
+    if (m_Draws.empty())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    m_Sorted.resize(m_Draws.size());
+    for (size_t i = 0; i < m_Draws.size(); i++)
+        m_Sorted[i] = { MakeKey(m_Draws[i]), static_cast<uint32_t>(i) };
+    RadixSort(m_Sorted, m_Scratch);
+    m_Stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Every ObjectData record in one upload, the draws bind their range
+    if (!m_Objects.empty()) {
+        if (!m_ObjectBuffer)
+            m_ObjectBuffer = std::make_unique<UniformBuffer>();
+        m_ObjectBuffer->SetData(m_Objects.data(), m_Objects.size());
+    }
+
+    const Draw* previous = nullptr;
+    bool depthWritesOff = false;
+    for (const SortEntry& entry : m_Sorted) {
+        const Draw& draw = m_Draws[entry.draw];
+        if (draw.pass == Pass::Transparent && !depthWritesOff) {
+            GLCallV(glDepthMask(GL_FALSE));
+            depthWritesOff = true;
+        }
+        if (!previous || previous->shader != draw.shader)
+            m_Stats.programChanges++;
+        if (draw.texture && (!previous || previous->texture != draw.texture || previous->textureUnit != draw.textureUnit))
+            m_Stats.textureChanges++;
+        if (!previous || previous->va != draw.va)
+            m_Stats.vertexArrayChanges++;
+        Execute(draw);
+        previous = &draw;
+    }
+    if (depthWritesOff) {
+        GLCallV(glDepthMask(GL_TRUE));
+    }
+
+    m_Draws.clear();
+    m_Uniforms.clear();
+    m_Ranges.clear();
+    m_Objects.clear();
+    m_ProgramIds.clear();
+    m_TextureIds.clear();
+    m_VertexArrayIds.clear();
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "Renderer.h"
+#include "UniformBuffer.h"
+
+// Deferred draws. Submit() records a draw with the state it needs, Flush() sorts everything recorded
+// since the last flush by a 64 bit key and executes it through Renderer, so the order state changes
+// happen in no longer depends on the order a scene submits in.
+//
+// Key, most significant bits first:
+//   opaque:      pass (2) | program (12) | texture (12) | vertex array (12) | depth, near first (24) | 0 (2)
+//   transparent: pass (2) | depth, far first (24) | program (12) | texture (12) | vertex array (12) | 0 (2)
+// Program, texture and vertex array are dense ids handed out in submission order every frame, so a
+// scene with at most 4096 of each sorts exactly. Draws with equal keys keep their submission order.
+//
+// Per draw data for shaders with the ObjectData block goes into one uniform buffer that Flush()
+// uploads once and binds a range of per draw; the frame's FrameData is uploaded by SetFrame().
+class RenderQueue {
+public:
+    enum class Pass : uint8_t {
+        Opaque,         // Grouped by state, front to back inside a group for early depth rejection
+        Transparent,    // Back to front after all opaque draws, without depth writes
+    };
+
+    struct Stats {
+        size_t draws = 0;
+        size_t programChanges = 0;
+        size_t textureChanges = 0;
+        size_t vertexArrayChanges = 0;
+        double sortMs = 0.0;
+    };
+
+    // Adds per draw state to the draw Submit() just recorded. Only valid until the next Submit().
+    class Command {
+    public:
+        // Set on the shader right before the draw
+        Command& Uniform(Shader::UniformId id, const glm::mat4& value);
+        Command& Uniform(Shader::UniformId id, const glm::vec3& value);
+        Command& Uniform(Shader::UniformId id, const glm::vec4& value);
+        Command& Uniform(Shader::UniformId id, float value);
+        Command& Uniform(Shader::UniformId id, int value);
+        template<typename T>
+        Command& Uniform(const char* name, const T& value) { return Uniform(Shader::GetUniformId(name), value); }
+        // The draw's ObjectData record, copied
+        Command& Object(const ObjectUniforms& object);
+        // The draw's material, part of the key
+        Command& Texture(unsigned int unit, unsigned int texture, unsigned int target = GL_TEXTURE_2D);
+
+        Command& Range(const IndexRange& range);                    // Instead of the whole index buffer
+        Command& Ranges(const IndexRange* ranges, size_t count);    // One multi-draw, the ranges are copied
+        Command& BaseVertex(int baseVertex);                        // Draws the whole index buffer
+        Command& Instances(unsigned int count);                     // Draws the range count times
+
+    private:
+        friend class RenderQueue;
+        Command(RenderQueue& queue, size_t index) : m_Queue(queue), m_Index(index) {}
+
+        RenderQueue& m_Queue;
+        size_t m_Index;
+    };
+
+    // World to view transform of the frame, turns submitted positions into depths
+    void SetView(const glm::mat4& view) { m_View = view; }
+    // Uploads and binds FrameData right away, so draws outside the queue see it too, and sets the view
+    void SetFrame(const FrameUniforms& frame);
+
+    // position is a world space point of the draw, e.g. its bounds center. The shader, vertex array
+    // and index buffer must stay alive until Flush().
+    Command Submit(Pass pass, Shader& shader, const VertexArray& va, const IndexBuffer& ib, const glm::vec3& position);
+
+    // Sorts and executes the recorded draws, then forgets them
+    void Flush();
+
+    bool IsEmpty() const { return m_Draws.empty(); }
+    const Stats& GetStats() const { return m_Stats; }  // Of the last Flush()
+
+private:
+    enum class UniformType : uint8_t { Mat4, Vec3, Vec4, Float, Int };
+
+    static constexpr uint32_t kNoObject = 0xFFFFFFFFu;
+
+    struct UniformValue {
+        Shader::UniformId id;
+        UniformType type;
+        union {
+            float floats[16];
+            int integer;
+        };
+    };
+
+    struct Draw {
+        Pass pass;
+        Shader* shader;
+        const VertexArray* va;
+        const IndexBuffer* ib;
+        float depth;
+        uint32_t firstUniform, uniformCount;
+        uint32_t object;                    // Record in m_Objects or kNoObject
+        uint32_t firstRange, rangeCount;    // Into m_Ranges when the draw is a multi-draw
+        IndexRange range;
+        int baseVertex;
+        unsigned int instanceCount;
+        unsigned int textureUnit, textureTarget, texture;
+    };
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t draw;
+    };
+
+    uint64_t MakeKey(const Draw& draw);
+    void Execute(const Draw& draw);
+    static uint32_t DenseId(std::unordered_map<unsigned int, uint32_t>& ids, unsigned int name);
+    static void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+    glm::mat4 m_View = glm::mat4(1.0f);
+    std::vector<Draw> m_Draws;
+    std::vector<UniformValue> m_Uniforms;
+    std::vector<IndexRange> m_Ranges;
+    std::vector<unsigned char> m_Objects;   // ObjectData records, m_ObjectStride apart
+    size_t m_ObjectStride = 0;
+    std::unique_ptr<UniformBuffer> m_ObjectBuffer, m_FrameBuffer;     // Created on first use
+    std::vector<SortEntry> m_Sorted;
+    std::vector<SortEntry> m_Scratch;
+    std::unordered_map<unsigned int, uint32_t> m_ProgramIds, m_TextureIds, m_VertexArrayIds;
+    Stats m_Stats;
+};
@@ -2,6 +2,10 @@
 
 #include "Renderer.h"
 #include "Hex.h"
+#include "Profiler.h"
+#include "GLState.h"
+
+static RendererStats s_RendererStats;
 
 void GLClearError()
 {
@@ -19,6 +23,21 @@ bool GLCheckError(const char* function, const char* file, int line)
     return true;
 }
 
+// Strips end at the largest value of their index type, triangle lists never contain it
+static void BindIndices(const IndexBuffer& ib)
+{
+    ib.Bind();
+    const bool strips = ib.GetPrimitive() == GL_TRIANGLE_STRIP;
+    GLState::SetCapability(GL_PRIMITIVE_RESTART, strips);
+    if (strips)
+        GLState::SetPrimitiveRestartIndex(ib.GetRestartIndex());
+}
+
+static const void* IndexOffset(const IndexBuffer& ib, unsigned int first)
+{
+    return reinterpret_cast<const void*>(static_cast<uintptr_t>(first) * ib.GetIndexSize());
+}
+
 void Renderer::Clear() const
 {
     GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
@@ -26,9 +45,101 @@ void Renderer::Clear() const
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
+    PROFILE_SCOPE("Renderer::Draw");
+
+    shader.Bind();
+
+    va.Bind();
+    BindIndices(ib); // Not strictly neccesary to bind this, the va already has a binding to the ib
+    GLCallV(glDrawElements(ib.GetPrimitive(), ib.GetCount(), ib.GetType(), nullptr));
+    s_RendererStats.drawCalls++;
+    s_RendererStats.instances++;
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int baseVertex) const
+{
+    PROFILE_SCOPE("Renderer::Draw");
+
     shader.Bind();
 
     va.Bind();
-    ib.Bind(); // Not strictly neccesary to bind this, the va already has a binding to the ib
-    GLCallV(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+    BindIndices(ib);
+    GLCallV(glDrawElementsBaseVertex(ib.GetPrimitive(), ib.GetCount(), ib.GetType(), nullptr, baseVertex));
+    s_RendererStats.drawCalls++;
+    s_RendererStats.instances++;
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range) const
+{
+    PROFILE_SCOPE("Renderer::Draw");
+
+    shader.Bind();
+
+    va.Bind();
+    BindIndices(ib);
+    GLCallV(glDrawElements(ib.GetPrimitive(), range.count, ib.GetType(), IndexOffset(ib, range.first)));
+    s_RendererStats.drawCalls++;
+    s_RendererStats.instances++;
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const
+{
+    PROFILE_SCOPE("Renderer::DrawInstanced");
+
+    shader.Bind();
+
+    va.Bind();
+    BindIndices(ib);
+    GLCallV(glDrawElementsInstanced(ib.GetPrimitive(), ib.GetCount(), ib.GetType(), nullptr, instanceCount));
+    s_RendererStats.drawCalls++;
+    s_RendererStats.instances += instanceCount;
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount, const IndexRange& range) const
+{
+    PROFILE_SCOPE("Renderer::DrawInstanced");
+
+    shader.Bind();
+
+    va.Bind();
+    BindIndices(ib);
+    GLCallV(glDrawElementsInstanced(ib.GetPrimitive(), range.count, ib.GetType(), IndexOffset(ib, range.first), instanceCount));
+    s_RendererStats.drawCalls++;
+    s_RendererStats.instances += instanceCount;
+}
+
+void Renderer::DrawRanges(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange* ranges, size_t rangeCount) const
+{
+    PROFILE_SCOPE("Renderer::DrawRanges");
+    if (rangeCount == 0)
+        return;
+
+    // Reused between calls, a frame of meshlet culling draws through here once per mesh
+    static std::vector<GLsizei> counts;
+    static std::vector<const void*> offsets;
+    counts.clear();
+    offsets.clear();
+    for (size_t i = 0; i < rangeCount; i++) {
+        const IndexRange& range = ranges[i];
+        counts.push_back(static_cast<GLsizei>(range.count));
+        offsets.push_back(IndexOffset(ib, range.first));
+    }
+
+    shader.Bind();
+
+    va.Bind();
+    BindIndices(ib);
+    GLCallV(glMultiDrawElements(ib.GetPrimitive(), counts.data(), ib.GetType(), offsets.data(), static_cast<GLsizei>(rangeCount)));
+    s_RendererStats.drawCalls++;
+    s_RendererStats.instances++;
+}
+
+const RendererStats& Renderer::GetStats()
+{
+    return s_RendererStats;
+}
+
+void Renderer::ResetStats()
+{
+    s_RendererStats = RendererStats();
 }
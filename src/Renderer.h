@@ -5,15 +5,36 @@
 
 #include <iostream>
 #include <stdlib.h>
+#include <cstdint>
+#include <vector>
 
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
 #include "Framebuffer.h"
+#include "GLDebug.h"
 
 #ifdef _DEBUG
 #define ASSERT(x) if(!(x)) __debugbreak();
+#else
+#define ASSERT(x) if(!(x)) {exit(1);} //glfwSetWindowShouldClose(window, true);}
+#endif
+
+// How GLCall/GLCallV check for errors, chosen with the OPENGLTEST_GL_ERRORS CMake option:
+//   GL_ERRORS_POLL      glGetError before and after every call, stops at the failing call.
+//                       A driver round trip per call, the default for _DEBUG builds.
+//   GL_ERRORS_CALLBACK  Every call only records its call site, errors come in through the debug
+//                       callback and are reported against it (see GLDebug). Cheap enough for perf builds.
+//   GL_ERRORS_OFF       No checking, the default otherwise.
+#if !defined(GL_ERRORS_POLL) && !defined(GL_ERRORS_CALLBACK) && !defined(GL_ERRORS_OFF)
+#ifdef _DEBUG
+#define GL_ERRORS_POLL
+#else
+#define GL_ERRORS_OFF
+#endif
+#endif
 
+#if defined(GL_ERRORS_POLL)
 #define GLCallV( x ) \
      GLClearError(); \
      x; \
@@ -26,11 +47,13 @@
      return retVal; \
    }()
 
+#elif defined(GL_ERRORS_CALLBACK)
+#define GLCallV( x ) ( GLDebug::MarkCall( #x, __FILE__, __LINE__ ), x )
+#define GLCall( x ) ( GLDebug::MarkCall( #x, __FILE__, __LINE__ ), x )
+
 #else
 #define GLCallV( x ) x
 #define GLCall( x ) x
-
-#define ASSERT(x) if(!(x)) {exit(1);} //glfwSetWindowShouldClose(window, true);}
 #endif
 
 
@@ -40,12 +63,28 @@ bool GLCheckError(const char* function, const char* file, int line);
 
 
 
+// Totals since the last Renderer::ResetStats(), for scenes that report their draw call count
+struct RendererStats {
+    uint64_t drawCalls = 0;
+    uint64_t instances = 0;
+};
+
 class Renderer
 {
-private:
-
 public:
     void Clear() const;
+    // Every draw takes the primitive and index type from ib and turns on primitive restart for strips
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
-
+    // baseVertex is added to every index, e.g. DynamicVertexBuffer::GetBaseVertex()
+    void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, int baseVertex) const;
+    // Draws range of ib only, e.g. one level of detail
+    void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range) const;
+    // One draw call for instanceCount copies, the va carries the per-instance attributes
+    void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const;
+    void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount, const IndexRange& range) const;
+    // Draws only the given index ranges of ib with one glMultiDrawElements, e.g. the visible meshlets
+    void DrawRanges(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange* ranges, size_t rangeCount) const;
+
+    static const RendererStats& GetStats();
+    static void ResetStats();
 };
\ No newline at end of file
@@ -1,59 +1,150 @@
 #include "Shader.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "UniformBuffer.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Transparent, so string_view lookups don't build a std::string
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+    };
+
+    struct UniformRegistry {
+        std::unordered_map<std::string, Shader::UniformId, NameHash, std::equal_to<>> ids;
+        std::vector<std::string> names;
+    };
+
+    UniformRegistry& Registry() {
+        static UniformRegistry registry;
+        return registry;
+    }
+}
+
+Shader::UniformId Shader::GetUniformId(std::string_view name)
+{
+    UniformRegistry& registry = Registry();
+    auto it = registry.ids.find(name);
+    if (it != registry.ids.end())
+        return it->second;
+
+    const UniformId id = static_cast<UniformId>(registry.names.size());
+    registry.names.emplace_back(name);
+    registry.ids.emplace(registry.names.back(), id);
+    return id;
+}
+
+const std::string& Shader::GetUniformName(UniformId id)
+{
+    return Registry().names[id];
+}
+
+Shader::Shader()
+    :m_Variant(0), m_RendererID(0), m_FromCache(false), m_Status(Status::Compiling), m_VertexID(0), m_FragmentID(0)
+{
+}
 
 Shader::Shader(const std::string& filepath)
-    :m_FilePath(filepath), m_RendererID(0)
+    :Shader(ShaderPreprocessor::Load(filepath))
 {
-    // Getting our shaders from file
-    auto [vertexSource, fragmentSource] = ParseShader(filepath); // using structured bindings (C++ 17)
-    // Creating our shader program
-    m_RendererID = CreateShader(vertexSource, fragmentSource);
+}
+
+Shader::Shader(const ShaderSource& source, ShaderKeywordMask variant)
+    :Shader()
+{
+    CreateShader(source, variant);
+    FinishShader();
 }
 
 Shader::Shader(const std::string& vertexSource, const std::string& fragmentSource)
+    :Shader()
 {
-    m_RendererID = CreateShader(vertexSource, fragmentSource);
+    CreateShader(vertexSource, fragmentSource);
+    FinishShader();
 }
 
-Shader::~Shader()
+std::unique_ptr<Shader> Shader::CreateAsync(const ShaderSource& source, ShaderKeywordMask variant)
 {
-    GLCallV(glDeleteProgram(m_RendererID));
+    IsParallelCompileSupported();  // Raises the driver's thread count before the first compile
+    std::unique_ptr<Shader> shader(new Shader());
+    shader->CreateShader(source, variant);
+    return shader;
 }
 
-std::tuple<std::string, std::string> Shader::ParseShader(const std::string& filePath)
+bool Shader::IsParallelCompileSupported()
 {
-    std::string line;
-    std::stringstream ss[2];
+    static const bool supported = [] {
+        // 0xFFFFFFFF lets the driver pick, some start with a single compiler thread
+        if (GLEW_KHR_parallel_shader_compile) {
+            GLCallV(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+            return true;
+        }
+        if (GLEW_ARB_parallel_shader_compile) {
+            GLCallV(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+            return true;
+        }
+        return false;
+    }();
+    return supported;
+}
 
-    std::ifstream stream(filePath);
+bool Shader::Reload()
+{
+    if (m_FilePath.empty())
+        return false;  // Created from plain sources
+    return Reload(ShaderPreprocessor::Load(m_FilePath));
+}
 
-    enum class ShaderType
-    {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
+bool Shader::Reload(const ShaderSource& source)
+{
+    Shader fresh(source, m_Variant);
+    if (fresh.m_Status != Status::Linked)
+        return false;  // The errors are printed, keep drawing with the program that worked
 
-    ShaderType type = ShaderType::NONE;
+    // fresh deletes the old program on its way out
+    std::swap(m_RendererID, fresh.m_RendererID);
+    std::swap(m_Locations, fresh.m_Locations);
+    std::swap(m_Uniforms, fresh.m_Uniforms);
+    std::swap(m_SourceFiles, fresh.m_SourceFiles);
+    m_FromCache = fresh.m_FromCache;
+    m_Errors.clear();
+    m_Status = Status::Linked;  // A shader that failed to build works from here on
+    return true;
+}
 
-    while (getline(stream, line))
-    {
-        if (line.find("#shader") != std::string::npos)
-        {
-            if (line.find("vertex") != std::string::npos)
-                type = ShaderType::VERTEX;
+Shader::Status Shader::Poll()
+{
+    if (m_Status != Status::Compiling)
+        return m_Status;
 
-            else if (line.find("fragment") != std::string::npos)
-                type = ShaderType::FRAGMENT;
-        }
-        else
-        {
-            if (type != ShaderType::NONE) {
-                ss[(int)type] << line << '\n';
-            }
-        }
+    if (IsParallelCompileSupported()) {
+        int done = 0;
+        GLCallV(glGetProgramiv(m_RendererID, GL_COMPLETION_STATUS_KHR, &done));
+        if (!done)
+            return m_Status;
+    }
+    FinishShader();
+    return m_Status;
+}
 
+Shader::~Shader()
+{
+    if (m_Status == Status::Compiling) {
+        GLCallV(glDeleteShader(m_VertexID));
+        GLCallV(glDeleteShader(m_FragmentID));
     }
+    GLCallV(glDeleteProgram(m_RendererID));
+    GLState::OnProgramDeleted(m_RendererID);
+}
 
-    return { ss[0].str(), ss[1].str() }; // returning a tuple of the two sources
+std::tuple<std::string, std::string> Shader::ParseShader(const std::string& filePath)
+{
+    ShaderSource source = ShaderPreprocessor::Load(filePath);
+    return { std::move(source.vertex), std::move(source.fragment) };
 }
 
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
@@ -62,93 +153,218 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
     const char* src = source.c_str();
     GLCallV(glShaderSource(id, 1, &src, nullptr));
     GLCallV(glCompileShader(id));
+    return id;  // The status is read in FinishShader(), reading it here would wait for the compile
+}
 
+bool Shader::CheckShader(unsigned int id, unsigned int type)
+{
     int result;
     GLCallV(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
         if (result == false)
         {
             int length;
             GLCallV(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length));
-            char* message = (char*)alloca(length * sizeof(char));
-            GLCallV(glGetShaderInfoLog(id, length, &length, message));
-            std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
-            std::cout << message << std::endl;
-
-            GLCallV(glDeleteShader(id));
-            return 0;
+            std::vector<char> message(static_cast<size_t>(std::max(length, 1)));
+            GLCallV(glGetShaderInfoLog(id, static_cast<GLsizei>(message.size()), nullptr, message.data()));
+            m_Errors += std::string("Failed to compile ") + (type == GL_VERTEX_SHADER ? "vertex" : "fragment") + " shader!\n";
+            m_Errors += ShaderPreprocessor::MapErrors(message.data(), m_SourceFiles);
+            return false;
         }
 
-    return id;
+    return true;
+}
+
+void Shader::CreateShader(const ShaderSource& source, ShaderKeywordMask variant)
+{
+    m_FilePath = source.files[0];
+    m_SourceFiles = source.files;
+    m_Variant = variant;
+    CreateShader(ShaderPreprocessor::Specialize(source.vertex, source, variant),
+                 ShaderPreprocessor::Specialize(source.fragment, source, variant));
+}
+
+void Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    m_FromCache = false;
+    if (unsigned int cached = ShaderCache::Load(vertexShader, fragmentShader)) {
+        m_FromCache = true;
+        m_RendererID = cached;
+        m_Status = Status::Linked;
+        Reflect();
+        return;
+    }
+
+    m_RendererID = GLCall(glCreateProgram());
+    m_VertexID = CompileShader(GL_VERTEX_SHADER, vertexShader);
+    m_FragmentID = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+
+    GLCallV(glAttachShader(m_RendererID, m_VertexID));
+    GLCallV(glAttachShader(m_RendererID, m_FragmentID));
+    if (ShaderCache::IsSupported()) {
+        GLCallV(glProgramParameteri(m_RendererID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+    GLCallV(glLinkProgram(m_RendererID));
+
+    m_VertexSource = vertexShader;
+    m_FragmentSource = fragmentShader;
+    m_Status = Status::Compiling;
 }
 
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+void Shader::FinishShader()
 {
-    unsigned int program = GLCall(glCreateProgram());
-    unsigned int vs = GLCall(CompileShader(GL_VERTEX_SHADER, vertexShader));
-    unsigned int fs = GLCall(CompileShader(GL_FRAGMENT_SHADER, fragmentShader));
+    if (m_Status != Status::Compiling)
+        return;
 
-    GLCallV(glAttachShader(program, vs));
-    GLCallV(glAttachShader(program, fs));
-    GLCallV(glLinkProgram(program));
-    GLCallV(glValidateProgram(program));
+    const bool vertexCompiled = CheckShader(m_VertexID, GL_VERTEX_SHADER);
+    const bool fragmentCompiled = CheckShader(m_FragmentID, GL_FRAGMENT_SHADER);
+    const bool compiled = vertexCompiled && fragmentCompiled;
 
-    // We can delete our shaders after compilation
-    GLCallV(glDeleteShader(vs));
-    GLCallV(glDeleteShader(fs));
+    // We can delete our shaders after linking
+    GLCallV(glDeleteShader(m_VertexID));
+    GLCallV(glDeleteShader(m_FragmentID));
+    m_VertexID = m_FragmentID = 0;
 
-    return program;
+    int linked = 0;
+    GLCallV(glGetProgramiv(m_RendererID, GL_LINK_STATUS, &linked));
+    if (linked && compiled) {
+        ShaderCache::Store(m_RendererID, m_VertexSource, m_FragmentSource);  // Not when a stage failed, so the errors show up every time
+    }
+    else if (!linked) {
+        int length = 0;
+        GLCallV(glGetProgramiv(m_RendererID, GL_INFO_LOG_LENGTH, &length));
+        std::vector<char> message(static_cast<size_t>(std::max(length, 1)));
+        GLCallV(glGetProgramInfoLog(m_RendererID, static_cast<GLsizei>(message.size()), nullptr, message.data()));
+        m_Errors += "Failed to link shader" + (m_FilePath.empty() ? "" : " " + m_FilePath) + "!\n";
+        m_Errors += ShaderPreprocessor::MapErrors(message.data(), m_SourceFiles);
+    }
+    m_VertexSource.clear();
+    m_FragmentSource.clear();
+
+    if (!m_Errors.empty())
+        std::cout << m_Errors << std::endl;
+    m_Status = linked && compiled ? Status::Linked : Status::Failed;
+    if (m_Status == Status::Linked) {
+        GLCallV(glValidateProgram(m_RendererID));
+        Reflect();
+    }
+}
+
+void Shader::Reflect()
+{
+    int uniformCount = 0, maxNameLength = 0;
+    GLCallV(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORMS, &uniformCount));
+    GLCallV(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+
+    std::vector<char> name(static_cast<size_t>(std::max(maxNameLength, 1)));
+    for (int i = 0; i < uniformCount; i++) {
+        const unsigned int index = static_cast<unsigned int>(i);
+        int blockIndex = -1;
+        GLCallV(glGetActiveUniformsiv(m_RendererID, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex));
+        if (blockIndex != -1)
+            continue;  // Block members are set through their buffer
+
+        int length = 0, count = 0;
+        GLenum type = 0;
+        GLCallV(glGetActiveUniform(m_RendererID, index, static_cast<GLsizei>(name.size()), &length, &count, &type, name.data()));
+        UniformInfo uniform;
+        uniform.name.assign(name.data(), length);
+        uniform.location = GLCall(glGetUniformLocation(m_RendererID, uniform.name.c_str()));
+        uniform.type = type;
+        uniform.count = count;
+        uniform.id = GetUniformId(uniform.name);
+        m_Uniforms.push_back(uniform);
+    }
+
+    // Arrays are reported as "name[0]", which is also reachable as plain "name"
+    const size_t arrayUniforms = m_Uniforms.size();
+    for (size_t i = 0; i < arrayUniforms; i++) {
+        const std::string& full = m_Uniforms[i].name;
+        if (full.size() > 3 && full.compare(full.size() - 3, 3, "[0]") == 0) {
+            UniformInfo alias = m_Uniforms[i];
+            alias.name = full.substr(0, full.size() - 3);
+            alias.id = GetUniformId(alias.name);
+            m_Uniforms.push_back(alias);
+        }
+    }
+
+    m_Locations.assign(Registry().names.size(), kUnresolved);
+    for (const UniformInfo& uniform : m_Uniforms)
+        m_Locations[uniform.id] = uniform.location;
+
+    int blockCount = 0;
+    GLCallV(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount));
+    for (int i = 0; i < blockCount; i++) {
+        const unsigned int index = static_cast<unsigned int>(i);
+        char blockName[128];
+        GLCallV(glGetActiveUniformBlockName(m_RendererID, index, sizeof(blockName), nullptr, blockName));
+        int size = 0;
+        GLCallV(glGetActiveUniformBlockiv(m_RendererID, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size));
+
+        bool bound = false;
+        for (unsigned int binding = 0; binding < static_cast<unsigned int>(UniformBlock::Count); binding++) {
+            const UniformBlock block = static_cast<UniformBlock>(binding);
+            if (std::strcmp(blockName, UniformBuffer::GetBlockName(block)) != 0)
+                continue;
+            if (static_cast<size_t>(size) != UniformBuffer::GetBlockSize(block))
+                std::cout << "Warning: uniform block '" << blockName << "' is " << size << " bytes, expected "
+                          << UniformBuffer::GetBlockSize(block) << std::endl;
+            GLCallV(glUniformBlockBinding(m_RendererID, index, binding));
+            bound = true;
+        }
+        if (!bound)
+            std::cout << "Warning: uniform block '" << blockName << "' has no binding point!" << std::endl;
+    }
 }
 
 void Shader::Bind() const
 {
-    GLCallV(glUseProgram(m_RendererID));
+    GLState::UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const
 {
-    GLCallV(glUseProgram(0));
+    GLState::UseProgram(0);
 }
 
-void Shader::SetUniform1i(const std::string& name, int value)
+void Shader::SetUniform1i(UniformId id, int value)
 {
-    GLCallV(glUniform1i(GetUniformLocation(name), value));
+    GLCallV(glUniform1i(GetUniformLocation(id), value));
 }
 
-void Shader::SetUniform1f(const std::string& name, float value)
+void Shader::SetUniform1f(UniformId id, float value)
 {
-    GLCallV(glUniform1f(GetUniformLocation(name), value));
+    GLCallV(glUniform1f(GetUniformLocation(id), value));
 }
 
-void Shader::SetUniform2f(const std::string& name, float v0, float v1)
+void Shader::SetUniform2f(UniformId id, float v0, float v1)
 {
-    GLCallV(glUniform2f(GetUniformLocation(name), v0, v1));
+    GLCallV(glUniform2f(GetUniformLocation(id), v0, v1));
 }
 
-void Shader::SetUniform3f(const std::string& name, float v0, float v1, float v2)
+void Shader::SetUniform3f(UniformId id, float v0, float v1, float v2)
 {
-    GLCallV(glUniform3f(GetUniformLocation(name), v0, v1, v2));
+    GLCallV(glUniform3f(GetUniformLocation(id), v0, v1, v2));
 }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float f0, float f1)
+void Shader::SetUniform4f(UniformId id, float v0, float v1, float f0, float f1)
 {
-    GLCallV(glUniform4f(GetUniformLocation(name), v0, v1, f0, f1));
+    GLCallV(glUniform4f(GetUniformLocation(id), v0, v1, f0, f1));
 }
 
-void Shader::SetUniformMat4f(const std::string& name, glm::mat4& matrix)
+void Shader::SetUniformMat4f(UniformId id, const glm::mat4& matrix)
 {
-    GLCallV(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+    GLCallV(glUniformMatrix4fv(GetUniformLocation(id), 1, GL_FALSE, &matrix[0][0]));
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+int Shader::GetMissingUniformLocation(UniformId id)
 {
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-        return m_UniformLocationCache[name];
+    // Ids registered after this shader linked aren't in m_Locations yet
+    if (id >= m_Locations.size())
+        m_Locations.resize(static_cast<size_t>(id) + 1, kUnresolved);
 
-    int location = GLCall(glGetUniformLocation(m_RendererID, name.c_str()));
-    if (location == -1)
-        std::cout << "Warning: uniform '" << name << "' doesn't exist!" << std::endl;
-    
-    m_UniformLocationCache[name] = location;
-    return location;
+    if (m_Locations[id] == kUnresolved) {
+        std::cout << "Warning: uniform '" << GetUniformName(id) << "' doesn't exist!" << std::endl;
+        m_Locations[id] = -1;
+    }
+    return -1;
 }
-
@@ -2,41 +2,132 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sstream>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include "glm/glm.hpp"
+#include "ShaderPreprocessor.h"
 
 
 class Shader
 {
+public:
+	// Process wide number for a uniform name, the same in every shader. Look it up once, e.g. into a
+	// static, and set uniforms through it: that is an array index instead of hashing the name.
+	using UniformId = unsigned int;
+	static UniformId GetUniformId(std::string_view name);
+	static const std::string& GetUniformName(UniformId id);
+
+	// An active uniform outside of uniform blocks, found when the program links
+	struct UniformInfo
+	{
+		std::string name;
+		UniformId id;
+		int location;
+		unsigned int type;	// GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+		int count;			// Array elements, 1 otherwise
+	};
+
+	enum class Status
+	{
+		Compiling,	// Submitted to the driver, see CreateAsync()
+		Linked,
+		Failed		// GetErrors() has the logs
+	};
+
 private:
 	std::string m_FilePath;
+	std::vector<std::string> m_SourceFiles;	// For MapErrors(), empty for plain sources
+	ShaderKeywordMask m_Variant;
 	unsigned int m_RendererID;
-	// Caching system
-	std::unordered_map<std::string, int> m_UniformLocationCache;
+	// Location of every uniform id, filled by Reflect(). Ids registered later resolve to kUnresolved.
+	std::vector<int> m_Locations;
+	std::vector<UniformInfo> m_Uniforms;
+	bool m_FromCache;
+	Status m_Status;
+	std::string m_Errors;
+	// Only while compiling: the stage objects, and the sources for the cache entry
+	unsigned int m_VertexID, m_FragmentID;
+	std::string m_VertexSource, m_FragmentSource;
 public:
+	// Splits a .shader file into its vertex and fragment sources, see ShaderPreprocessor
+	static std::tuple<std::string, std::string> ParseShader(const std::string& filepath);
+
 	Shader(const std::string& filepath);
+	// The variant of a preprocessed file with the keywords in variant defined, see ShaderVariants
+	Shader(const ShaderSource& source, ShaderKeywordMask variant = 0);
 	Shader(const std::string& vertexSource, const std::string& fragmentSource);
 	~Shader();
 
+	// Submits the compile and link and returns without waiting for them. Poll() once per frame until it
+	// stops returning Status::Compiling, the program can't be bound before that. With
+	// KHR_parallel_shader_compile the driver compiles on its own threads, without it the first Poll()
+	// waits for the compile.
+	static std::unique_ptr<Shader> CreateAsync(const ShaderSource& source, ShaderKeywordMask variant = 0);
+	// GL_COMPLETION_STATUS_KHR can be polled, needs a current context
+	static bool IsParallelCompileSupported();
+
+	// Builds the program again from the file (and includes) it was created from and swaps it in once it
+	// links. A failed compile keeps the old program. Uniform values set on the old program are lost.
+	bool Reload();
+	bool Reload(const ShaderSource& source);
+
+	Status Poll();
+	Status GetStatus() const { return m_Status; }
+	const std::string& GetErrors() const { return m_Errors; }
+
 	void Bind() const;
 	void Unbind() const;
 
-	// Set uniforms
-	void SetUniform1i(const std::string& name, int value);
-	void SetUniform1f(const std::string& name, float value);
-	void SetUniform2f(const std::string& name, float v0, float v1);
-	void SetUniform3f(const std::string& name, float v0, float v1, float v2);
-	void SetUniform4f(const std::string& name, float v0, float v1, float f0, float f1);
-	void SetUniformMat4f(const std::string& name, glm::mat4& matrix);
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	const std::vector<UniformInfo>& GetUniforms() const { return m_Uniforms; }
+	bool IsFromCache() const { return m_FromCache; }	// Loaded as a program binary instead of compiled
+	ShaderKeywordMask GetVariant() const { return m_Variant; }
+	const std::string& GetFilePath() const { return m_FilePath; }
+	const std::vector<std::string>& GetSourceFiles() const { return m_SourceFiles; }
+
+	// Set uniforms, on the bound program
+	void SetUniform1i(UniformId id, int value);
+	void SetUniform1f(UniformId id, float value);
+	void SetUniform2f(UniformId id, float v0, float v1);
+	void SetUniform3f(UniformId id, float v0, float v1, float v2);
+	void SetUniform4f(UniformId id, float v0, float v1, float f0, float f1);
+	void SetUniformMat4f(UniformId id, const glm::mat4& matrix);
+
+	// By name, one hash lookup per call
+	void SetUniform1i(const std::string& name, int value) { SetUniform1i(GetUniformId(name), value); }
+	void SetUniform1f(const std::string& name, float value) { SetUniform1f(GetUniformId(name), value); }
+	void SetUniform2f(const std::string& name, float v0, float v1) { SetUniform2f(GetUniformId(name), v0, v1); }
+	void SetUniform3f(const std::string& name, float v0, float v1, float v2) { SetUniform3f(GetUniformId(name), v0, v1, v2); }
+	void SetUniform4f(const std::string& name, float v0, float v1, float f0, float f1) { SetUniform4f(GetUniformId(name), v0, v1, f0, f1); }
+	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix) { SetUniformMat4f(GetUniformId(name), matrix); }
 
 private:
-	std::tuple<std::string, std::string> ParseShader(const std::string& filepath);
+	static constexpr int kUnresolved = -2;	// Not active in the program and not reported yet
+
+	Shader();
+
 	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
-	int GetUniformLocation(const std::string& name);
+	// Appends the info log of a failed stage to m_Errors
+	bool CheckShader(unsigned int id, unsigned int type);
+	// From the program binary cache when it has an entry for the sources, see ShaderCache. Otherwise
+	// only submits the work, FinishShader() collects the result.
+	void CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
+	void CreateShader(const ShaderSource& source, ShaderKeywordMask variant);
+	void FinishShader();
+	// Lists the active uniforms and binds the uniform blocks of UniformBuffer.h to their binding points
+	void Reflect();
+	int GetUniformLocation(UniformId id)
+	{
+		if (id < m_Locations.size() && m_Locations[id] >= 0)
+			return m_Locations[id];
+		return GetMissingUniformLocation(id);
+	}
+	int GetMissingUniformLocation(UniformId id);
 };
 
@@ -0,0 +1,222 @@
+#include "ShaderCache.h"
+#include "Shader.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr char kMagic[4] = { 'O', 'S', 'H', 'D' };
+    constexpr uint32_t kVersion = 1;
+    const char* kCacheDirectory = ".cache/shaders/";
+
+    struct ShaderCacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t driverHash;
+        uint32_t binaryFormat;  // As returned by glGetProgramBinary
+        uint32_t binarySize;
+    };
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull; // FNV-1a
+        }
+        return hash;
+    }
+
+    uint64_t HashString(const char* text, uint64_t hash) {
+        return text ? HashBytes(text, std::strlen(text), hash) : hash;
+    }
+
+}
+
+bool ShaderCache::IsSupported() {
+    static const bool supported = [] {
+        if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+            return false;
+        int formats = 0;
+        GLCallV(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+        return formats > 0;  // Core profiles may support the calls but no format at all
+    }();
+    return supported;
+}
+
+uint64_t ShaderCache::HashSources(const std::string& vertexSource, const std::string& fragmentSource) {
+    // The length keeps "ab" + "c" and "a" + "bc" apart
+    const uint64_t vertexLength = vertexSource.size();
+    uint64_t hash = HashBytes(&vertexLength, sizeof(vertexLength));
+    hash = HashBytes(vertexSource.data(), vertexSource.size(), hash);
+    return HashBytes(fragmentSource.data(), fragmentSource.size(), hash);
+}
+
+uint64_t ShaderCache::HashDriver() {
+    static const uint64_t hash = [] {
+        uint64_t value = HashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), 14695981039346656037ull);
+        value = HashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), value);
+        return HashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), value);
+    }();
+    return hash;
+}
+
+std::string ShaderCache::GetCachePath(const std::string& vertexSource, const std::string& fragmentSource) {
+    const uint64_t sourceHash = HashSources(vertexSource, fragmentSource);
+    const uint64_t driverHash = HashDriver();
+    const uint64_t key = HashBytes(&driverHash, sizeof(driverHash), sourceHash);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.program", static_cast<unsigned long long>(key));
+    return std::string(kCacheDirectory) + name;
+}
+
+unsigned int ShaderCache::Load(const std::string& vertexSource, const std::string& fragmentSource) {
+    if (!IsSupported())
+        return 0;
+
+    const std::string cachePath = GetCachePath(vertexSource, fragmentSource);
+    std::ifstream in(cachePath, std::ios::binary);
+    if (!in)
+        return 0;
+
+    ShaderCacheHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.sourceHash != HashSources(vertexSource, fragmentSource) || header.driverHash != HashDriver())
+        return 0; // Stale or a key collision, it will be overwritten after the compile
+
+    std::vector<char> binary(header.binarySize);
+    in.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!in) {
+        std::cerr << "Corrupt shader cache entry: " << cachePath << std::endl;
+        return 0;
+    }
+
+    unsigned int program = GLCall(glCreateProgram());
+    GLCallV(glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size())));
+    int linked = 0;
+    GLCallV(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (!linked) {
+        // The driver changed without changing its version strings, or dropped support for the format
+        GLCallV(glDeleteProgram(program));
+        Remove(vertexSource, fragmentSource);
+        return 0;
+    }
+    return program;
+}
+
+bool ShaderCache::Store(unsigned int program, const std::string& vertexSource, const std::string& fragmentSource) {
+    if (!IsSupported())
+        return false;
+
+    int length = 0;
+    GLCallV(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+        return false;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLCallV(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    ShaderCacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sourceHash = HashSources(vertexSource, fragmentSource);
+    header.driverHash = HashDriver();
+    header.binaryFormat = format;
+    header.binarySize = static_cast<uint32_t>(length);
+
+    const std::string cachePath = GetCachePath(vertexSource, fragmentSource);
+    const std::string tempPath = cachePath + ".tmp";
+    std::error_code error;
+    fs::create_directories(kCacheDirectory, error);
+
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(binary.data(), length);
+        if (!out) {
+            std::cerr << "Failed to write shader cache: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    // Write then rename, like MeshCache, so a half written entry is never read
+    fs::rename(tempPath, cachePath, error);
+    if (error) {
+        std::cerr << "Failed to update shader cache " << cachePath << ": " << error.message() << std::endl;
+        fs::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+void ShaderCache::Remove(const std::string& vertexSource, const std::string& fragmentSource) {
+    std::error_code error;
+    fs::remove(GetCachePath(vertexSource, fragmentSource), error);
+}
+
+int ShaderCache::RunReport(const std::string& directory, std::ostream& stream) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : fs::recursive_directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".shader")
+            paths.push_back(entry.path().generic_string());
+    }
+    if (error || paths.empty()) {
+        std::cerr << "No .shader files in " << directory << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    if (!IsSupported())
+        stream << "Program binaries are not supported by this driver, warm times are source compiles too" << std::endl;
+    stream << "Shader creation, cold (compile, link and store) and warm (program binary)" << std::endl;
+    stream << std::left << std::setw(48) << "shader" << std::right << std::setw(11) << "cold ms" << std::setw(11) << "warm ms"
+           << std::setw(9) << "speedup" << std::setw(12) << "binary KB" << std::endl;
+
+    // Creating the Shader is what a test pays for, glFinish() keeps lazy drivers from hiding work
+    auto create = [](const std::string& path, bool& fromCache) {
+        auto start = std::chrono::steady_clock::now();
+        Shader shader(path);
+        GLCallV(glFinish());
+        fromCache = shader.IsFromCache();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    double coldTotal = 0.0, warmTotal = 0.0;
+    for (const std::string& path : paths) {
+        auto [vertexSource, fragmentSource] = Shader::ParseShader(path);
+        Remove(vertexSource, fragmentSource);
+
+        bool fromCache = false;
+        const double coldMs = create(path, fromCache);
+        const double warmMs = create(path, fromCache);
+
+        const uintmax_t binaryBytes = fs::file_size(GetCachePath(vertexSource, fragmentSource), error);
+        const double binaryKB = error ? 0.0 : binaryBytes / 1024.0;
+        coldTotal += coldMs;
+        warmTotal += warmMs;
+
+        stream << std::left << std::setw(48) << fs::path(path).lexically_relative(directory).generic_string() << std::right
+               << std::fixed << std::setprecision(2) << std::setw(11) << coldMs << std::setw(11) << warmMs
+               << std::setprecision(1) << std::setw(8) << coldMs / std::max(warmMs, 1e-3) << "x"
+               << std::setw(12) << binaryKB << (fromCache ? "" : "  (not cached)") << std::endl;
+    }
+    stream << std::left << std::setw(48) << "total" << std::right << std::fixed << std::setprecision(2)
+           << std::setw(11) << coldTotal << std::setw(11) << warmTotal
+           << std::setprecision(1) << std::setw(8) << coldTotal / std::max(warmTotal, 1e-3) << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Binary cache of linked programs (glGetProgramBinary), stored under .cache/shaders/. Recompiling GLSL
+// is the slow part of creating a Shader; a hit hands the driver's own binary back with glProgramBinary.
+//
+// Layout: ShaderCacheHeader | program binary
+// Entries are keyed by a hash of the sources and of GL_VENDOR, GL_RENDERER and GL_VERSION, so a driver
+// update or another GPU is a miss. Drivers may also reject a binary they wrote themselves, which is a
+// miss as well: the caller compiles from source and stores a new entry.
+class ShaderCache {
+public:
+    // GL 4.1 or ARB_get_program_binary with at least one binary format. Needs a current context.
+    static bool IsSupported();
+
+    // Creates a linked program from the entry for these sources, or returns 0 on a miss
+    static unsigned int Load(const std::string& vertexSource, const std::string& fragmentSource);
+    // Writes (or replaces) the entry with program's binary. Set GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    // on the program before linking it, some drivers have no binary otherwise.
+    static bool Store(unsigned int program, const std::string& vertexSource, const std::string& fragmentSource);
+    // Removes the entry for these sources, used to force a cold compile
+    static void Remove(const std::string& vertexSource, const std::string& fragmentSource);
+
+    static std::string GetCachePath(const std::string& vertexSource, const std::string& fragmentSource);
+
+    // Creates every .shader file under directory twice, first without a cache entry (compile, link and
+    // store) and then from the entry, and reports both times. Needs a current context. Returns the
+    // process exit code.
+    static int RunReport(const std::string& directory, std::ostream& stream);
+
+private:
+    static uint64_t HashSources(const std::string& vertexSource, const std::string& fragmentSource);
+    static uint64_t HashDriver();
+};
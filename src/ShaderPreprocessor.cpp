@@ -0,0 +1,235 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    constexpr size_t kMaxKeywords = 32;  // Bits of ShaderKeywordMask
+
+    struct Stage {
+        std::string text;
+        std::unordered_set<std::string> included;
+        bool versioned = false;
+        int firstLine = 1;   // Of the .shader file
+    };
+
+    std::string_view TrimLeft(std::string_view line) {
+        const size_t start = line.find_first_not_of(" \t");
+        return start == std::string_view::npos ? std::string_view() : line.substr(start);
+    }
+
+    bool IsDirective(std::string_view line, std::string_view directive) {
+        return line.compare(0, directive.size(), directive) == 0 &&
+               (line.size() == directive.size() || std::isspace(static_cast<unsigned char>(line[directive.size()])));
+    }
+
+    std::string LineDirective(int line, size_t file) {
+        return "#line " + std::to_string(line) + " " + std::to_string(file) + "\n";
+    }
+
+    bool ReadFile(const std::string& path, std::string& text) {
+        std::ifstream stream(path);
+        if (!stream)
+            return false;
+        std::stringstream buffer;
+        buffer << stream.rdbuf();
+        text = buffer.str();
+        return true;
+    }
+
+    void AddKeywords(std::string_view line, ShaderSource& source) {
+        std::istringstream names{ std::string(line.substr(std::strlen("#keyword"))) };
+        std::string name;
+        while (names >> name) {
+            if (std::find(source.keywords.begin(), source.keywords.end(), name) != source.keywords.end())
+                continue;
+            if (source.keywords.size() == kMaxKeywords) {
+                std::cerr << "Too many shader keywords in " << source.files[0] << ", ignoring " << name << std::endl;
+                continue;
+            }
+            source.keywords.push_back(name);
+        }
+    }
+
+    void Include(std::string_view line, const std::string& includingPath, size_t includingFile, int lineNumber,
+                 Stage& stage, ShaderSource& source) {
+        const size_t open = line.find('"');
+        const size_t close = open == std::string_view::npos ? open : line.find('"', open + 1);
+        if (close == std::string_view::npos) {
+            stage.text += "#error malformed #include\n";  // Reported by the compiler, at this line
+            return;
+        }
+        const std::string name(line.substr(open + 1, close - open - 1));
+        const std::string path = (fs::path(includingPath).parent_path() / name).lexically_normal().generic_string();
+        if (stage.included.count(path)) {
+            stage.text += '\n';  // Already pasted into this stage, the blank line keeps the numbering
+            return;
+        }
+
+        std::string text;
+        if (!ReadFile(path, text)) {
+            std::cerr << "Failed to open shader include " << path << " (" << includingPath << ":" << lineNumber << ")" << std::endl;
+            stage.text += "#error cannot open include \"" + name + "\"\n";
+            return;
+        }
+        stage.included.insert(path);
+
+        auto it = std::find(source.files.begin(), source.files.end(), path);
+        const size_t file = static_cast<size_t>(it - source.files.begin());
+        if (it == source.files.end())
+            source.files.push_back(path);
+
+        stage.text += LineDirective(1, file);
+        std::istringstream stream(text);
+        std::string includedLine;
+        int includedNumber = 0;
+        while (getline(stream, includedLine)) {
+            includedNumber++;
+            const std::string_view directive = TrimLeft(includedLine);
+            if (IsDirective(directive, "#include")) {
+                Include(directive, path, file, includedNumber, stage, source);
+            }
+            else if (IsDirective(directive, "#keyword")) {
+                AddKeywords(directive, source);
+                stage.text += '\n';
+            }
+            else {
+                stage.text += includedLine;
+                stage.text += '\n';
+            }
+        }
+        stage.text += LineDirective(lineNumber + 1, includingFile);
+    }
+
+}
+
+ShaderKeywordMask ShaderSource::GetKeywordMask(std::string_view keyword) const
+{
+    auto it = std::find(keywords.begin(), keywords.end(), keyword);
+    return it == keywords.end() ? 0 : ShaderKeywordMask(1) << (it - keywords.begin());
+}
+
+ShaderSource ShaderPreprocessor::Load(const std::string& filepath)
+{
+    std::string text;
+    if (!ReadFile(filepath, text))
+        std::cerr << "Failed to open shader " << filepath << std::endl;
+    return Process(text, filepath);
+}
+
+ShaderSource ShaderPreprocessor::Process(const std::string& text, const std::string& filepath)
+{
+    ShaderSource source;
+    source.files.push_back(filepath);
+
+    enum class ShaderType
+    {
+        NONE = -1, VERTEX = 0, FRAGMENT = 1
+    };
+
+    ShaderType type = ShaderType::NONE;
+    Stage stages[2];
+
+    std::istringstream stream(text);
+    std::string line;
+    int lineNumber = 0;
+    while (getline(stream, line)) {
+        lineNumber++;
+        const std::string_view directive = TrimLeft(line);
+        if (line.find("#shader") != std::string::npos) {
+            if (line.find("vertex") != std::string::npos)
+                type = ShaderType::VERTEX;
+            else if (line.find("fragment") != std::string::npos)
+                type = ShaderType::FRAGMENT;
+            if (type != ShaderType::NONE)
+                stages[(int)type].firstLine = lineNumber + 1;
+            continue;
+        }
+        if (IsDirective(directive, "#keyword")) {
+            AddKeywords(directive, source);
+            if (type != ShaderType::NONE)
+                stages[(int)type].text += '\n';
+            continue;
+        }
+        if (type == ShaderType::NONE)
+            continue;
+
+        Stage& stage = stages[(int)type];
+        if (IsDirective(directive, "#include")) {
+            Include(directive, filepath, 0, lineNumber, stage, source);
+        }
+        else if (!stage.versioned && IsDirective(directive, "#version")) {
+            // Nothing but comments may come before #version, so the numbering starts after it
+            stage.text += line + '\n' + LineDirective(lineNumber + 1, 0);
+            stage.versioned = true;
+        }
+        else {
+            stage.text += line;
+            stage.text += '\n';
+        }
+    }
+
+    for (Stage& stage : stages) {
+        if (!stage.versioned && !stage.text.empty())
+            stage.text = LineDirective(stage.firstLine, 0) + stage.text;
+    }
+    source.vertex = std::move(stages[0].text);
+    source.fragment = std::move(stages[1].text);
+    return source;
+}
+
+std::string ShaderPreprocessor::Specialize(const std::string& stage, const ShaderSource& source, ShaderKeywordMask mask)
+{
+    std::string defines;
+    for (size_t i = 0; i < source.keywords.size(); i++) {
+        if (mask & (ShaderKeywordMask(1) << i))
+            defines += "#define " + source.keywords[i] + " 1\n";
+    }
+    if (defines.empty())
+        return stage;
+
+    // Process() follows #version with a #line directive, which keeps the numbering after the defines
+    size_t insert = 0;
+    const size_t version = stage.find("#version");
+    if (version != std::string::npos) {
+        const size_t end = stage.find('\n', version);
+        insert = end == std::string::npos ? stage.size() : end + 1;
+    }
+    std::string result = stage;
+    result.insert(insert, defines);
+    return result;
+}
+
+std::string ShaderPreprocessor::MapErrors(const std::string& log, const std::vector<std::string>& files)
+{
+    std::string result;
+    std::istringstream stream(log);
+    std::string line;
+    while (getline(stream, line)) {
+        size_t start = 0;
+        for (const char* prefix : { "ERROR: ", "WARNING: " }) {
+            if (line.compare(0, std::strlen(prefix), prefix) == 0)
+                start = std::strlen(prefix);
+        }
+        size_t end = start;
+        while (end < line.size() && end - start < 9 && std::isdigit(static_cast<unsigned char>(line[end])))
+            end++;
+        if (end > start && end < line.size() && (line[end] == ':' || line[end] == '(')) {
+            const size_t file = std::stoul(line.substr(start, end - start));
+            if (file < files.size() && !files[file].empty())
+                line.replace(start, end - start, files[file]);
+        }
+        result += line;
+        result += '\n';
+    }
+    return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bit i selects keywords[i] of a ShaderSource, see ShaderPreprocessor::Specialize()
+using ShaderKeywordMask = uint32_t;
+
+// A .shader file with its includes expanded, split into the vertex and fragment stage
+struct ShaderSource
+{
+    std::string vertex;
+    std::string fragment;
+    // Source string numbers of the #line directives: 0 is the .shader file, then every included file
+    std::vector<std::string> files;
+    // Permutation keywords from the "#keyword NAME ..." lines, at most 32
+    std::vector<std::string> keywords;
+
+    // Bit of a declared keyword, 0 when the file doesn't declare it
+    ShaderKeywordMask GetKeywordMask(std::string_view keyword) const;
+};
+
+// Preprocessing GLSL doesn't do for us. Directives in a .shader file:
+//   #shader vertex|fragment    starts a stage
+//   #include "path"            pastes a file, relative to the including one. Once per stage, like #pragma once.
+//   #keyword NAME ...          declares permutation keywords, a variant gets "#define NAME 1" for each of its bits
+// Stages get #line directives, so compile logs point at lines of the original files. MapErrors() turns
+// the source string numbers back into file names.
+class ShaderPreprocessor {
+public:
+    static ShaderSource Load(const std::string& filepath);
+    // source is the text of a .shader file, filepath locates its includes
+    static ShaderSource Process(const std::string& source, const std::string& filepath);
+
+    // A stage with the defines of every keyword in mask, after its #version line
+    static std::string Specialize(const std::string& stage, const ShaderSource& source, ShaderKeywordMask mask);
+
+    // Replaces the source string numbers at the start of compile log lines ("0:12(3): error" from Mesa,
+    // "0(12) : error" from NVIDIA, "ERROR: 0:12:" from AMD) with the files they stand for
+    static std::string MapErrors(const std::string& log, const std::vector<std::string>& files);
+};
@@ -0,0 +1,34 @@
+#include "ShaderVariants.h"
+
+#include <iostream>
+
+ShaderVariants::ShaderVariants(const std::string& filepath)
+    : m_FilePath(filepath), m_Source(ShaderPreprocessor::Load(filepath)), m_DeclaredMask(0)
+{
+    for (size_t i = 0; i < m_Source.keywords.size(); i++)
+        m_DeclaredMask |= ShaderKeywordMask(1) << i;
+}
+
+Shader& ShaderVariants::Get(ShaderKeywordMask mask)
+{
+    mask &= m_DeclaredMask;
+    std::unique_ptr<Shader>& variant = m_Variants[mask];
+    if (!variant)
+        variant = std::make_unique<Shader>(m_Source, mask);
+    return *variant;
+}
+
+bool ShaderVariants::Reload()
+{
+    ShaderSource source = ShaderPreprocessor::Load(m_FilePath);
+    if (source.keywords != m_Source.keywords) {
+        std::cerr << "The keywords of " << m_FilePath << " changed, recreate its ShaderVariants to use them" << std::endl;
+        return false;
+    }
+
+    bool reloaded = true;
+    for (auto& [mask, variant] : m_Variants)
+        reloaded = variant->Reload(source) && reloaded;
+    m_Source = std::move(source);
+    return reloaded;
+}
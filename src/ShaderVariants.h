@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// The compiled variants of one .shader file, by keyword mask. The file is preprocessed once; a variant
+// is built (or loaded from ShaderCache) the first time Get() sees its mask, so only the combinations a
+// scene draws with are ever compiled. Pick the variant per draw instead of branching on a uniform.
+class ShaderVariants {
+public:
+    explicit ShaderVariants(const std::string& filepath);
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Bit of a keyword the file declares with #keyword, 0 otherwise. Look it up once.
+    ShaderKeywordMask GetKeywordMask(std::string_view keyword) const { return m_Source.GetKeywordMask(keyword); }
+    // Bits of keywords the file doesn't declare are ignored, they select the same variant
+    Shader& Get(ShaderKeywordMask mask);
+
+    // Reloads the file and rebuilds every variant built so far, see Shader::Reload(). Fails without
+    // touching anything when the keywords changed, the masks callers looked up would mean something else.
+    bool Reload();
+
+    const std::string& GetFilePath() const { return m_FilePath; }
+    const ShaderSource& GetSource() const { return m_Source; }
+    size_t GetVariantCount() const { return m_Variants.size(); }
+
+private:
+    std::string m_FilePath;
+    ShaderSource m_Source;
+    ShaderKeywordMask m_DeclaredMask;
+    std::unordered_map<ShaderKeywordMask, std::unique_ptr<Shader>> m_Variants;
+};
@@ -1,7 +1,10 @@
 #include "Texture.h"
 
+#include "GLState.h"
 #include "stb_image.h"
 
+#include <iostream>
+
 Texture::Texture(const std::string& path)
 	:m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr),
 	m_Width(0), m_Height(0), m_BPP(0)
@@ -10,7 +13,7 @@ Texture::Texture(const std::string& path)
 	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
 
 	GLCallV(glGenTextures(1, &m_RendererID));
-	GLCallV(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLState::BindTexture(0, GL_TEXTURE_2D, m_RendererID);
 
 
 	// Need to specify these 4 parameters (or we get a black texture)
@@ -20,7 +23,7 @@ Texture::Texture(const std::string& path)
 	GLCallV(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
 	GLCallV(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-	GLCallV(glBindTexture(GL_TEXTURE_2D, 0));
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
 
 	if (m_LocalBuffer)
 		stbi_image_free(m_LocalBuffer);
@@ -29,15 +32,36 @@ Texture::Texture(const std::string& path)
 Texture::~Texture()
 {
 	GLCallV(glDeleteTextures(1, &m_RendererID));
+	GLState::OnTextureDeleted(m_RendererID);
 }
 
 void Texture::Bind(unsigned int slot) const
 {
-	GLCallV(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCallV(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLState::BindTexture(slot, GL_TEXTURE_2D, m_RendererID);
+}
+
+void Texture::Unbind(unsigned int slot) const
+{
+	GLState::BindTexture(slot, GL_TEXTURE_2D, 0);
 }
 
-void Texture::Unbind() const
+bool Texture::Reload()
 {
-	GLCallV(glBindTexture(GL_TEXTURE_2D, 0));
+	int width = 0, height = 0, bpp = 0;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* pixels = stbi_load(m_FilePath.c_str(), &width, &height, &bpp, 4);
+	if (!pixels) {
+		std::cerr << "Failed to reload texture " << m_FilePath << ": " << stbi_failure_reason() << std::endl;
+		return false;
+	}
+
+	GLState::BindTexture(0, GL_TEXTURE_2D, m_RendererID);
+	GLCallV(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	GLState::BindTexture(0, GL_TEXTURE_2D, 0);
+	stbi_image_free(pixels);
+
+	m_Width = width;
+	m_Height = height;
+	m_BPP = bpp;
+	return true;
 }
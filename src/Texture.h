@@ -16,9 +16,14 @@ public:
 	~Texture();
 	
 	void Bind(unsigned int slot = 0) const;
-	void Unbind() const;
+	void Unbind(unsigned int slot = 0) const;
 
+	// Loads the file again into the same texture object. Keeps the old image when the file can't be read.
+	bool Reload();
+
+	inline const std::string& GetFilePath() const { return m_FilePath; }
 	inline int GetWidth() const { return m_Width; }
 	inline int GetHeight() const { return m_Height; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
 
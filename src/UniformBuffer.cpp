@@ -0,0 +1,61 @@
+#include "UniformBuffer.h"
+
+#include "Renderer.h"
+#include "GLState.h"
+
+UniformBuffer::UniformBuffer()
+    : m_RendererID(0), m_Size(0)
+{
+    GLCallV(glGenBuffers(1, &m_RendererID));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLCallV(glDeleteBuffers(1, &m_RendererID));
+    GLState::OnBufferDeleted(m_RendererID);
+}
+
+void UniformBuffer::SetData(const void* data, size_t size)
+{
+    GLCallV(glBindBuffer(GL_UNIFORM_BUFFER, m_RendererID));
+    GLCallV(glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size), data, GL_STREAM_DRAW));
+    m_Size = size;
+}
+
+void UniformBuffer::Bind(UniformBlock block) const
+{
+    GLState::BindUniformBuffer(static_cast<unsigned int>(block), m_RendererID);
+}
+
+void UniformBuffer::BindRange(UniformBlock block, size_t offset, size_t size) const
+{
+    GLState::BindUniformBuffer(static_cast<unsigned int>(block), m_RendererID, offset, size);
+}
+
+size_t UniformBuffer::GetOffsetAlignment()
+{
+    static const size_t alignment = [] {
+        int value = 0;
+        GLCallV(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value));
+        return value > 0 ? static_cast<size_t>(value) : size_t(256);  // 256 is the largest any driver asks for
+    }();
+    return alignment;
+}
+
+const char* UniformBuffer::GetBlockName(UniformBlock block)
+{
+    switch (block) {
+    case UniformBlock::Frame:  return "FrameData";
+    case UniformBlock::Object: return "ObjectData";
+    default:                   return "";
+    }
+}
+
+size_t UniformBuffer::GetBlockSize(UniformBlock block)
+{
+    switch (block) {
+    case UniformBlock::Frame:  return sizeof(FrameUniforms);
+    case UniformBlock::Object: return sizeof(ObjectUniforms);
+    default:                   return 0;
+    }
+}
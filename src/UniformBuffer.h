@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+// Uniform block binding points. Shader binds every block it finds by name when it links, so shaders
+// only have to declare the block, see GetBlockName().
+enum class UniformBlock : unsigned int {
+    Frame = 0,      // FrameData: set once per frame, RenderQueue::SetFrame()
+    Object = 1,     // ObjectData: one record per draw, RenderQueue::Command::Object()
+    Count
+};
+
+// std140 mirrors of the blocks in res/shader/include/frame_data.glsl and object_data.glsl. std140 pads
+// vec3 members to 16 bytes anyway, so they are vec4 here and the shaders read .xyz.
+struct FrameUniforms {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec4 lightPosition = glm::vec4(0.0f);
+    glm::vec4 lightColor = glm::vec4(1.0f);
+};
+static_assert(sizeof(FrameUniforms) == 160, "FrameUniforms must match the std140 layout of FrameData");
+
+struct ObjectUniforms {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec4 positionScale = glm::vec4(1.0f);     // Position dequantization, see VertexQuantization
+    glm::vec4 positionOffset = glm::vec4(0.0f);
+};
+static_assert(sizeof(ObjectUniforms) == 96, "ObjectUniforms must match the std140 layout of ObjectData");
+
+// A GL buffer for uniform blocks. One buffer can hold many records and bind each through BindRange().
+class UniformBuffer {
+public:
+    UniformBuffer();
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Replaces the contents with new storage (orphaning), so draws still reading the old data don't stall
+    void SetData(const void* data, size_t size);
+
+    void Bind(UniformBlock block) const;                                    // The whole buffer
+    void BindRange(UniformBlock block, size_t offset, size_t size) const;   // offset must be aligned, see GetOffsetAlignment()
+
+    size_t GetSize() const { return m_Size; }
+    unsigned int GetRendererID() const { return m_RendererID; }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried once
+    static size_t GetOffsetAlignment();
+    // Name of the block declaration in GLSL and its size in bytes
+    static const char* GetBlockName(UniformBlock block);
+    static size_t GetBlockSize(UniformBlock block);
+
+private:
+    unsigned int m_RendererID;
+    size_t m_Size;
+};
@@ -1,18 +1,27 @@
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "Renderer.h"
+#include "GLState.h"
+
+#include <cstdint>
 
 VertexArray::VertexArray()
-	: m_RendererID(0) // Initialize to 0
+	: m_RendererID(0), m_AttributeCount(0) // Initialize to 0
 {
 	GLCallV(glGenVertexArrays(1, &m_RendererID));
 }
 VertexArray::~VertexArray()
 {
 	GLCallV(glDeleteVertexArrays(1, &m_RendererID));
+	GLState::OnVertexArrayDeleted(m_RendererID);
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	AddBuffer(vb, layout, m_AttributeCount);
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute)
 {
 	Bind();
 	vb.Bind();
@@ -22,21 +31,24 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 	for (unsigned int i = 0; i < elements.size(); i++)
 	{
 		const auto& element = elements[i];
-		//Enabling the i'th index
-		GLCallV(glEnableVertexAttribArray(i));
+		const unsigned int location = firstAttribute + i;
+		//Enabling the location'th index
+		GLCallV(glEnableVertexAttribArray(location));
 		// Linking the vertex buffer with the currently bound vao
-		GLCallV(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)offset)); 
-		offset += element.count * VertexbufferElement::GetSizeOfType(element.type);
+		GLCallV(glVertexAttribPointer(location, element.count, element.type, element.normalized, layout.GetStride(), (const void*)(uintptr_t)offset));
+		GLCallV(glVertexAttribDivisor(location, element.divisor));
+		offset += element.GetSize();
 	}
-	std::cout << "Stride: " << layout.GetStride() << std::endl;
+	if (firstAttribute + elements.size() > m_AttributeCount)
+		m_AttributeCount = firstAttribute + static_cast<unsigned int>(elements.size());
 }
 
 void VertexArray::Bind() const
 {
-	GLCallV(glBindVertexArray(m_RendererID));
+	GLState::BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-	GLCallV(glBindVertexArray(0));
+	GLState::BindVertexArray(0);
 }
@@ -8,14 +8,20 @@ class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_AttributeCount; // Next free attribute location
 
 public:
 	VertexArray();
 	~VertexArray();
 
+	// Attaches the buffer at the next free attribute locations, so several buffers can be combined
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// Attaches the buffer at fixed locations, e.g. to point existing instance attributes at another buffer
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int firstAttribute);
 
 	void Bind() const;
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
 
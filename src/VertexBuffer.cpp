@@ -2,6 +2,11 @@
 
 #include "Renderer.h"
 
+VertexBuffer::VertexBuffer()
+{
+    GLCallV(glGenBuffers(1, &m_RendererID));
+}
+
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
 {
     GLCallV(glGenBuffers(1, &m_RendererID));
@@ -14,6 +19,18 @@ VertexBuffer::~VertexBuffer()
     GLCallV(glDeleteBuffers(1, &m_RendererID));
 }
 
+void VertexBuffer::SetData(const void* data, unsigned int size)
+{
+    Bind();
+    GLCallV(glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW));
+}
+
+void VertexBuffer::SetSubData(unsigned int offset, const void* data, unsigned int size)
+{
+    Bind();
+    GLCallV(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
+
 void VertexBuffer::Bind() const
 {
     GLCallV(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
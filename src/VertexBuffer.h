@@ -2,11 +2,21 @@
 
 class VertexBuffer
 {
-private:
+protected:
 	unsigned int m_RendererID;
+
+	// For subclasses that allocate the storage themselves
+	VertexBuffer();
 public:
 	VertexBuffer(const void* data, unsigned int size);
-	~VertexBuffer();
+	virtual ~VertexBuffer();
+
+	// Replaces the contents with new storage (orphaning), so data the GPU is still reading isn't waited on
+	void SetData(const void* data, unsigned int size);
+	// Overwrites size bytes at offset in place, the store keeps its size
+	void SetSubData(unsigned int offset, const void* data, unsigned int size);
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 
 	void Bind() const;
 	void UnBind() const;
@@ -1,16 +1,23 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <GL/glew.h>
 
 #include "Renderer.h"
 
+// Storage types of the packed attribute formats, Push<T> picks the GL type from them
+struct HalfFloat { uint16_t bits; };			// IEEE 754 binary16
+struct PackedSnorm10x3 { uint32_t bits; };		// x, y, z as signed normalized 10 bit, 2 bit w on top
+
 struct VertexbufferElement
 {
 	unsigned int type;
 	unsigned int count;
 	unsigned char normalized;
+	unsigned int divisor; // 0 advances per vertex, n advances once every n instances
 
+	// Bytes per value, packed types hold all their components in one value
 	static unsigned int GetSizeOfType(unsigned int type)
 	{
 		switch (type)
@@ -18,10 +25,22 @@ struct VertexbufferElement
 			case GL_FLOAT:			return 4;
 			case GL_UNSIGNED_INT:	return 4;
 			case GL_UNSIGNED_BYTE:	return 1;
+			case GL_SHORT:			return 2;
+			case GL_UNSIGNED_SHORT:	return 2;
+			case GL_HALF_FLOAT:		return 2;
+			case GL_INT_2_10_10_10_REV:	return 4;
 		}
 		ASSERT(false);
 		return 0;
 	}
+
+	// Bytes the element takes in a vertex, count is the components of a packed type, not its values
+	unsigned int GetSize() const
+	{
+		if (type == GL_INT_2_10_10_10_REV)
+			return GetSizeOfType(type);
+		return count * GetSizeOfType(type);
+	}
 };
 
 class VertexBufferLayout
@@ -29,9 +48,15 @@ class VertexBufferLayout
 private:
 	std::vector<VertexbufferElement> m_Elements;
 	unsigned int m_Stride;
+	unsigned int m_InstanceDivisor;
 public:
 	VertexBufferLayout()
-		:m_Stride(0) {}
+		:m_Stride(0), m_InstanceDivisor(0) {}
+
+	// Layout of a per-instance buffer, its attributes advance once every instanceDivisor instances
+	explicit VertexBufferLayout(unsigned int instanceDivisor)
+		:m_Stride(0), m_InstanceDivisor(instanceDivisor) {}
+
 	template<typename T>
 	void Push(unsigned int count)
 	{
@@ -41,25 +66,67 @@ public:
 	template<>
 	void Push<float>(unsigned int count)
 	{
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
+		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE, m_InstanceDivisor });
 		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_FLOAT);
 	}
 
 	template<>
 	void Push<unsigned int>(unsigned int count)
 	{
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
+		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE, m_InstanceDivisor });
 		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_UNSIGNED_INT);
 	}
 
 	template<>
 	void Push<unsigned char>(unsigned int count)
 	{
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
+		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE, m_InstanceDivisor });
 		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
 
 	}
+
+	// Shorts reach the shader as their integer values, e.g. positions quantized to a scale uniform
+	template<>
+	void Push<short>(unsigned int count)
+	{
+		m_Elements.push_back({ GL_SHORT, count, GL_FALSE, m_InstanceDivisor });
+		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_SHORT);
+	}
+
+	// Unsigned shorts are normalized to 0..1
+	template<>
+	void Push<unsigned short>(unsigned int count)
+	{
+		m_Elements.push_back({ GL_UNSIGNED_SHORT, count, GL_TRUE, m_InstanceDivisor });
+		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_UNSIGNED_SHORT);
+	}
+
+	template<>
+	void Push<HalfFloat>(unsigned int count)
+	{
+		m_Elements.push_back({ GL_HALF_FLOAT, count, GL_FALSE, m_InstanceDivisor });
+		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_HALF_FLOAT);
+	}
+
+	// One vec4 per value, normalized to -1..1. GL only accepts this type with four components.
+	template<>
+	void Push<PackedSnorm10x3>(unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			m_Elements.push_back({ GL_INT_2_10_10_10_REV, 4, GL_TRUE, m_InstanceDivisor });
+		m_Stride += count * VertexbufferElement::GetSizeOfType(GL_INT_2_10_10_10_REV);
+	}
+
+	// A mat4 attribute takes four locations, one vec4 column each
+	template<>
+	void Push<glm::mat4>(unsigned int count)
+	{
+		for (unsigned int i = 0; i < count * 4; i++)
+			m_Elements.push_back({ GL_FLOAT, 4, GL_FALSE, m_InstanceDivisor });
+		m_Stride += count * sizeof(glm::mat4);
+	}
 	inline const std::vector<VertexbufferElement> GetElements() const& { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
+	inline unsigned int GetInstanceDivisor() const { return m_InstanceDivisor; }
 };
 
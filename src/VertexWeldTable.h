@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "Vertex.h"
+
+// Flat open-addressing hash table used to weld vertices. It maps a key to an index into the caller's
+// vertex array and never stores the key itself: the caller compares against its own data through the
+// 'matches' callback. Each slot is 8 bytes (32 bit hash + index), probing is linear, and the table
+// grows at 70% load without touching the keys because the hash is kept per slot.
+class VertexWeldTable {
+public:
+    static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+
+    VertexWeldTable()
+        : m_Count(0), m_Mask(0) {}
+
+    // Sizes the table so expectedCount entries fit without growing
+    void Reserve(size_t expectedCount) {
+        size_t capacity = 16;
+        while (capacity * 7 < expectedCount * 10)
+            capacity <<= 1;
+        if (capacity > m_Slots.size())
+            Rehash(capacity);
+    }
+
+    // Returns { index, inserted }. If an entry with this hash satisfies matches(index) its index is
+    // returned, otherwise newIndex is inserted.
+    template<typename Matches>
+    std::pair<uint32_t, bool> FindOrInsert(uint64_t hash, uint32_t newIndex, Matches&& matches) {
+        if ((m_Count + 1) * 10 > m_Slots.size() * 7)
+            Rehash(m_Slots.empty() ? 16 : m_Slots.size() * 2);
+
+        const uint32_t hash32 = static_cast<uint32_t>(hash ^ (hash >> 32));
+        for (size_t slot = hash32 & m_Mask;; slot = (slot + 1) & m_Mask) {
+            Slot& entry = m_Slots[slot];
+            if (entry.index == kEmpty) {
+                entry = { hash32, newIndex };
+                ++m_Count;
+                return { newIndex, true };
+            }
+            if (entry.hash == hash32 && matches(entry.index))
+                return { entry.index, false };
+        }
+    }
+
+    // Empties the table but keeps its capacity, for reuse across batches
+    void Reset() {
+        std::fill(m_Slots.begin(), m_Slots.end(), Slot{ 0, kEmpty });
+        m_Count = 0;
+    }
+
+    void Clear() {
+        m_Slots.clear();
+        m_Slots.shrink_to_fit();
+        m_Count = 0;
+        m_Mask = 0;
+    }
+
+    size_t GetCount() const { return m_Count; }
+    size_t GetMemoryUsage() const { return m_Slots.capacity() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    std::vector<Slot> m_Slots;
+    size_t m_Count;
+    size_t m_Mask;
+
+    void Rehash(size_t capacity) {
+        std::vector<Slot> old(capacity, Slot{ 0, kEmpty });
+        old.swap(m_Slots);
+        m_Mask = capacity - 1;
+        for (const Slot& entry : old) {
+            if (entry.index == kEmpty)
+                continue;
+            size_t slot = entry.hash & m_Mask;
+            while (m_Slots[slot].index != kEmpty)
+                slot = (slot + 1) & m_Mask;
+            m_Slots[slot] = entry;
+        }
+    }
+};
+
+// Maps every vertex to the first vertex with the same position. Face normals split vertices along
+// every edge, so mesh processing that needs connectivity (meshlets, simplification) works on these.
+inline std::vector<uint32_t> WeldPositions(const Vertex* vertices, size_t vertexCount) {
+    std::vector<uint32_t> positionOf(vertexCount);
+    VertexWeldTable table;
+    table.Reserve(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        const glm::vec3& position = vertices[v].Position;
+        uint32_t bits[3];
+        std::memcpy(bits, &position, sizeof(bits));
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t word : bits)
+            hash = (hash ^ word) * 1099511628211ull;
+        positionOf[v] = table.FindOrInsert(hash, static_cast<uint32_t>(v), [&](uint32_t other) {
+            return vertices[other].Position == position;
+        }).first;
+    }
+    return positionOf;
+}
@@ -15,6 +15,21 @@ namespace test {
 		}
 	}
 
+	Test* TestMenu::CreateTest(const std::string& name) const {
+		for (auto& test : m_Tests) {
+			if (test.first == name)
+				return test.second();
+		}
+		return nullptr;
+	}
+
+	std::vector<std::string> TestMenu::GetTestNames() const {
+		std::vector<std::string> names;
+		for (auto& test : m_Tests)
+			names.push_back(test.first);
+		return names;
+	}
+
 	void TestMenu::OnWindowResize(int width, int height) {
 		GLCallV(glViewport(0, 0, width, height)); // Ensure OpenGL viewport is updated
 	}
@@ -42,6 +42,16 @@ namespace test {
 			m_Tests.push_back(std::make_pair(name, []() { return new T(); }));
 		}
 
+		// For tests taking constructor arguments, e.g. one entry per variant of a scene
+		void RegisterTest(const std::string& name, std::function<Test*()> factory){
+			std::cout << "Registering test " << name << std::endl;
+			m_Tests.push_back(std::make_pair(name, std::move(factory)));
+		}
+
+		// Creates a registered test by name without going through the menu, nullptr if there is none
+		Test* CreateTest(const std::string& name) const;
+		std::vector<std::string> GetTestNames() const;
+
 	private:
 		Test*& m_CurrentTest;
 		std::vector<std::pair<std::string, std::function<Test*()>>> m_Tests;
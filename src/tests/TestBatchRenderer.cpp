@@ -0,0 +1,160 @@
+#include "TestBatchRenderer.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "imgui.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace test {
+
+    static constexpr float kSpacing = 2.0f;
+    static const char* const kModelPaths[] = {
+        "res/models/teapot.obj",
+        "res/models/suzanne.obj",
+        "res/models/cube.obj",
+        "res/models/apple.obj",
+        "res/models/cheburashka.obj",
+    };
+
+    TestBatchRenderer::TestBatchRenderer()
+        : m_Proj(1.0f), m_View(1.0f), m_WindowWidth(1280), m_WindowHeight(720),
+        m_GridSize(30), m_Batched(true), m_ForceFallback(false), m_Spinning(true), m_Rotation(0.0f),
+        m_Draws(0), m_DrawCalls(0), m_SubmitMs(0.0)
+    {
+        m_Batch = std::make_unique<BatchRenderer>();
+        m_Shader = std::make_unique<Shader>("res/shader/model_shader.shader");
+        m_BatchShader = std::make_unique<Shader>("res/shader/batch_shader.shader");
+        m_Watches.push_back(AssetWatcher::Watch(*m_Shader));
+        m_Watches.push_back(AssetWatcher::Watch(*m_BatchShader));
+
+        for (const char* path : kModelPaths) {
+            SceneModel sceneModel;
+            sceneModel.model = std::make_unique<Model>(path);
+            sceneModel.batched = m_Batch->AddModel(path);
+            if (sceneModel.batched.empty())
+                continue;
+
+            Bounds bounds;
+            for (BatchRenderer::MeshHandle mesh : sceneModel.batched)
+                bounds = Bounds::Merge(bounds, m_Batch->GetMeshBounds(mesh));
+            const glm::vec3 size = bounds.max - bounds.min;
+            const float scale = 1.5f / std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+            sceneModel.normalize = glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(scale)), -(bounds.min + bounds.max) * 0.5f);
+
+            m_Models.push_back(std::move(sceneModel));
+        }
+
+        GLState::SetCapability(GL_DEPTH_TEST, true);
+        GLCallV(glDepthFunc(GL_LESS));
+
+        UpdateCamera();
+    }
+
+    TestBatchRenderer::~TestBatchRenderer() {
+    }
+
+    glm::mat4 TestBatchRenderer::GetObjectTransform(int x, int z) const {
+        const float half = (m_GridSize - 1) * kSpacing * 0.5f;
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(x * kSpacing - half, 0.0f, z * kSpacing - half));
+        return glm::rotate(transform, m_Rotation + (x * 7 + z * 3) * 0.2f, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    glm::vec3 TestBatchRenderer::GetObjectColor(int x, int z) const {
+        return glm::vec3(0.35f + 0.6f * x / std::max(m_GridSize - 1, 1), 0.5f, 0.35f + 0.6f * z / std::max(m_GridSize - 1, 1));
+    }
+
+    void TestBatchRenderer::UpdateCamera() {
+        const float extent = std::max(m_GridSize * kSpacing, 4.0f);
+        m_View = glm::lookAt(glm::vec3(0.0f, extent * 0.55f, extent * 0.8f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        float aspectRatio = static_cast<float>(m_WindowWidth) / std::max(m_WindowHeight, 1);
+        m_Proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, extent * 3.0f);
+    }
+
+    void TestBatchRenderer::OnUpdate(float deltaTime) {
+        if (m_Spinning)
+            m_Rotation += deltaTime * glm::radians(45.0f);
+    }
+
+    void TestBatchRenderer::OnRender() {
+        PROFILE_SCOPE("TestBatchRenderer::OnRender");
+
+        auto start = std::chrono::steady_clock::now();
+
+        GLCallV(glClearColor(0.1f, 0.1f, 0.12f, 1.0f));
+        GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+        if (m_Models.empty())
+            return;
+
+        // Both shaders read the frame block, the batched path draws outside the queue
+        FrameUniforms frame;
+        frame.view = m_View;
+        frame.projection = m_Proj;
+        frame.lightPosition = glm::vec4(0.0f, m_GridSize * kSpacing, m_GridSize * kSpacing * 0.5f, 1.0f);
+        frame.lightColor = glm::vec4(1.0f);
+        m_Queue.SetFrame(frame);
+        Shader& shader = m_Batched ? *m_BatchShader : *m_Shader;
+        shader.Bind();
+
+        if (m_Batched) {
+            m_Batch->SetPath(m_ForceFallback ? BatchRenderer::Path::DrawBaseVertex : BatchRenderer::Path::MultiDrawIndirect);
+            for (int z = 0; z < m_GridSize; z++) {
+                for (int x = 0; x < m_GridSize; x++) {
+                    const SceneModel& sceneModel = m_Models[(x + z * m_GridSize) % m_Models.size()];
+                    m_Batch->Submit(sceneModel.batched, GetObjectTransform(x, z) * sceneModel.normalize, glm::vec4(GetObjectColor(x, z), 1.0f));
+                }
+            }
+            m_Batch->Flush(shader);
+            m_Draws = m_Batch->GetStats().draws;
+            m_DrawCalls = m_Batch->GetStats().glDrawCalls;
+        }
+        else {
+            const uint64_t drawCallsBefore = Renderer::GetStats().drawCalls;
+            for (int z = 0; z < m_GridSize; z++) {
+                for (int x = 0; x < m_GridSize; x++) {
+                    const SceneModel& sceneModel = m_Models[(x + z * m_GridSize) % m_Models.size()];
+                    sceneModel.model->Draw(m_Queue, shader, GetObjectTransform(x, z) * sceneModel.normalize, GetObjectColor(x, z));
+                }
+            }
+            m_Queue.Flush();
+            m_DrawCalls = Renderer::GetStats().drawCalls - drawCallsBefore;
+            m_Draws = m_DrawCalls;
+        }
+
+        m_SubmitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void TestBatchRenderer::OnImGuiRender() {
+        ImGui::Text("Batch renderer: %zu meshes in %zu arenas", m_Batch->GetMeshCount(), m_Batch->GetArenaCount());
+
+        if (ImGui::SliderInt("Grid size", &m_GridSize, 1, 150))
+            UpdateCamera();
+        ImGui::Checkbox("Batched", &m_Batched);
+        ImGui::SameLine();
+        ImGui::Checkbox("Spin", &m_Spinning);
+
+        if (m_Batch->IsMultiDrawIndirectSupported()) {
+            ImGui::Checkbox("Force GL 3.3 fallback", &m_ForceFallback);
+        }
+        else {
+            ImGui::Text("Multi-draw indirect unavailable, using the GL 3.3 fallback");
+        }
+
+        ImGui::Text("Objects: %d", m_GridSize * m_GridSize);
+        ImGui::Text("Mesh draws: %llu, GL draw calls: %llu", (unsigned long long)m_Draws, (unsigned long long)m_DrawCalls);
+        ImGui::Text("CPU submit: %.3f ms", m_SubmitMs);
+        ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    }
+
+    void TestBatchRenderer::OnWindowResize(int width, int height) {
+        m_WindowWidth = width;
+        m_WindowHeight = height;
+        GLCallV(glViewport(0, 0, width, height));
+        UpdateCamera();
+    }
+
+}
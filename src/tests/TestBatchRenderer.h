@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Test.h"
+#include "Renderer.h"
+#include "Model.h"
+#include "BatchRenderer.h"
+#include "RenderQueue.h"
+#include "AssetWatcher.h"
+
+#include <memory>
+#include <vector>
+
+namespace test {
+
+    // A grid of mixed models, drawn either through the BatchRenderer arenas or with one Model::Draw per
+    // object, reporting the draw calls and CPU time of each
+    class TestBatchRenderer : public Test {
+    private:
+        struct SceneModel {
+            std::unique_ptr<Model> model;               // Per object path
+            std::vector<BatchRenderer::MeshHandle> batched;
+            glm::mat4 normalize;                        // Centers the model and scales it to a unit size
+        };
+
+        std::vector<SceneModel> m_Models;
+        std::unique_ptr<BatchRenderer> m_Batch;
+        RenderQueue m_Queue;    // Individual draws when not batched, the frame block for both
+        std::unique_ptr<Shader> m_Shader;       // model_shader
+        std::unique_ptr<Shader> m_BatchShader;  // batch_shader
+
+        glm::mat4 m_Proj, m_View;
+        int m_WindowWidth, m_WindowHeight;
+
+        int m_GridSize;
+        bool m_Batched;
+        bool m_ForceFallback;
+        bool m_Spinning;
+        float m_Rotation;
+
+        uint64_t m_Draws;
+        uint64_t m_DrawCalls;
+        double m_SubmitMs;
+
+        std::vector<AssetWatcher::Subscription> m_Watches;
+
+        glm::mat4 GetObjectTransform(int x, int z) const;
+        glm::vec3 GetObjectColor(int x, int z) const;
+        void UpdateCamera();
+
+    public:
+        TestBatchRenderer();
+        ~TestBatchRenderer();
+
+        void OnUpdate(float deltaTime) override;
+        void OnRender() override;
+        void OnImGuiRender() override;
+        void OnWindowResize(int width, int height) override;
+    };
+
+}
@@ -1,5 +1,6 @@
 #include "TestClearColor.h"
 #include "Renderer.h"
+#include "Profiler.h"
 
 #include "imgui.h"
 
@@ -17,6 +18,7 @@ void test::TestClearColor::OnWindowResize(int width, int height) {
 }
 
 void test::TestClearColor::OnRender(){
+	PROFILE_SCOPE("TestClearColor::OnRender");
 	GLCallV(glClearColor(m_ClearColor[0], m_ClearColor[1], m_ClearColor[2], m_ClearColor[3]));
 	GLCallV(glClear(GL_COLOR_BUFFER_BIT));
 }
@@ -0,0 +1,127 @@
+#include "TestInstancing.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "imgui.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+
+namespace test {
+
+    static constexpr float kSpacing = 8.0f; // The teapot is about 6.5 units across
+
+    TestInstancing::TestInstancing()
+        : m_Proj(1.0f), m_View(1.0f), m_WindowWidth(1280), m_WindowHeight(720),
+        m_GridSize(100), m_Instanced(true), m_Spinning(false), m_Rotation(0.0f), m_TransformsDirty(true),
+        m_DrawCalls(0), m_SubmitMs(0.0)
+    {
+        m_Model = std::make_unique<Model>("res/models/teapot.obj");
+        m_Shaders = std::make_unique<ShaderVariants>("res/shader/model_shader.shader");
+        m_InstancingKeyword = m_Shaders->GetKeywordMask("INSTANCING");
+        m_Watches.push_back(AssetWatcher::Watch(*m_Model));
+        m_Watches.push_back(AssetWatcher::Watch(*m_Shaders));
+        m_Instances = std::make_unique<InstanceBuffer>();
+
+        GLState::SetCapability(GL_DEPTH_TEST, true);
+        GLCallV(glDepthFunc(GL_LESS));
+
+        UpdateCamera();
+    }
+
+    TestInstancing::~TestInstancing() {
+    }
+
+    void TestInstancing::BuildTransforms() {
+        m_Transforms.resize(static_cast<size_t>(m_GridSize) * m_GridSize);
+
+        const float half = (m_GridSize - 1) * kSpacing * 0.5f;
+        for (int z = 0; z < m_GridSize; z++) {
+            for (int x = 0; x < m_GridSize; x++) {
+                glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(x * kSpacing - half, 0.0f, z * kSpacing - half));
+                // Offset each instance's phase so the grid doesn't turn in lockstep
+                transform = glm::rotate(transform, m_Rotation + (x + z) * 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+                m_Transforms[static_cast<size_t>(z) * m_GridSize + x] = transform;
+            }
+        }
+        m_Instances->SetTransforms(m_Transforms);
+        m_TransformsDirty = false;
+    }
+
+    void TestInstancing::UpdateCamera() {
+        // Looks down at the grid from far enough back to fit all of it
+        const float extent = std::max(m_GridSize * kSpacing, 10.0f);
+        m_View = glm::lookAt(glm::vec3(0.0f, extent * 0.55f, extent * 0.75f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        float aspectRatio = static_cast<float>(m_WindowWidth) / std::max(m_WindowHeight, 1);
+        m_Proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.5f, extent * 3.0f);
+    }
+
+    void TestInstancing::OnUpdate(float deltaTime) {
+        if (m_Spinning) {
+            m_Rotation += deltaTime * glm::radians(45.0f);
+            m_TransformsDirty = true;
+        }
+    }
+
+    void TestInstancing::OnRender() {
+        PROFILE_SCOPE("TestInstancing::OnRender");
+
+        auto start = std::chrono::steady_clock::now();
+        const uint64_t drawCallsBefore = Renderer::GetStats().drawCalls;
+
+        GLCallV(glClearColor(0.1f, 0.1f, 0.12f, 1.0f));
+        GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+        if (m_TransformsDirty)
+            BuildTransforms();
+
+        Shader& shader = m_Shaders->Get(m_Instanced ? m_InstancingKeyword : 0);
+        shader.Bind();
+        shader.SetUniform3f("objectColor", 0.6f, 0.6f, 0.6f);
+
+        FrameUniforms frame;
+        frame.view = m_View;
+        frame.projection = m_Proj;
+        frame.lightPosition = glm::vec4(0.0f, m_GridSize * kSpacing, m_GridSize * kSpacing * 0.5f, 1.0f);
+        frame.lightColor = glm::vec4(1.0f);
+        m_Queue.SetFrame(frame);
+        if (m_Instanced) {
+            m_Model->DrawInstanced(m_Queue, shader, glm::mat4(1.0f), *m_Instances);
+        }
+        else {
+            for (glm::mat4& transform : m_Transforms)
+                m_Model->Draw(m_Queue, shader, transform);
+        }
+        m_Queue.Flush();
+
+        m_DrawCalls = Renderer::GetStats().drawCalls - drawCallsBefore;
+        m_SubmitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void TestInstancing::OnImGuiRender() {
+        ImGui::Text("Instanced rendering stress test");
+
+        if (ImGui::SliderInt("Grid size", &m_GridSize, 1, 200)) {
+            m_TransformsDirty = true;
+            UpdateCamera();
+        }
+        ImGui::Checkbox("Instanced", &m_Instanced);
+        ImGui::SameLine();
+        ImGui::Checkbox("Spin", &m_Spinning);
+
+        ImGui::Text("Instances: %d", m_GridSize * m_GridSize);
+        ImGui::Text("Draw calls: %llu", (unsigned long long)m_DrawCalls);
+        ImGui::Text("CPU submit: %.3f ms", m_SubmitMs);
+        ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    }
+
+    void TestInstancing::OnWindowResize(int width, int height) {
+        m_WindowWidth = width;
+        m_WindowHeight = height;
+        GLCallV(glViewport(0, 0, width, height));
+        UpdateCamera();
+    }
+
+}
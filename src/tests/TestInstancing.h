@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Test.h"
+#include "Renderer.h"
+#include "Model.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "ShaderVariants.h"
+#include "AssetWatcher.h"
+
+#include <memory>
+#include <vector>
+
+namespace test {
+
+    // Stress scene for instanced rendering: a square grid of teapots drawn either with one
+    // Model::DrawInstanced call or with one Model::Draw (and u_Model upload) per instance.
+    class TestInstancing : public Test {
+    private:
+        std::unique_ptr<Model> m_Model;
+        std::unique_ptr<ShaderVariants> m_Shaders; // model_shader, with INSTANCING for the instanced draws
+        ShaderKeywordMask m_InstancingKeyword;
+        std::unique_ptr<InstanceBuffer> m_Instances;
+        RenderQueue m_Queue;
+        std::vector<glm::mat4> m_Transforms;
+
+        glm::mat4 m_Proj, m_View;
+        int m_WindowWidth, m_WindowHeight;
+
+        int m_GridSize;         // m_GridSize x m_GridSize instances
+        bool m_Instanced;
+        bool m_Spinning;        // Rotates every instance, which re-uploads the instance buffer each frame
+        float m_Rotation;
+        bool m_TransformsDirty;
+
+        uint64_t m_DrawCalls;   // Of the last frame
+        double m_SubmitMs;      // CPU time of the last OnRender
+
+        std::vector<AssetWatcher::Subscription> m_Watches;
+
+        void BuildTransforms();
+        void UpdateCamera();
+
+    public:
+        TestInstancing();
+        ~TestInstancing();
+
+        void OnUpdate(float deltaTime) override;
+        void OnRender() override;
+        void OnImGuiRender() override;
+        void OnWindowResize(int width, int height) override;
+    };
+
+}
@@ -0,0 +1,133 @@
+#include "TestMeshletCulling.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "imgui.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+
+namespace test {
+
+    TestMeshletCulling::TestMeshletCulling()
+        : m_Proj(1.0f), m_View(1.0f), m_ModelMatrix(1.0f), m_CameraPosition(0.0f), m_WindowWidth(1280), m_WindowHeight(720),
+        m_CameraYaw(0.0f), m_CameraPitch(glm::radians(15.0f)), m_CameraDistance(3.0f), m_Orbiting(true),
+        m_ClusterCulling(true), m_FreezeCulling(false), m_CullViewProjection(1.0f), m_CullCameraPosition(0.0f),
+        m_TotalTriangles(0), m_DrawCalls(0), m_CullMs(0.0)
+    {
+        m_Model = std::make_unique<Model>("res/models/stanford-bunny.obj");
+        m_Shader = std::make_unique<Shader>("res/shader/model_shader.shader");
+        m_TotalTriangles = m_Model->GetTriangleCount();
+        m_Watches.push_back(AssetWatcher::Subscribe(m_Model->GetPath(), [this] {
+            const bool reloaded = m_Model->Reload();
+            m_TotalTriangles = m_Model->GetTriangleCount();
+            return reloaded;
+        }));
+        m_Watches.push_back(AssetWatcher::Watch(*m_Shader));
+
+        // Centered at the origin with a radius of one, whatever units the file uses
+        const Bounds& bounds = m_Model->GetBounds();
+        if (bounds.valid && bounds.radius > 0.0f) {
+            m_ModelMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / bounds.radius));
+            m_ModelMatrix = glm::translate(m_ModelMatrix, -bounds.center);
+        }
+
+        GLState::SetCapability(GL_DEPTH_TEST, true);
+        GLCallV(glDepthFunc(GL_LESS));
+
+        UpdateCamera();
+    }
+
+    TestMeshletCulling::~TestMeshletCulling() {
+    }
+
+    void TestMeshletCulling::UpdateCamera() {
+        m_CameraPosition = m_CameraDistance * glm::vec3(
+            std::cos(m_CameraPitch) * std::sin(m_CameraYaw),
+            std::sin(m_CameraPitch),
+            std::cos(m_CameraPitch) * std::cos(m_CameraYaw));
+        m_View = glm::lookAt(m_CameraPosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        float aspectRatio = static_cast<float>(m_WindowWidth) / std::max(m_WindowHeight, 1);
+        m_Proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.05f, 100.0f);
+
+        if (!m_FreezeCulling) {
+            m_CullViewProjection = m_Proj * m_View;
+            m_CullCameraPosition = m_CameraPosition;
+        }
+    }
+
+    void TestMeshletCulling::OnUpdate(float deltaTime) {
+        if (m_Orbiting) {
+            m_CameraYaw += deltaTime * glm::radians(20.0f);
+            if (m_CameraYaw > glm::two_pi<float>())
+                m_CameraYaw -= glm::two_pi<float>();
+            UpdateCamera();
+        }
+    }
+
+    void TestMeshletCulling::OnRender() {
+        PROFILE_SCOPE("TestMeshletCulling::OnRender");
+
+        GLCallV(glClearColor(0.1f, 0.1f, 0.12f, 1.0f));
+        GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+        m_Shader->Bind();
+        m_Shader->SetUniform3f("objectColor", 0.6f, 0.6f, 0.6f);
+
+        const uint64_t drawCallsBefore = Renderer::GetStats().drawCalls;
+        auto start = std::chrono::steady_clock::now();
+        FrameUniforms frame;
+        frame.view = m_View;
+        frame.projection = m_Proj;
+        frame.lightPosition = glm::vec4(10.0f, 10.0f, 10.0f, 1.0f);
+        frame.lightColor = glm::vec4(1.0f);
+        m_Queue.SetFrame(frame);
+        if (m_ClusterCulling) {
+            m_Stats = m_Model->DrawClusters(m_Queue, *m_Shader, m_ModelMatrix, Frustum::FromMatrix(m_CullViewProjection),
+                m_CullCameraPosition, m_CullOptions);
+        }
+        else {
+            m_Model->Draw(m_Queue, *m_Shader, m_ModelMatrix);
+            m_Stats = MeshletCuller::Stats();
+            m_Stats.triangles = m_TotalTriangles;
+        }
+        m_CullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_Queue.Flush();
+        m_DrawCalls = Renderer::GetStats().drawCalls - drawCallsBefore;
+    }
+
+    void TestMeshletCulling::OnImGuiRender() {
+        ImGui::Text("Meshlet culling (%u vertices / %u triangles per meshlet)", MeshletBuilder::kMaxVertices, MeshletBuilder::kMaxTriangles);
+
+        bool cameraChanged = false;
+        ImGui::Checkbox("Orbit", &m_Orbiting);
+        cameraChanged |= ImGui::SliderAngle("Yaw", &m_CameraYaw, 0.0f, 360.0f);
+        cameraChanged |= ImGui::SliderAngle("Pitch", &m_CameraPitch, -89.0f, 89.0f);
+        cameraChanged |= ImGui::SliderFloat("Distance", &m_CameraDistance, 0.5f, 10.0f);
+
+        ImGui::Checkbox("Cluster culling", &m_ClusterCulling);
+        ImGui::Checkbox("Frustum", &m_CullOptions.frustum);
+        ImGui::SameLine();
+        ImGui::Checkbox("Back facing", &m_CullOptions.backface);
+        // Thawing picks up the current camera on the next update
+        cameraChanged |= ImGui::Checkbox("Freeze culling camera", &m_FreezeCulling);
+        if (cameraChanged)
+            UpdateCamera();
+
+        ImGui::Text("Meshlets: %zu (%zu outside the frustum, %zu back facing)", m_Stats.meshlets, m_Stats.frustumCulled, m_Stats.backfaceCulled);
+        ImGui::Text("Triangles drawn: %zu / %zu", m_Stats.triangles, m_TotalTriangles);
+        ImGui::Text("Index ranges: %zu, draw calls: %llu", m_Stats.ranges, (unsigned long long)m_DrawCalls);
+        ImGui::Text("Cull and submit: %.3f ms", m_CullMs);
+        ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    }
+
+    void TestMeshletCulling::OnWindowResize(int width, int height) {
+        m_WindowWidth = width;
+        m_WindowHeight = height;
+        GLCallV(glViewport(0, 0, width, height));
+        UpdateCamera();
+    }
+
+}
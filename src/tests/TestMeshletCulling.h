@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Test.h"
+#include "Renderer.h"
+#include "Model.h"
+#include "RenderQueue.h"
+#include "Meshlet.h"
+#include "AssetWatcher.h"
+
+#include <memory>
+#include <vector>
+
+namespace test {
+
+    // Meshlet culling on the Stanford bunny: an orbiting camera whose frustum and view direction
+    // reject clusters on the CPU before the visible index ranges are drawn with one multi-draw.
+    // Freezing the culling camera keeps the last cull result while the view moves on, so the holes
+    // show what was skipped.
+    class TestMeshletCulling : public Test {
+    private:
+        std::unique_ptr<Model> m_Model;
+        std::unique_ptr<Shader> m_Shader;
+        RenderQueue m_Queue;
+
+        glm::mat4 m_Proj, m_View, m_ModelMatrix;
+        glm::vec3 m_CameraPosition;
+        int m_WindowWidth, m_WindowHeight;
+
+        float m_CameraYaw;
+        float m_CameraPitch;
+        float m_CameraDistance;  // In model radii
+        bool m_Orbiting;
+
+        bool m_ClusterCulling;
+        MeshletCuller::Options m_CullOptions;
+        bool m_FreezeCulling;
+        glm::mat4 m_CullViewProjection;
+        glm::vec3 m_CullCameraPosition;
+
+        MeshletCuller::Stats m_Stats;    // Of the last frame
+        size_t m_TotalTriangles;
+        uint64_t m_DrawCalls;
+        double m_CullMs;                 // Culling plus draw submission
+
+        std::vector<AssetWatcher::Subscription> m_Watches;
+
+        void UpdateCamera();
+
+    public:
+        TestMeshletCulling();
+        ~TestMeshletCulling();
+
+        void OnUpdate(float deltaTime) override;
+        void OnRender() override;
+        void OnImGuiRender() override;
+        void OnWindowResize(int width, int height) override;
+    };
+
+}
@@ -1,4 +1,6 @@
 #include "TestModelLoading.h"
+#include "Profiler.h"
+#include "GLState.h"
 #include "imgui.h"
 #include "imgui_internal.h"  // Needed for FindWindowByName
 #include "ImGuiFileDialog.h"
@@ -7,12 +9,17 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include <glm/gtx/string_cast.hpp>
 
+#include <chrono>
+
 namespace test {
 
     TestModelLoading::TestModelLoading()
-        : m_View(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.5f, -6.0f))),
+        : m_FlatShading(false), m_View(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.5f, -6.0f))),
         m_Translation(0.0f, 0.0f, 0.0f), m_modelScale(1.0f), m_modelRotationAngle(0.0),
-        m_ModelLoaded(false), m_Spinning(false)
+        m_ModelLoaded(false), m_Spinning(false),
+        m_InstanceGrid(0), m_Culling(true), m_UseHierarchy(true), m_CullBackend(static_cast<int>(FrustumCuller::GetBestBackend())),
+        m_CameraYaw(0.0f), m_InstancesDirty(true), m_CullMs(0.0), m_MeshesDrawn(0),
+        m_UseLod(true), m_LodErrorPixels(1.0f), m_ForcedLod(-1)
     {
         const char* windowName = "Scene";
         ImGuiWindow* imguiWindow = ImGui::FindWindowByName(windowName);
@@ -28,12 +35,20 @@ namespace test {
             m_ModelLoaded = true;
         }
 
-        m_Shader = std::make_unique<Shader>("res/shader/model_shader.shader");
-        if (m_Shader) {
-            m_Shader->Bind();
-        }
+        m_Shaders = std::make_unique<ShaderVariants>("res/shader/model_shader.shader");
+        m_InstancingKeyword = m_Shaders->GetKeywordMask("INSTANCING");
+        m_FlatShadingKeyword = m_Shaders->GetKeywordMask("FLAT_SHADING");
+        m_Instances = std::make_unique<InstanceBuffer>();
+
+        // The instance grid is spaced by the model's bounds
+        m_Watches.push_back(AssetWatcher::Subscribe(m_Model->GetPath(), [this] {
+            const bool reloaded = m_Model->Reload();
+            m_InstancesDirty = true;
+            return reloaded;
+        }));
+        m_Watches.push_back(AssetWatcher::Watch(*m_Shaders));
 
-        glEnable(GL_DEPTH_TEST); // Enable z-checking
+        GLState::SetCapability(GL_DEPTH_TEST, true); // Enable z-checking
         glDepthFunc(GL_LESS);    // draw closest on top (default)
     }
 
@@ -48,17 +63,21 @@ namespace test {
             if (m_modelRotationAngle > glm::two_pi<float>()) {
                 m_modelRotationAngle -= glm::two_pi<float>(); // Keep within [0, 2pi]
             }
+            m_InstancesDirty = true;
         }
     }
 
     void TestModelLoading::OnRender() {
+        PROFILE_SCOPE("TestModelLoading::OnRender");
+
         GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
         if (m_ModelLoaded) {
 
             glm::mat4 m_modelMatrix = glm::mat4(1.0f);  // Identity matrix
 
-            m_Shader->Bind();
+            Shader& shader = m_Shaders->Get(m_FlatShading ? m_FlatShadingKeyword : 0);
+            shader.Bind();
 
             
             glm::vec3 center = glm::vec3(0.0f, 0.0f, 0.0f); // Change if needed
@@ -67,21 +86,94 @@ namespace test {
             m_modelMatrix = glm::rotate(m_modelMatrix, m_modelRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
             m_modelMatrix = glm::translate(m_modelMatrix, -center);
             m_modelMatrix = glm::scale(m_modelMatrix, glm::vec3(m_modelScale));
-            m_Shader->SetUniformMat4f("u_Model", m_modelMatrix);
-            m_Shader->SetUniformMat4f("u_View", m_View);
-            m_Shader->SetUniformMat4f("u_Projection", m_Proj);
-
-            m_Shader->SetUniform3f("u_Color", 1.0f, 1.0f, 1.0f);
-            m_Shader->SetUniform3f("lightPos", 10.0f, 10.0f, 10.0f);
-            m_Shader->SetUniform3f("lightColor", 1.0f, 1.0f, 1.0f);
-            m_Shader->SetUniform3f("objectColor", 0.6f, 0.6f, 0.6f); // Example color
+            shader.SetUniform3f("u_Color", 1.0f, 1.0f, 1.0f);
+            shader.SetUniform3f("objectColor", 0.6f, 0.6f, 0.6f); // Example color
 
             //std::cout << glm::to_string(m_modelMatrix) << std::endl; DEBUG print modelmatrix
             //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // wireframe on
             //glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); // Wireframe off
 
-            m_Model->Draw(*m_Shader);
+            FrameUniforms frame;
+            frame.view = m_View;
+            frame.projection = m_Proj;
+            frame.lightPosition = glm::vec4(10.0f, 10.0f, 10.0f, 1.0f);
+            frame.lightColor = glm::vec4(1.0f);
+            m_Queue.SetFrame(frame);
+            if (m_InstanceGrid > 0) {
+                if (m_InstancesDirty)
+                    UpdateInstances(m_modelMatrix);
+                DrawInstances();
+            }
+            else if (m_UseLod) {
+                Model::LodSelection lod = Model::LodSelection::FromCamera(m_View, m_Proj, m_WindowHeight, m_LodErrorPixels);
+                lod.forcedLevel = m_ForcedLod;
+                const Frustum frustum = Frustum::FromMatrix(m_Proj * m_View);
+                m_LodStats = m_Model->Draw(m_Queue, shader, m_modelMatrix, lod, m_Culling ? &frustum : nullptr);
+                m_MeshesDrawn = 0;
+                for (size_t meshes : m_LodStats.meshesPerLevel)
+                    m_MeshesDrawn += meshes;
+            }
+            else if (m_Culling) {
+                m_MeshesDrawn = m_Model->Draw(m_Queue, shader, Frustum::FromMatrix(m_Proj * m_View), m_modelMatrix);
+            }
+            else {
+                m_Model->Draw(m_Queue, shader, m_modelMatrix);
+            }
+            m_Queue.Flush();
+        }
+    }
+
+    void TestModelLoading::UpdateInstances(const glm::mat4& modelMatrix) {
+        // A grid in the XZ plane around the model's position, one and a half model sizes apart
+        const Bounds& bounds = m_Model->GetBounds();
+        const glm::vec3 size = bounds.max - bounds.min;
+        const float spacing = 1.5f * std::max(std::max(size.x, size.z), 1e-3f) * m_modelScale;
+        const float half = (m_InstanceGrid - 1) * spacing * 0.5f;
+
+        m_InstanceTransforms.resize(static_cast<size_t>(m_InstanceGrid) * m_InstanceGrid);
+        m_CullingSet.Clear();
+        m_CullingSet.Reserve(m_InstanceTransforms.size());
+        for (int z = 0; z < m_InstanceGrid; z++) {
+            for (int x = 0; x < m_InstanceGrid; x++) {
+                const uint32_t id = static_cast<uint32_t>(z * m_InstanceGrid + x);
+                const glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3(x * spacing - half, 0.0f, z * spacing - half));
+                m_InstanceTransforms[id] = offset * modelMatrix;
+                m_CullingSet.Add(id, bounds.Transformed(m_InstanceTransforms[id]));
+            }
         }
+        m_CullingSet.Build();
+        m_InstancesDirty = false;
+    }
+
+    void TestModelLoading::DrawInstances() {
+        m_Visible.clear();
+        if (m_Culling) {
+            auto start = std::chrono::steady_clock::now();
+            m_CullStats = FrustumCuller::Cull(m_CullingSet, Frustum::FromMatrix(m_Proj * m_View), m_Visible,
+                static_cast<FrustumCuller::Backend>(m_CullBackend), m_UseHierarchy);
+            m_CullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            m_VisibleTransforms.clear();
+            for (uint32_t id : m_Visible)
+                m_VisibleTransforms.push_back(m_InstanceTransforms[id]);
+            m_Instances->SetTransforms(m_VisibleTransforms);
+        }
+        else {
+            m_CullStats = FrustumCuller::Stats();
+            m_CullStats.visible = m_InstanceTransforms.size();
+            m_CullMs = 0.0;
+            m_Instances->SetTransforms(m_InstanceTransforms);
+        }
+
+        Shader& shader = m_Shaders->Get(m_InstancingKeyword | (m_FlatShading ? m_FlatShadingKeyword : 0));
+        shader.Bind();
+        shader.SetUniform3f("objectColor", 0.6f, 0.6f, 0.6f);
+        m_Model->DrawInstanced(m_Queue, shader, glm::mat4(1.0f), *m_Instances);  // The transforms include the model matrix
+    }
+
+    void TestModelLoading::UpdateViewMatrix() {
+        m_View = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.5f, -6.0f));
+        m_View = glm::rotate(m_View, m_CameraYaw, glm::vec3(0.0f, 1.0f, 0.0f));
     }
 
     void TestModelLoading::OnImGuiRender() {
@@ -101,6 +193,7 @@ namespace test {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string filePath = ImGuiFileDialog::Instance()->GetFilePathName();
                 m_Model->LoadModel(filePath);
+                m_InstancesDirty = true;
             }
             ImGuiFileDialog::Instance()->Close();
         }
@@ -111,15 +204,71 @@ namespace test {
 
         ImGui::Text("Spinning: %s", m_Spinning ? "Yes" : "No");
 
-        ImGui::SliderFloat("Scale", &m_modelScale, 0.01f, 10.0f); // Scale from 0.1x to 100x
-        ImGui::SliderFloat3("Translation", &m_Translation.x, -5.0f, 5.0f);
+        m_InstancesDirty |= ImGui::SliderFloat("Scale", &m_modelScale, 0.01f, 10.0f); // Scale from 0.1x to 100x
+        m_InstancesDirty |= ImGui::SliderFloat3("Translation", &m_Translation.x, -5.0f, 5.0f);
         static bool wireframe = false;
         if (ImGui::Checkbox("Wireframe Mode", &wireframe)) {
             glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
         }
+        ImGui::Checkbox("Flat shading", &m_FlatShading);
+        ImGui::SameLine();
+        ImGui::Text("(%zu shader variants compiled)", m_Shaders->GetVariantCount());
 
         ImGui::Text("Rotation: %.2f degrees", glm::degrees(m_modelRotationAngle));
 
+        MeshUploadOptions upload = m_Model->GetUploadOptions();
+        bool packed = upload.vertexFormat == VertexFormat::Packed;
+        bool changed = ImGui::Checkbox("Packed vertices", &packed);
+        changed |= ImGui::Checkbox("Triangle strips", &upload.triangleStrips);
+        if (changed) {
+            upload.vertexFormat = packed ? VertexFormat::Packed : VertexFormat::Float;
+            m_Model->SetUploadOptions(upload);
+            m_InstancesDirty = true;
+        }
+        ImGui::Text("Vertex memory: %.1f KB, index memory: %.1f KB", m_Model->GetVertexBytes() / 1024.0, m_Model->GetIndexBytes() / 1024.0);
+        if (upload.triangleStrips)
+            ImGui::Text("Strips: %zu of %zu meshes (lists when strips are larger)", m_Model->GetStripMeshCount(), m_Model->GetMeshCount());
+
+        ImGui::Separator();
+        if (ImGui::SliderAngle("Camera yaw", &m_CameraYaw, -180.0f, 180.0f))
+            UpdateViewMatrix();
+        m_InstancesDirty |= ImGui::SliderInt("Instance grid", &m_InstanceGrid, 0, 300);
+        ImGui::Checkbox("Frustum culling", &m_Culling);
+        if (m_InstanceGrid > 0) {
+            ImGui::SameLine();
+            ImGui::Checkbox("Hierarchy", &m_UseHierarchy);
+
+            const char* backends[] = { "Scalar", "SSE", "AVX2" };
+            if (ImGui::Combo("Culling backend", &m_CullBackend, backends, 3) &&
+                !FrustumCuller::IsBackendAvailable(static_cast<FrustumCuller::Backend>(m_CullBackend))) {
+                m_CullBackend = static_cast<int>(FrustumCuller::GetBestBackend()); // Not compiled into this build
+            }
+
+            const size_t total = m_InstanceTransforms.size();
+            ImGui::Text("Instances: %zu visible, %zu culled of %zu", m_CullStats.visible, total - m_CullStats.visible, total);
+            ImGui::Text("Cull: %.3f ms (%zu tested, %zu nodes)", m_CullMs, m_CullStats.tested, m_CullStats.nodesVisited);
+        }
+        else if (m_Culling) {
+            ImGui::Text("Meshes: %zu visible, %zu culled", m_MeshesDrawn, m_Model->GetMeshCount() - m_MeshesDrawn);
+        }
+
+        ImGui::Separator();
+        ImGui::Checkbox("Level of detail", &m_UseLod);
+        if (m_UseLod && m_InstanceGrid == 0) {
+            ImGui::SliderFloat("Max error (pixels)", &m_LodErrorPixels, 0.1f, 16.0f);
+            const int levels = static_cast<int>(m_Model->GetLodCount());
+            ImGui::SliderInt("Force level (-1 auto)", &m_ForcedLod, -1, std::max(levels - 1, 0));
+
+            ImGui::Text("Triangles: %zu of %zu", m_LodStats.triangles, m_Model->GetTriangleCount());
+            for (int level = 0; level < levels; level++)
+                ImGui::Text("Level %d: %zu meshes", level, m_LodStats.meshesPerLevel[level]);
+            ImGui::Text("LOD build: %.1f ms%s", m_Model->GetLodBuildMs(), m_Model->GetLodBuildMs() == 0.0 ? " (cached)" : "");
+        }
+
+        const RenderQueue::Stats& queue = m_Queue.GetStats();
+        ImGui::Text("Queue: %zu draws, %zu program, %zu texture, %zu vertex array changes (sort %.3f ms)",
+            queue.draws, queue.programChanges, queue.textureChanges, queue.vertexArrayChanges, queue.sortMs);
+
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
     }
 
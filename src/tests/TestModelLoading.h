@@ -3,15 +3,24 @@
 #include "Test.h"
 #include "Renderer.h"
 #include "Model.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "InstanceBuffer.h"
+#include "ShaderVariants.h"
+#include "AssetWatcher.h"
 
 #include <memory>
+#include <vector>
 
 namespace test {
 
     class TestModelLoading : public Test {
     private:
         std::unique_ptr<Model> m_Model; // Store the loaded model
-        std::unique_ptr<Shader> m_Shader; // Shader for rendering
+        std::unique_ptr<ShaderVariants> m_Shaders; // model_shader, the INSTANCING variant for the instance field
+        ShaderKeywordMask m_InstancingKeyword, m_FlatShadingKeyword;
+        bool m_FlatShading;
+        RenderQueue m_Queue;
         glm::mat4 m_Proj, m_View, m_modelMatrix;
         glm::vec3 m_Translation;
         bool m_ModelLoaded;
@@ -21,6 +30,35 @@ namespace test {
 
         int m_WindowWidth, m_WindowHeight;
 
+        // Instance field: m_InstanceGrid x m_InstanceGrid copies of the model, culled against the frustum
+        // of m_Proj * m_View on the CPU and drawn with one instanced draw per mesh. 0 draws the single model.
+        int m_InstanceGrid;
+        bool m_Culling;
+        bool m_UseHierarchy;
+        int m_CullBackend;
+        float m_CameraYaw;
+        bool m_InstancesDirty;
+        std::unique_ptr<InstanceBuffer> m_Instances;
+        std::vector<glm::mat4> m_InstanceTransforms;
+        std::vector<glm::mat4> m_VisibleTransforms;
+        std::vector<uint32_t> m_Visible;
+        CullingSet m_CullingSet;
+        FrustumCuller::Stats m_CullStats;
+        double m_CullMs;
+        size_t m_MeshesDrawn;   // Single model with culling
+
+        // Level of detail for the single model, picked per mesh from its projected error
+        bool m_UseLod;
+        float m_LodErrorPixels;
+        int m_ForcedLod;        // -1 selects automatically
+        Model::LodStats m_LodStats;
+
+        std::vector<AssetWatcher::Subscription> m_Watches;
+
+        void UpdateViewMatrix();
+        void UpdateInstances(const glm::mat4& modelMatrix);
+        void DrawInstances();
+
     public:
         TestModelLoading();
         ~TestModelLoading();
@@ -0,0 +1,195 @@
+#include "TestOBJLoaderBenchmark.h"
+#include "OBJLoader.h"
+#include "Model.h"
+#include "imgui.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace test {
+
+    static double ToMB(size_t bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+
+    TestOBJLoaderBenchmark::TestOBJLoaderBenchmark()
+        : m_Iterations(5)
+    {
+        RunBenchmark("res/models/");
+    }
+
+    TestOBJLoaderBenchmark::~TestOBJLoaderBenchmark() {
+    }
+
+    void TestOBJLoaderBenchmark::RunBenchmark(const std::string& directory) {
+        m_Results.clear();
+
+        if (!fs::exists(directory) || !fs::is_directory(directory)) {
+            std::cerr << "Error: Directory does not exist: " << directory << std::endl;
+            return;
+        }
+
+        using LoadFunction = std::function<bool(const std::string&, std::vector<Vertex>&, std::vector<unsigned int>&)>;
+
+        // Returns the fastest of m_Iterations loads, so page cache warmup doesn't skew the first loader
+        auto timeLoad = [this](const LoadFunction& load, const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+            double best = std::numeric_limits<double>::max();
+            for (int i = 0; i < m_Iterations; i++) {
+                vertices.clear();
+                indices.clear();
+                auto start = std::chrono::high_resolution_clock::now();
+                load(path, vertices, indices);
+                auto end = std::chrono::high_resolution_clock::now();
+                best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+            }
+            return best;
+        };
+
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (entry.path().extension() != ".obj")
+                continue;
+
+            const std::string path = entry.path().string();
+            std::vector<Vertex> legacyVertices, mappedVertices, parallelVertices, streamedVertices;
+            std::vector<unsigned int> legacyIndices, mappedIndices, parallelIndices, streamedIndices;
+
+            // Same flags as Model
+            OBJLoadOptions serialOptions;
+            serialOptions.computeFaceNormals = true;
+            OBJLoadOptions parallelOptions = serialOptions;
+            parallelOptions.threadCount = 0;
+
+            Result result;
+            result.file = entry.path().filename().string();
+            serialOptions.stats = &result.mappedStats;
+            result.legacyMs = timeLoad([&](const std::string& p, std::vector<Vertex>& v, std::vector<unsigned int>& i) {
+                return OBJLoader::LoadOBJLegacy(p, v, i, true, false, &result.legacyStats);
+            }, path, legacyVertices, legacyIndices);
+            result.mappedMs = timeLoad([&](const std::string& p, std::vector<Vertex>& v, std::vector<unsigned int>& i) {
+                return OBJLoader::LoadOBJ(p, v, i, serialOptions);
+            }, path, mappedVertices, mappedIndices);
+            result.parallelMs = timeLoad([&](const std::string& p, std::vector<Vertex>& v, std::vector<unsigned int>& i) {
+                return OBJLoader::LoadOBJ(p, v, i, parallelOptions);
+            }, path, parallelVertices, parallelIndices);
+
+            // Streaming only keeps one batch at a time, so the sink just checks the triangles add up
+            OBJLoadOptions streamedOptions = serialOptions;
+            streamedOptions.stats = &result.streamedStats;
+            size_t streamedIndexCount = 0;
+            result.streamedMs = timeLoad([&](const std::string& p, std::vector<Vertex>&, std::vector<unsigned int>&) {
+                streamedIndexCount = 0;
+                return OBJLoader::LoadOBJStreaming(p, streamedOptions, [&](const OBJMeshBatch& batch) {
+                    streamedIndexCount += batch.indexCount;
+                    return true;
+                });
+            }, path, streamedVertices, streamedIndices);
+
+            // End to end Model loads, cold (cache entry removed first) and warm (cache hit)
+            result.coldModelMs = result.warmModelMs = std::numeric_limits<double>::max();
+            for (int i = 0; i < m_Iterations; i++) {
+                MeshCache::Remove(path, Model::GetLoadOptions());
+                auto start = std::chrono::high_resolution_clock::now();
+                { Model model(path); }
+                auto middle = std::chrono::high_resolution_clock::now();
+                { Model model(path); }
+                auto end = std::chrono::high_resolution_clock::now();
+                result.coldModelMs = std::min(result.coldModelMs, std::chrono::duration<double, std::milli>(middle - start).count());
+                result.warmModelMs = std::min(result.warmModelMs, std::chrono::duration<double, std::milli>(end - middle).count());
+            }
+
+            result.vertexCount = mappedVertices.size();
+            result.indexCount = mappedIndices.size();
+
+            auto sameOutput = [](const std::vector<Vertex>& va, const std::vector<unsigned int>& ia, const std::vector<Vertex>& vb, const std::vector<unsigned int>& ib) {
+                return ia == ib && va.size() == vb.size() && std::memcmp(va.data(), vb.data(), va.size() * sizeof(Vertex)) == 0;
+            };
+            result.identical = sameOutput(legacyVertices, legacyIndices, mappedVertices, mappedIndices) &&
+                sameOutput(mappedVertices, mappedIndices, parallelVertices, parallelIndices) &&
+                streamedIndexCount == mappedIndices.size();
+
+            std::cout << "[OBJ benchmark] " << result.file << ": legacy " << result.legacyMs << " ms, mapped "
+                << result.mappedMs << " ms (" << result.legacyMs / result.mappedMs << "x), parallel "
+                << result.parallelMs << " ms (" << result.legacyMs / result.parallelMs << "x)"
+                << ", streamed " << result.streamedMs << " ms"
+                << (result.identical ? "" : " OUTPUT MISMATCH") << ", model cold " << result.coldModelMs
+                << " ms, warm " << result.warmModelMs << " ms, weld " << ToMB(result.legacyStats.weldBytes) << " -> "
+                << ToMB(result.mappedStats.weldBytes) << " MB, peak " << ToMB(result.legacyStats.peakBytes) << " -> "
+                << ToMB(result.mappedStats.peakBytes) << " MB (streamed " << ToMB(result.streamedStats.peakBytes) << " MB)" << std::endl;
+
+            m_Results.push_back(result);
+        }
+    }
+
+    void TestOBJLoaderBenchmark::OnImGuiRender() {
+        ImGui::Text("OBJ load time, best of %d runs", m_Iterations);
+        ImGui::SliderInt("Iterations", &m_Iterations, 1, 20);
+        if (ImGui::Button("Run Benchmark")) {
+            RunBenchmark("res/models/");
+        }
+
+        ImGui::Text("Hardware threads: %u", std::thread::hardware_concurrency());
+
+        if (ImGui::BeginTable("OBJResults", 10, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("File");
+            ImGui::TableSetupColumn("Vertices");
+            ImGui::TableSetupColumn("Indices");
+            ImGui::TableSetupColumn("Legacy (ms)");
+            ImGui::TableSetupColumn("Mapped (ms)");
+            ImGui::TableSetupColumn("Parallel (ms)");
+            ImGui::TableSetupColumn("Streamed (ms)");
+            ImGui::TableSetupColumn("Speedup");
+            ImGui::TableSetupColumn("Model cold (ms)");
+            ImGui::TableSetupColumn("Model warm (ms)");
+            ImGui::TableHeadersRow();
+
+            for (const auto& result : m_Results) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", result.file.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%zu", result.vertexCount);
+                ImGui::TableNextColumn(); ImGui::Text("%zu", result.indexCount);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", result.legacyMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", result.mappedMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", result.parallelMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", result.streamedMs);
+                ImGui::TableNextColumn();
+                const double speedup = result.legacyMs / std::min(result.mappedMs, result.parallelMs);
+                if (result.identical)
+                    ImGui::Text("%.1fx", speedup);
+                else
+                    ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%.1fx (mismatch)", speedup);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", result.coldModelMs);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", result.warmModelMs);
+            }
+            ImGui::EndTable();
+        }
+
+        ImGui::Text("Loader memory (MB)");
+        if (ImGui::BeginTable("OBJMemory", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("File");
+            ImGui::TableSetupColumn("Weld legacy");
+            ImGui::TableSetupColumn("Weld mapped");
+            ImGui::TableSetupColumn("Peak legacy");
+            ImGui::TableSetupColumn("Peak mapped");
+            ImGui::TableSetupColumn("Peak streamed");
+            ImGui::TableHeadersRow();
+
+            for (const auto& result : m_Results) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::Text("%s", result.file.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", ToMB(result.legacyStats.weldBytes));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", ToMB(result.mappedStats.weldBytes));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", ToMB(result.legacyStats.peakBytes));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", ToMB(result.mappedStats.peakBytes));
+                ImGui::TableNextColumn(); ImGui::Text("%.2f", ToMB(result.streamedStats.peakBytes));
+            }
+            ImGui::EndTable();
+        }
+    }
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Test.h"
+#include "OBJLoader.h"
+
+#include <string>
+#include <vector>
+
+namespace test {
+
+    class TestOBJLoaderBenchmark : public Test {
+    private:
+        struct Result {
+            std::string file;
+            size_t vertexCount;
+            size_t indexCount;
+            double legacyMs;   // Best of m_Iterations runs of OBJLoader::LoadOBJLegacy
+            double mappedMs;   // Best of m_Iterations runs of OBJLoader::LoadOBJ
+            double parallelMs; // Same, with OBJLoadOptions::threadCount = 0
+            double streamedMs; // Best of m_Iterations runs of OBJLoader::LoadOBJStreaming with default batches
+            double coldModelMs; // Model construction with no mesh cache entry (parse, cache write, upload)
+            double warmModelMs; // Model construction from the mapped mesh cache entry (upload only)
+            bool identical;    // All loaders produced the same vertices and indices
+            OBJLoadStats legacyStats; // Weld table and peak memory of the legacy loader
+            OBJLoadStats mappedStats; // Same for the serial mapped loader
+            OBJLoadStats streamedStats; // Same for the streaming loader
+        };
+
+        std::vector<Result> m_Results;
+        int m_Iterations;
+
+        void RunBenchmark(const std::string& directory);
+
+    public:
+        TestOBJLoaderBenchmark();
+        ~TestOBJLoaderBenchmark();
+
+        void OnImGuiRender() override;
+    };
+
+}
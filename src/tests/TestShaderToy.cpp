@@ -1,5 +1,7 @@
 #include "Renderer.h"
 #include "TestShaderToy.h"
+#include "Profiler.h"
+#include "GLState.h"
 
 #include "imgui.h"
 #include <imgui_internal.h>
@@ -10,6 +12,12 @@
 
 namespace fs = std::filesystem;
 
+// The Shadertoy inputs, resolved once instead of hashing the names every frame
+static const Shader::UniformId kTimeUniform = Shader::GetUniformId("iTime");
+static const Shader::UniformId kFrameUniform = Shader::GetUniformId("iFrame");
+static const Shader::UniformId kResolutionUniform = Shader::GetUniformId("iResolution");
+static const Shader::UniformId kMouseUniform = Shader::GetUniformId("iMouse");
+
 test::TestShaderToy::TestShaderToy()
     :m_Proj(), 
     m_View(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f))),
@@ -21,6 +29,7 @@ test::TestShaderToy::TestShaderToy()
     LoadShaderFiles("res/shader/Shadertoy/");
     if (!m_ShaderFiles.empty()) {
         LoadShader(m_ShaderFiles[0]);
+        WatchSelectedShader();
     }
 
     // These are the vertex data we need to draw a rectangle from two triangles
@@ -38,7 +47,7 @@ test::TestShaderToy::TestShaderToy()
     };
 
 
-    GLCallV(glEnable(GL_BLEND));
+    GLState::SetCapability(GL_BLEND, true);
     GLCallV(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
     // Vertex Array object
@@ -131,33 +140,74 @@ void test::TestShaderToy::LoadShader(const std::string& shaderPath)
     }
 }
 
-void test::TestShaderToy::ReloadShader()
+void test::TestShaderToy::SaveShader()
 {
     std::ofstream file(m_SelectedShader);
     file << m_ShaderSource;
     file.close();
 
-    m_Shader = std::make_unique<Shader>(m_SelectedShader);
+    CompileShader(m_ShaderSource);
+}
+
+void test::TestShaderToy::WatchSelectedShader()
+{
+    m_ShaderWatch = AssetWatcher::Subscribe(m_SelectedShader, [this] {
+        const std::string saved = m_ShaderSource;
+        LoadShader(m_SelectedShader);
+        if (m_ShaderSource == saved)
+            return true;  // Our own SaveShader(), already compiling
+        if (m_Editor.GetText() != m_ShaderSource)
+            m_Editor.SetText(m_ShaderSource);
+        CompileShader(m_ShaderSource);
+        return true;  // Compile errors show up in the editor
+    });
+}
+
+void test::TestShaderToy::CompileShader(const std::string& source)
+{
+    // A compile still in flight is dropped, only the latest edit matters
+    m_PendingShader = Shader::CreateAsync(ShaderPreprocessor::Process(source, m_SelectedShader));
+    m_CompileStart = std::chrono::steady_clock::now();
+}
+
+void test::TestShaderToy::PollShader()
+{
+    if (!m_PendingShader || m_PendingShader->Poll() == Shader::Status::Compiling)
+        return;
+
+    m_CompileMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_CompileStart).count();
+    if (m_PendingShader->GetStatus() == Shader::Status::Linked) {
+        m_Shader = std::move(m_PendingShader);
+        m_CompileErrors.clear();
+    }
+    else {
+        m_CompileErrors = m_PendingShader->GetErrors();  // Keep drawing the last shader that linked
+    }
+    m_PendingShader.reset();
 }
 
 
 void test::TestShaderToy::OnRender()
 {
+    PROFILE_SCOPE("TestShaderToy::OnRender");
+
+    PollShader();
+
 	GLCallV(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
     GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
-    Renderer renderer;
-
     m_Shader->Bind();
-    m_Shader->SetUniform1f("iTime", glfwGetTime());
-    m_Shader->SetUniform1i("iFrame", m_FrameCount);
-    m_Shader->SetUniform2f("iResolution", (float) m_WindowWidth, (float)m_WindowHeight);
+    m_Shader->SetUniform1f(kTimeUniform, glfwGetTime());
+    m_Shader->SetUniform1i(kFrameUniform, m_FrameCount);
+    m_Shader->SetUniform2f(kResolutionUniform, (float) m_WindowWidth, (float)m_WindowHeight);
     if (mouseState.leftPressed && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
-        m_Shader->SetUniform4f("iMouse", m_MouseX, m_MouseY, mouseState.x, mouseState.y);
+        m_Shader->SetUniform4f(kMouseUniform, m_MouseX, m_MouseY, mouseState.x, mouseState.y);
     }
-    else m_Shader->SetUniform4f("iMouse", m_MouseX, m_MouseY, 0.0f, 0.0f);
-    
-    renderer.Draw(*m_VAO, *m_IBO, *m_Shader);
+    else m_Shader->SetUniform4f(kMouseUniform, m_MouseX, m_MouseY, 0.0f, 0.0f);
+
+    // A single full screen quad, the queue only saves the state changes GLState would skip anyway
+    m_Queue.Submit(RenderQueue::Pass::Opaque, *m_Shader, *m_VAO, *m_IBO, glm::vec3(0.0f));
+    m_Queue.Flush();
     m_FrameCount++;
 }
 
@@ -168,11 +218,9 @@ void test::TestShaderToy::OnImGuiRender()
     for (const auto& shader : m_ShaderFiles) {
         if (ImGui::Selectable(shader.c_str(), shader == m_SelectedShader)) {
             LoadShader(shader);
-            m_Shader = std::make_unique<Shader>(m_SelectedShader);
-            if (m_Shader != nullptr) {
-                m_Shader->Bind();
-                m_Editor.SetText(m_ShaderSource);
-            }
+            WatchSelectedShader();
+            m_Editor.SetText(m_ShaderSource);
+            CompileShader(m_ShaderSource);
         }
     }
 
@@ -181,16 +229,36 @@ void test::TestShaderToy::OnImGuiRender()
     ImGui::Begin("Shader Editor");
 
 
-    ImGui::BeginChild("ShaderEditorContent", ImVec2(0, -40), true); // Leave space for button
+    const float footer = m_CompileErrors.empty() ? 40.0f : 160.0f;
+    ImGui::BeginChild("ShaderEditorContent", ImVec2(0, -footer), true); // Leave space for button and errors
     // Display text editor widget
     m_Editor.Render("GLSL Shader Editor");
 
     ImGui::EndChild(); // Ends the scrollable editor content
 
-    // Recompile shader if button pressed
+    // Recompile tries the editor text, Save also writes it to the file
     if (ImGui::Button("Recompile Shader")) {
+        CompileShader(m_Editor.GetText());
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save")) {
         m_ShaderSource = m_Editor.GetText();
-        ReloadShader(); //Save and load shader source from editor
+        SaveShader();
+    }
+
+    ImGui::SameLine();
+    if (m_PendingShader) {
+        const float elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_CompileStart).count();
+        ImGui::Text("Compiling... %.0f ms", elapsed);
+    }
+    else if (m_CompileMs > 0.0f) {
+        ImGui::Text("%s in %.1f ms", m_CompileErrors.empty() ? "Compiled" : "Failed", m_CompileMs);
+    }
+
+    if (!m_CompileErrors.empty()) {
+        ImGui::BeginChild("ShaderErrors", ImVec2(0, 0), true);
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_CompileErrors.c_str());
+        ImGui::EndChild();
     }
 
 }
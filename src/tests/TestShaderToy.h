@@ -5,9 +5,12 @@
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "AssetWatcher.h"
 
 #include "TextEditor.h"
 
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <string>
@@ -32,7 +35,13 @@ namespace test {
 		void OnMouseMove(float x, float y) override;
 		void LoadShaderFiles(const std::string& directory);
 		void LoadShader(const std::string& shaderPath);
-		void ReloadShader();
+		// Writes the editor text to the selected file and compiles it
+		void SaveShader();
+		// Recompiles the selected file when it was changed outside the editor
+		void WatchSelectedShader();
+		// Starts compiling source in the background, m_Shader stays in use until it links
+		void CompileShader(const std::string& source);
+		void PollShader();
 
 	private:
 		std::unique_ptr <VertexArray> m_VAO;
@@ -44,6 +53,11 @@ namespace test {
 		std::string m_SelectedShader;
 		std::string m_ShaderSource;
 		std::unique_ptr <Shader> m_Shader;
+		std::unique_ptr <Shader> m_PendingShader;
+		std::chrono::steady_clock::time_point m_CompileStart;
+		float m_CompileMs = 0.0f;
+		std::string m_CompileErrors;
+		RenderQueue m_Queue;
 
 		glm::mat4 m_Proj, m_View;
 		glm::vec3 m_TranslationA;
@@ -58,5 +72,6 @@ void main() {
     FragColor = vec4(1.0, 0.0, 0.0, 1.0); // Default Red
 })";
 
+		AssetWatcher::Subscription m_ShaderWatch;
 	};
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Renderer.h"
 #include "TestTexture2D.h"
+#include "Profiler.h"
+#include "GLState.h"
 
 #include "imgui.h"
 
@@ -26,9 +28,9 @@ test::TestTexture2D::TestTexture2D()
     };
 
 
-    GLCallV(glEnable(GL_BLEND));
+    GLState::SetCapability(GL_BLEND, true);
     GLCallV(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-    glDisable(GL_DEPTH_TEST); // Disable z-checking for this test (makes the textures draw in the same layer)
+    GLState::SetCapability(GL_DEPTH_TEST, false); // Disable z-checking for this test (makes the textures draw in the same layer)
 
     // Vertex Array object
     m_VAO = std::make_unique<VertexArray>();
@@ -53,6 +55,17 @@ test::TestTexture2D::TestTexture2D()
     m_Texture = std::make_unique<Texture>("res/textures/DVD_video.png");
     
     m_Shader->SetUniform1i("u_Texture", 0);
+
+    // A reloaded shader is a new program, the uniforms set above have to be set again
+    m_Watches.push_back(AssetWatcher::Subscribe(m_Shader->GetFilePath(), [this] {
+        if (!m_Shader->Reload())
+            return false;
+        m_Shader->Bind();
+        m_Shader->SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);
+        m_Shader->SetUniform1i("u_Texture", 0);
+        return true;
+    }));
+    m_Watches.push_back(AssetWatcher::Watch(*m_Texture));
 }
 
 test::TestTexture2D::~TestTexture2D(){
@@ -74,29 +87,21 @@ void test::TestTexture2D::UpdateProjectionMatrix() {
 
 void test::TestTexture2D::OnRender()
 {
+    PROFILE_SCOPE("TestTexture2D::OnRender");
+
 	GLCallV(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
     GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
-    Renderer renderer;
-
-
-    m_Texture->Bind(0);
-
-    {
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), m_TranslationA);
+    // The texture has alpha, so both quads go through the transparent pass
+    m_Queue.SetView(m_View);
+    for (const glm::vec3& translation : { m_TranslationA, m_TranslationB }) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
         glm::mat4 mvp = m_Proj * m_View * model; // Matrix multiplication in reverse order because of column major ordering in memory
-        m_Shader->Bind();
-        m_Shader->SetUniformMat4f("u_MVP", mvp);
-        renderer.Draw(*m_VAO, *m_IBO, *m_Shader);
-    }
-
-    {
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), m_TranslationB);
-        glm::mat4 mvp = m_Proj * m_View * model; // Matrix multiplication in reverse order because of column major ordering in memory
-        m_Shader->Bind();
-        m_Shader->SetUniformMat4f("u_MVP", mvp);
-        renderer.Draw(*m_VAO, *m_IBO, *m_Shader);
+        m_Queue.Submit(RenderQueue::Pass::Transparent, *m_Shader, *m_VAO, *m_IBO, translation)
+            .Uniform("u_MVP", mvp)
+            .Texture(0, m_Texture->GetRendererID());
     }
+    m_Queue.Flush();
 }
 
 void test::TestTexture2D::OnImGuiRender()
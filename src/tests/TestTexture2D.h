@@ -5,8 +5,11 @@
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "AssetWatcher.h"
 
 #include <memory>
+#include <vector>
 
 namespace test {
 
@@ -27,10 +30,12 @@ namespace test {
 		std::unique_ptr <IndexBuffer> m_IBO;
 		std::unique_ptr <Shader> m_Shader;
 		std::unique_ptr <Texture> m_Texture;
+		RenderQueue m_Queue;
 
 		glm::mat4 m_Proj, m_View;
 		glm::vec3 m_TranslationA, m_TranslationB;
 		int m_WindowWidth, m_WindowHeight;
 
+		std::vector<AssetWatcher::Subscription> m_Watches;
 	};
 }
\ No newline at end of file
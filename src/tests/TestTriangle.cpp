@@ -1,5 +1,6 @@
 ﻿#include "Renderer.h"
 #include "TestTriangle.h"
+#include "Profiler.h"
 
 #include <GLFW/glfw3.h>
 
@@ -13,7 +14,7 @@
 test::TestTriangle::TestTriangle()
     :m_Proj(),
     m_View(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f))),
-    m_Spinning(false), m_Translation(0), m_Rotation(0), 
+    m_Spinning(false), m_Translation(0), m_Moving(false), m_Rotation(0),
     m_Scale(1.0f), m_MoveAngle(0.0f), m_MoveRadius(0.5f),
     m_Position(0.0f, 0.0f, 0.0f), m_WindowWidth(0), m_WindowHeight(0)
 {
@@ -65,6 +66,7 @@ test::TestTriangle::TestTriangle()
     // Shaders
     m_Shader = std::make_unique<Shader>("res/shader/FragColor.shader");
     m_Shader->Bind();
+    m_Watches.push_back(AssetWatcher::Watch(*m_Shader));
 }
 
 test::TestTriangle::~TestTriangle() {
@@ -105,12 +107,11 @@ void test::TestTriangle::UpdateProjectionMatrix() {
 
 void test::TestTriangle::OnRender()
 {
+    PROFILE_SCOPE("TestTriangle::OnRender");
+
     GLCallV(glClearColor(0.5f, 0.5f, 0.5f, 1.0f));
     GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT)); // We need to clear both the color buffer and depth buffer
 
-    Renderer renderer;
-
-
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, m_Position);
     model = glm::translate(model, m_Translation);
@@ -120,9 +121,9 @@ void test::TestTriangle::OnRender()
 
     glm::mat4 mvp = m_Proj * m_View * model;
 
-    m_Shader->Bind();
-    m_Shader->SetUniformMat4f("u_MVP", mvp);
-    renderer.Draw(*m_VAO, *m_IBO, *m_Shader);
+    m_Queue.SetView(m_View);
+    m_Queue.Submit(RenderQueue::Pass::Opaque, *m_Shader, *m_VAO, *m_IBO, m_Position).Uniform("u_MVP", mvp);
+    m_Queue.Flush();
 }
 
 void test::TestTriangle::OnImGuiRender()
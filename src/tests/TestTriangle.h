@@ -4,8 +4,11 @@
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
 #include "Texture.h"
+#include "RenderQueue.h"
+#include "AssetWatcher.h"
 
 #include <memory>
+#include <vector>
 
 namespace test {
 
@@ -25,6 +28,7 @@ namespace test {
 		std::unique_ptr <VertexBuffer> m_VBO;
 		std::unique_ptr <IndexBuffer> m_IBO;
 		std::unique_ptr <Shader> m_Shader;
+		RenderQueue m_Queue;
 		std::unique_ptr <Texture> m_Texture;
 
 		glm::mat4 m_Proj, m_View;
@@ -40,5 +44,6 @@ namespace test {
 
 		int m_WindowWidth, m_WindowHeight;
 
+		std::vector<AssetWatcher::Subscription> m_Watches;
 	};
 }
\ No newline at end of file
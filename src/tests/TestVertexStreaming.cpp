@@ -0,0 +1,193 @@
+#include "TestVertexStreaming.h"
+#include "VertexBufferLayout.h"
+#include "Profiler.h"
+#include "GLState.h"
+#include "imgui.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace test {
+
+    static constexpr float kExtent = 10.0f;     // Half the side of the surface
+    static constexpr float kAmplitude = 0.6f;
+    static constexpr float kFrequency = 1.3f;
+
+    static const char* GetMethodName(TestVertexStreaming::Method method) {
+        switch (method) {
+        case TestVertexStreaming::Method::PersistentRing: return "Persistent ring";
+        case TestVertexStreaming::Method::Orphaning:      return "Orphaning + map";
+        case TestVertexStreaming::Method::BufferData:     return "glBufferData";
+        default:                                          return "Unknown";
+        }
+    }
+
+    TestVertexStreaming::TestVertexStreaming(Method method)
+        : m_Method(method), m_GridSize(256), m_WriteInPlace(false), m_Time(0.0f),
+        m_Proj(1.0f), m_View(1.0f), m_WindowWidth(1280), m_WindowHeight(720),
+        m_UpdateMs(0.0), m_AverageUpdateMs(0.0)
+    {
+        m_Shader = std::make_unique<Shader>("res/shader/model_shader.shader");
+        m_Watches.push_back(AssetWatcher::Watch(*m_Shader));
+
+        GLState::SetCapability(GL_DEPTH_TEST, true);
+        GLCallV(glDepthFunc(GL_LESS));
+
+        m_View = glm::lookAt(glm::vec3(0.0f, 9.0f, 16.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        UpdateProjectionMatrix();
+        CreateBuffers();
+    }
+
+    TestVertexStreaming::~TestVertexStreaming() {
+    }
+
+    void TestVertexStreaming::CreateBuffers() {
+        const unsigned int vertexCount = static_cast<unsigned int>(m_GridSize * m_GridSize);
+        m_Vertices.resize(vertexCount);
+
+        // The VAO goes first so the old attribute pointers die with it
+        m_VAO.reset();
+        m_Buffer.reset();
+        m_Dynamic.reset();
+        m_VAO = std::make_unique<VertexArray>();
+
+        VertexBufferLayout layout;
+        layout.Push<float>(3); // Position
+        layout.Push<float>(3); // Normal
+        layout.Push<float>(2); // TexCoords
+
+        if (m_Method == Method::BufferData) {
+            m_Buffer = std::make_unique<VertexBuffer>(nullptr, vertexCount * static_cast<unsigned int>(sizeof(Vertex)));
+            m_VAO->AddBuffer(*m_Buffer, layout);
+        }
+        else {
+            const auto mode = m_Method == Method::PersistentRing ? DynamicVertexBuffer::Mode::PersistentRing : DynamicVertexBuffer::Mode::Orphaning;
+            m_Dynamic = std::make_unique<DynamicVertexBuffer>(vertexCount, static_cast<unsigned int>(sizeof(Vertex)), mode);
+            m_VAO->AddBuffer(*m_Dynamic, layout);
+        }
+
+        // Two triangles per grid cell, the topology never changes
+        std::vector<unsigned int> indices;
+        indices.reserve(static_cast<size_t>(m_GridSize - 1) * (m_GridSize - 1) * 6);
+        for (int z = 0; z < m_GridSize - 1; z++) {
+            for (int x = 0; x < m_GridSize - 1; x++) {
+                const unsigned int i = static_cast<unsigned int>(z * m_GridSize + x);
+                const unsigned int below = i + static_cast<unsigned int>(m_GridSize);
+                indices.insert(indices.end(), { i, below, i + 1, i + 1, below, below + 1 });
+            }
+        }
+        m_IBO = std::make_unique<IndexBuffer>(indices.data(), static_cast<unsigned int>(indices.size()));
+        m_AverageUpdateMs = 0.0;
+    }
+
+    void TestVertexStreaming::GenerateSurface(Vertex* vertices) const {
+        const float step = 2.0f * kExtent / (m_GridSize - 1);
+        for (int z = 0; z < m_GridSize; z++) {
+            const float pz = z * step - kExtent;
+            const float cz = std::cos(kFrequency * pz + m_Time * 0.7f);
+            const float sz = std::sin(kFrequency * pz + m_Time * 0.7f);
+            Vertex* row = vertices + static_cast<size_t>(z) * m_GridSize;
+            for (int x = 0; x < m_GridSize; x++) {
+                const float px = x * step - kExtent;
+                const float sx = std::sin(kFrequency * px + m_Time);
+                const float cx = std::cos(kFrequency * px + m_Time);
+
+                // y = A sin(kx + t) cos(kz + 0.7t), the normal follows from its partial derivatives
+                Vertex& vertex = row[x];
+                vertex.Position = glm::vec3(px, kAmplitude * sx * cz, pz);
+                vertex.Normal = glm::normalize(glm::vec3(-kAmplitude * kFrequency * cx * cz, 1.0f, kAmplitude * kFrequency * sx * sz));
+                vertex.TexCoords = glm::vec2(static_cast<float>(x) / (m_GridSize - 1), static_cast<float>(z) / (m_GridSize - 1));
+            }
+        }
+    }
+
+    void TestVertexStreaming::UpdateProjectionMatrix() {
+        float aspectRatio = static_cast<float>(m_WindowWidth) / std::max(m_WindowHeight, 1);
+        m_Proj = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 100.0f);
+    }
+
+    void TestVertexStreaming::OnUpdate(float deltaTime) {
+        m_Time += deltaTime;
+    }
+
+    void TestVertexStreaming::OnRender() {
+        PROFILE_SCOPE("TestVertexStreaming::OnRender");
+
+        GLCallV(glClearColor(0.1f, 0.1f, 0.12f, 1.0f));
+        GLCallV(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+
+        auto start = std::chrono::steady_clock::now();
+        const unsigned int vertexCount = static_cast<unsigned int>(m_Vertices.size());
+        int baseVertex = 0;
+        if (m_Dynamic) {
+            if (m_WriteInPlace) {
+                if (Vertex* destination = static_cast<Vertex*>(m_Dynamic->BeginWrite())) {
+                    GenerateSurface(destination);
+                    m_Dynamic->EndWrite(vertexCount);
+                }
+                else {
+                    m_Dynamic->EndWrite(0);
+                }
+            }
+            else {
+                GenerateSurface(m_Vertices.data());
+                m_Dynamic->Write(m_Vertices.data(), vertexCount);
+            }
+            baseVertex = m_Dynamic->GetBaseVertex();
+        }
+        else {
+            GenerateSurface(m_Vertices.data());
+            m_Buffer->SetData(m_Vertices.data(), vertexCount * static_cast<unsigned int>(sizeof(Vertex)));
+        }
+        m_UpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_AverageUpdateMs = m_AverageUpdateMs == 0.0 ? m_UpdateMs : m_AverageUpdateMs * 0.95 + m_UpdateMs * 0.05;
+
+        m_Shader->Bind();
+        m_Shader->SetUniform3f("objectColor", 0.3f, 0.55f, 0.8f);
+
+        FrameUniforms frame;
+        frame.view = m_View;
+        frame.projection = m_Proj;
+        frame.lightPosition = glm::vec4(5.0f, 10.0f, 5.0f, 1.0f);
+        frame.lightColor = glm::vec4(1.0f);
+        m_Queue.SetFrame(frame);
+        m_Queue.Submit(RenderQueue::Pass::Opaque, *m_Shader, *m_VAO, *m_IBO, glm::vec3(0.0f))
+            .Object(ObjectUniforms())
+            .BaseVertex(baseVertex);
+        m_Queue.Flush();
+    }
+
+    void TestVertexStreaming::OnImGuiRender() {
+        ImGui::Text("Streams %zu vertices (%.1f MB) per frame", m_Vertices.size(), m_Vertices.size() * sizeof(Vertex) / (1024.0 * 1024.0));
+
+        int method = static_cast<int>(m_Method);
+        const char* methods[] = { GetMethodName(Method::PersistentRing), GetMethodName(Method::Orphaning), GetMethodName(Method::BufferData) };
+        bool rebuild = ImGui::Combo("Upload", &method, methods, 3);
+        rebuild |= ImGui::SliderInt("Grid size", &m_GridSize, 16, 1024);
+        if (rebuild) {
+            m_Method = static_cast<Method>(method);
+            CreateBuffers();
+        }
+
+        if (m_Dynamic) {
+            ImGui::Checkbox("Generate in place", &m_WriteInPlace);
+            ImGui::Text("Buffer: %s, fence waits: %llu", DynamicVertexBuffer::GetModeName(m_Dynamic->GetMode()),
+                (unsigned long long)m_Dynamic->GetFenceWaits());
+        }
+
+        ImGui::Text("Generate + upload: %.3f ms (average %.3f ms)", m_UpdateMs, m_AverageUpdateMs);
+        ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    }
+
+    void TestVertexStreaming::OnWindowResize(int width, int height) {
+        m_WindowWidth = width;
+        m_WindowHeight = height;
+        GLCallV(glViewport(0, 0, width, height));
+        UpdateProjectionMatrix();
+    }
+
+}
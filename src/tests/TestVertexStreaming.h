@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Test.h"
+#include "Renderer.h"
+#include "RenderQueue.h"
+#include "DynamicVertexBuffer.h"
+#include "Vertex.h"
+#include "AssetWatcher.h"
+
+#include <memory>
+#include <vector>
+
+namespace test {
+
+    // Animated height field whose vertices are regenerated on the CPU every frame, streamed with one of
+    // the upload methods below to compare their cost. Registered once per method for the benchmark.
+    class TestVertexStreaming : public Test {
+    public:
+        enum class Method {
+            PersistentRing, // DynamicVertexBuffer, persistent mapped ring
+            Orphaning,      // DynamicVertexBuffer, orphaning plus glMapBufferRange
+            BufferData,     // VertexBuffer::SetData, a full glBufferData every frame
+        };
+
+        TestVertexStreaming(Method method = Method::PersistentRing);
+        ~TestVertexStreaming();
+
+        void OnUpdate(float deltaTime) override;
+        void OnRender() override;
+        void OnImGuiRender() override;
+        void OnWindowResize(int width, int height) override;
+
+    private:
+        std::unique_ptr<VertexArray> m_VAO;
+        std::unique_ptr<VertexBuffer> m_Buffer;         // BufferData
+        std::unique_ptr<DynamicVertexBuffer> m_Dynamic; // PersistentRing and Orphaning
+        std::unique_ptr<IndexBuffer> m_IBO;
+        std::unique_ptr<Shader> m_Shader;
+        RenderQueue m_Queue;
+        std::vector<Vertex> m_Vertices;
+
+        Method m_Method;
+        int m_GridSize;         // Vertices per side
+        bool m_WriteInPlace;    // Generate straight into the mapped memory instead of copying
+        float m_Time;
+
+        glm::mat4 m_Proj, m_View;
+        int m_WindowWidth, m_WindowHeight;
+
+        double m_UpdateMs;      // CPU time to generate and upload the vertices
+        double m_AverageUpdateMs;
+
+        std::vector<AssetWatcher::Subscription> m_Watches;
+
+        void CreateBuffers();
+        void GenerateSurface(Vertex* vertices) const;
+        void UpdateProjectionMatrix();
+    };
+
+}